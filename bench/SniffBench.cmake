@@ -0,0 +1,6 @@
+find_package(benchmark REQUIRED)
+
+add_executable(
+  sniff_bench ${CMAKE_CURRENT_LIST_DIR}/src/kernels.cc
+              ${CMAKE_CURRENT_LIST_DIR}/src/synthetic.cc)
+target_link_libraries(sniff_bench PRIVATE benchmark::benchmark_main sniff_lib)
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// 3rd party
+#include "benchmark/benchmark.h"
+#include "biosoup/nucleic_acid.hpp"
+
+// sniff
+#include "sniff/algo.h"
+#include "sniff/index.h"
+#include "sniff/map.h"
+#include "sniff/match.h"
+#include "sniff/minimize.h"
+#include "synthetic.h"
+
+std::atomic<std::uint32_t> biosoup::NucleicAcid::num_objects = 0;
+
+static constexpr auto kMinimizeCfg =
+    sniff::MinimizeConfig{.kmer_len = 15, .window_len = 5};
+
+// the chaining parameters used by the pair search
+static constexpr auto kMapCfg = sniff::MapConfig{
+    .min_chain_length = 4, .max_chain_gap_length = 800, .kmer_len = 15};
+
+// error rates in per mille, since benchmark arguments are integers
+static auto const kErrorRates = std::vector<std::int64_t>{10, 50, 150};
+static auto const kRepeatFractions = std::vector<std::int64_t>{0, 30};
+
+static auto SyntheticConfigOf(benchmark::State const& state,
+                              std::uint32_t read_len)
+    -> sniff::bench::SyntheticConfig {
+  return sniff::bench::SyntheticConfig{
+      .read_len = read_len,
+      .error_rate = static_cast<double>(state.range(0)) / 1'000.,
+      .repeat_fraction = static_cast<double>(state.range(1)) / 100.};
+}
+
+static auto Rate(double value) -> benchmark::Counter {
+  return benchmark::Counter(value, benchmark::Counter::kIsRate);
+}
+
+static auto MakeRead(std::uint32_t id, std::string const& data)
+    -> std::unique_ptr<biosoup::NucleicAcid> {
+  auto dst = std::make_unique<biosoup::NucleicAcid>("r" + std::to_string(id),
+                                                    data);
+  dst->id = id;
+  return dst;
+}
+
+// Reverse complement minimizers of the partners of synthetic pairs,
+// in the form the pair search indexes them.
+static auto MakeTargets(std::span<sniff::bench::ReadPair const> pairs)
+    -> std::vector<sniff::Target> {
+  auto dst = std::vector<sniff::Target>();
+  for (std::uint32_t read_id = 0; read_id < pairs.size(); ++read_id) {
+    auto const partner = MakeRead(read_id, pairs[read_id].reverse_complement);
+    for (auto const kmer :
+         sniff::Minimize(kMinimizeCfg, *partner).reverse_complement) {
+      dst.push_back(sniff::Target{.read_id = read_id, .kmer = kmer});
+    }
+  }
+
+  return dst;
+}
+
+static auto BM_Minimize(benchmark::State& state) -> void {
+  auto const read_len = static_cast<std::uint32_t>(state.range(0));
+  auto const cfg = sniff::MinimizeConfig{.kmer_len = kMinimizeCfg.kmer_len,
+                                         .window_len = kMinimizeCfg.window_len,
+                                         .canonical = state.range(1) != 0};
+  auto const read = MakeRead(
+      0, sniff::bench::GenerateGenome({.read_len = read_len}, read_len));
+
+  auto n_minimizers = std::size_t(0);
+  for (auto _ : state) {
+    auto const minimizers = sniff::Minimize(cfg, *read);
+    n_minimizers += minimizers.forward.size();
+    benchmark::DoNotOptimize(minimizers);
+  }
+
+  state.counters["bases/s"] =
+      Rate(static_cast<double>(state.iterations()) * read_len);
+  state.counters["minimizers/s"] = Rate(n_minimizers);
+}
+
+BENCHMARK(BM_Minimize)
+    ->ArgNames({"read_len", "canonical"})
+    ->ArgsProduct({{1'000, 10'000, 100'000}, {0, 1}});
+
+// Seeds both reads of synthetic pairs under each scheme; density is seeds per
+// base, and sensitivity the share of pairs whose seeds chain into an overlap.
+static auto BM_Seeding(benchmark::State& state) -> void {
+  auto const cfg = sniff::MinimizeConfig{
+      .kmer_len = kMinimizeCfg.kmer_len,
+      .window_len = kMinimizeCfg.window_len,
+      .seeding = static_cast<sniff::Seeding>(state.range(0))};
+  auto const pairs = sniff::bench::GenerateReadPairs(
+      {.read_len = 10'000,
+       .error_rate = static_cast<double>(state.range(1)) / 1'000.},
+      50);
+
+  auto reads = std::vector<std::unique_ptr<biosoup::NucleicAcid>>();
+  auto n_bases = std::size_t(0);
+  auto n_hits = std::size_t(0);
+  auto n_found = std::size_t(0);
+  auto buffers = sniff::MapBuffers();
+  auto chains = std::vector<sniff::Overlap>();
+  for (auto const& pair : pairs) {
+    auto const* read =
+        reads.emplace_back(MakeRead(reads.size(), pair.read)).get();
+    auto const* partner =
+        reads.emplace_back(MakeRead(reads.size(), pair.reverse_complement))
+            .get();
+    n_bases += pair.read.size() + pair.reverse_complement.size();
+
+    auto const matches =
+        sniff::MakeMatches(sniff::Minimize(cfg, *read).forward,
+                           sniff::Minimize(cfg, *partner).reverse_complement);
+    chains.clear();
+    sniff::Map(kMapCfg, matches, &buffers, &chains);
+    n_hits += matches.size();
+    n_found += !chains.empty();
+  }
+
+  auto n_seeds = std::size_t(0);
+  for (auto _ : state) {
+    for (auto const& read : reads) {
+      auto const seeds = sniff::Minimize(cfg, *read);
+      n_seeds += seeds.forward.size();
+      benchmark::DoNotOptimize(seeds);
+    }
+  }
+
+  state.counters["bases/s"] =
+      Rate(static_cast<double>(state.iterations()) * n_bases);
+  state.counters["density"] = benchmark::Counter(
+      static_cast<double>(n_seeds) /
+      (static_cast<double>(state.iterations()) * n_bases));
+  state.counters["hits/pair"] = benchmark::Counter(
+      static_cast<double>(n_hits) / static_cast<double>(pairs.size()));
+  state.counters["sensitivity"] = benchmark::Counter(
+      static_cast<double>(n_found) / static_cast<double>(pairs.size()));
+}
+
+BENCHMARK(BM_Seeding)
+    ->ArgNames({"seeding", "error_permille"})
+    ->ArgsProduct({{static_cast<std::int64_t>(sniff::Seeding::kMinimizer),
+                    static_cast<std::int64_t>(sniff::Seeding::kOpenSyncmer),
+                    static_cast<std::int64_t>(sniff::Seeding::kClosedSyncmer),
+                    static_cast<std::int64_t>(sniff::Seeding::kRandstrobe)},
+                   kErrorRates})
+    ->Unit(benchmark::kMillisecond);
+
+static auto BM_CreateIndex(benchmark::State& state) -> void {
+  auto const pairs = sniff::bench::GenerateReadPairs(
+      {.read_len = 10'000}, static_cast<std::uint32_t>(state.range(0)));
+  auto const targets = MakeTargets(pairs);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto batch_targets = targets;
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(sniff::CreateIndex(std::move(batch_targets)));
+  }
+
+  state.counters["targets/s"] =
+      Rate(static_cast<double>(state.iterations()) * targets.size());
+}
+
+BENCHMARK(BM_CreateIndex)
+    ->ArgNames({"n_reads"})
+    ->Arg(100)
+    ->Arg(1'000)
+    ->Unit(benchmark::kMillisecond);
+
+// Looks up every forward minimizer of the reads in the index of their
+// partners; hits are the postings returned.
+static auto BM_FindTargets(benchmark::State& state) -> void {
+  auto const cfg = SyntheticConfigOf(state, 10'000);
+  auto const pairs = sniff::bench::GenerateReadPairs(cfg, 200);
+  auto const index = sniff::CreateIndex(MakeTargets(pairs));
+
+  auto queries = std::vector<sniff::KMer>();
+  auto n_bases = std::size_t(0);
+  for (std::uint32_t read_id = 0; read_id < pairs.size(); ++read_id) {
+    auto const read = MakeRead(read_id, pairs[read_id].read);
+    auto const minimizers = sniff::Minimize(kMinimizeCfg, *read).forward;
+    queries.insert(queries.end(), minimizers.begin(), minimizers.end());
+    n_bases += pairs[read_id].read.size();
+  }
+
+  auto n_hits = std::size_t(0);
+  for (auto _ : state) {
+    for (auto const& kmer : queries) {
+      n_hits += sniff::FindTargets(index, kmer.value).size();
+    }
+  }
+
+  state.counters["bases/s"] =
+      Rate(static_cast<double>(state.iterations()) * n_bases);
+  state.counters["hits/s"] = Rate(n_hits);
+}
+
+BENCHMARK(BM_FindTargets)
+    ->ArgNames({"error_permille", "repeat_percent"})
+    ->ArgsProduct({kErrorRates, kRepeatFractions})
+    ->Unit(benchmark::kMillisecond);
+
+// Matches of one read pair, query forward minimizers against target reverse
+// complement ones, as the pair search sees them.
+static auto MakePairMatches(sniff::bench::ReadPair const& pair)
+    -> std::vector<sniff::Match> {
+  auto const read = MakeRead(0, pair.read);
+  auto const partner = MakeRead(1, pair.reverse_complement);
+  return sniff::MakeMatches(
+      sniff::Minimize(kMinimizeCfg, *read).forward,
+      sniff::Minimize(kMinimizeCfg, *partner).reverse_complement);
+}
+
+static auto BM_MakeMatches(benchmark::State& state) -> void {
+  auto const pair = sniff::bench::GenerateReadPairs(
+      SyntheticConfigOf(state, 10'000), 1)[0];
+  auto const read = MakeRead(0, pair.read);
+  auto const partner = MakeRead(1, pair.reverse_complement);
+  auto const query_sketch = sniff::Minimize(kMinimizeCfg, *read).forward;
+  auto const target_sketch =
+      sniff::Minimize(kMinimizeCfg, *partner).reverse_complement;
+
+  auto n_hits = std::size_t(0);
+  for (auto _ : state) {
+    auto const matches = sniff::MakeMatches(query_sketch, target_sketch);
+    n_hits += matches.size();
+    benchmark::DoNotOptimize(matches);
+  }
+
+  state.counters["hits/s"] = Rate(n_hits);
+}
+
+BENCHMARK(BM_MakeMatches)
+    ->ArgNames({"error_permille", "repeat_percent"})
+    ->ArgsProduct({kErrorRates, kRepeatFractions});
+
+static auto BM_Map(benchmark::State& state) -> void {
+  auto const read_len = static_cast<std::uint32_t>(state.range(2));
+  auto const matches = MakePairMatches(
+      sniff::bench::GenerateReadPairs(SyntheticConfigOf(state, read_len),
+                                      1)[0]);
+
+  auto buffers = sniff::MapBuffers();
+  auto chains = std::vector<sniff::Overlap>();
+  auto n_chains = std::size_t(0);
+  for (auto _ : state) {
+    chains.clear();
+    sniff::Map(kMapCfg, matches, &buffers, &chains);
+    n_chains += chains.size();
+  }
+
+  state.counters["hits/s"] =
+      Rate(static_cast<double>(state.iterations()) * matches.size());
+  state.counters["chains/s"] = Rate(n_chains);
+}
+
+BENCHMARK(BM_Map)
+    ->ArgNames({"error_permille", "repeat_percent", "read_len"})
+    ->ArgsProduct({kErrorRates, kRepeatFractions, {1'000, 10'000, 50'000}});
+
+// Whole pair search, from loaded reads to scored best pairs.
+static auto BM_FindReverseComplementPairs(benchmark::State& state) -> void {
+  auto const pairs =
+      sniff::bench::GenerateReadPairs(SyntheticConfigOf(state, 5'000), 200);
+  auto const cfg = sniff::Config{.alpha_p = 0.10,
+                                 .beta_p = 0.90,
+                                 .filter_freq = 0.0002,
+                                 .kmer_len = kMinimizeCfg.kmer_len,
+                                 .window_len = kMinimizeCfg.window_len,
+                                 .canonical = false};
+
+  auto n_bases = std::size_t(0);
+  auto n_pairs = std::size_t(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto reads = sniff::ReadStore();
+    for (auto const& pair : pairs) {
+      reads.Append("r" + std::to_string(reads.size()), pair.read);
+      reads.Append("r" + std::to_string(reads.size()),
+                   pair.reverse_complement);
+      n_bases += pair.read.size() + pair.reverse_complement.size();
+    }
+    state.ResumeTiming();
+
+    n_pairs += sniff::FindReverseComplementPairs(cfg, std::move(reads))
+                   .overlaps.size();
+  }
+
+  state.counters["bases/s"] = Rate(n_bases);
+  state.counters["pairs"] = benchmark::Counter(
+      n_pairs, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_FindReverseComplementPairs)
+    ->ArgNames({"error_permille", "repeat_percent"})
+    ->ArgsProduct({kErrorRates, kRepeatFractions})
+    ->Unit(benchmark::kMillisecond);
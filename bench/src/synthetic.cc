@@ -0,0 +1,99 @@
+#include "synthetic.h"
+
+#include <algorithm>
+
+static constexpr auto kBases = std::string_view("ACGT");
+
+// repeat elements are a few kilobases long, like transposons, and their
+// copies differ by a few percent
+static constexpr auto kNumRepeats = 8U;
+static constexpr auto kRepeatLen = 3'000U;
+static constexpr auto kRepeatDivergence = 0.02;
+
+static auto RandomSequence(std::uint64_t len, std::mt19937_64& rng)
+    -> std::string {
+  auto dst = std::string(len, 'A');
+  for (auto& base : dst) {
+    base = kBases[rng() & 3U];
+  }
+
+  return dst;
+}
+
+namespace sniff::bench {
+
+auto GenerateGenome(SyntheticConfig const& cfg, std::uint64_t genome_len)
+    -> std::string {
+  auto rng = std::mt19937_64(cfg.seed);
+  auto repeats = std::vector<std::string>();
+  for (std::uint32_t i = 0; i < kNumRepeats; ++i) {
+    repeats.push_back(RandomSequence(kRepeatLen, rng));
+  }
+
+  auto const repeat_cfg = SyntheticConfig{.error_rate = kRepeatDivergence};
+  auto is_repeat = std::bernoulli_distribution(cfg.repeat_fraction);
+
+  auto dst = std::string();
+  dst.reserve(genome_len + kRepeatLen);
+  while (dst.size() < genome_len) {
+    dst += is_repeat(rng)
+               ? AddErrors(repeat_cfg, repeats[rng() % kNumRepeats], rng)
+               : RandomSequence(kRepeatLen, rng);
+  }
+  dst.resize(genome_len);
+
+  return dst;
+}
+
+auto ReverseComplement(std::string const& sequence) -> std::string {
+  auto dst = std::string(sequence.rbegin(), sequence.rend());
+  for (auto& base : dst) {
+    base = kBases[3 - kBases.find(base)];
+  }
+
+  return dst;
+}
+
+auto AddErrors(SyntheticConfig const& cfg, std::string const& sequence,
+               std::mt19937_64& rng) -> std::string {
+  auto error = std::uniform_real_distribution<double>(0., 1.);
+  auto dst = std::string();
+  dst.reserve(sequence.size() + sequence.size() / 8);
+
+  for (auto const base : sequence) {
+    auto const p = error(rng);
+    if (p >= cfg.error_rate) {
+      dst.push_back(base);
+    } else if (p < cfg.error_rate / 3.) {
+      dst.push_back(kBases[(kBases.find(base) + 1 + rng() % 3) & 3U]);
+    } else if (p < cfg.error_rate * 2. / 3.) {
+      dst.push_back(kBases[rng() & 3U]);
+      dst.push_back(base);
+    }
+  }
+
+  return dst;
+}
+
+auto GenerateReadPairs(SyntheticConfig const& cfg, std::uint32_t n_pairs)
+    -> std::vector<ReadPair> {
+  // reads are drawn from a genome ten times as long as all of them together
+  auto const genome =
+      GenerateGenome(cfg, std::uint64_t(10) * n_pairs * cfg.read_len);
+
+  auto rng = std::mt19937_64(cfg.seed + 1);
+  auto dst = std::vector<ReadPair>();
+  dst.reserve(n_pairs);
+  for (std::uint32_t i = 0; i < n_pairs; ++i) {
+    auto const offset = rng() % (genome.size() - cfg.read_len + 1);
+    auto const fragment = genome.substr(offset, cfg.read_len);
+    dst.push_back(ReadPair{
+        .read = AddErrors(cfg, fragment, rng),
+        .reverse_complement =
+            AddErrors(cfg, ReverseComplement(fragment), rng)});
+  }
+
+  return dst;
+}
+
+}  // namespace sniff::bench
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sniff::bench {
+
+// Shape of a synthetic data set; every generator is seeded so the same config
+// always gives the same sequences.
+struct SyntheticConfig {
+  std::uint32_t read_len = 10'000;
+  // probability of an error per base, split evenly between substitutions,
+  // insertions and deletions
+  double error_rate = 0.05;
+  // fraction of the genome made of copies of a few repeat elements
+  double repeat_fraction = 0.0;
+  std::uint64_t seed = 42;
+};
+
+auto GenerateGenome(SyntheticConfig const& cfg, std::uint64_t genome_len)
+    -> std::string;
+
+auto ReverseComplement(std::string const& sequence) -> std::string;
+
+// Copies sequence with errors at the configured rate.
+auto AddErrors(SyntheticConfig const& cfg, std::string const& sequence,
+               std::mt19937_64& rng) -> std::string;
+
+// A read and an independently sequenced reverse complement of it, the pair
+// sniff is meant to find.
+struct ReadPair {
+  std::string read;
+  std::string reverse_complement;
+};
+
+auto GenerateReadPairs(SyntheticConfig const& cfg, std::uint32_t n_pairs)
+    -> std::vector<ReadPair>;
+
+}  // namespace sniff::bench
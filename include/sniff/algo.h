@@ -1,20 +1,90 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "sniff/config.h"
+#include "sniff/frequency.h"
 #include "sniff/overlap.h"
-
-namespace biosoup {
-class NucleicAcid;
-}
+#include "sniff/read_store.h"
+#include "sniff/shard.h"
+#include "sniff/state.h"
 
 namespace sniff {
 
-auto FindReverseComplementPairs(
-    Config const& cfg, std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads)
-    -> std::vector<OverlapNamed>;
+class Metrics;
+
+// Reads whose k-mers were counted while they were loaded, so that the search
+// does not go over all of them once more before it builds the first index.
+// The counts are not finished yet.
+struct CountedReads {
+  ReadStore reads;
+  std::unique_ptr<FrequentKMers> frequent;
+};
+
+// Loads the reads at path, counting the forward seeds cfg selects.
+auto LoadCountedReads(Config const& cfg, std::filesystem::path const& path,
+                      Metrics* metrics = nullptr) -> CountedReads;
+
+// Counts are sized to take in the ones state keeps as well.
+auto LoadCountedReads(Config const& cfg, std::filesystem::path const& path,
+                      RunState const& state, Metrics* metrics = nullptr)
+    -> CountedReads;
+
+// Stages, counters and batches of the search are recorded into metrics when it
+// is not null.
+auto FindReverseComplementPairs(Config const& cfg, CountedReads reads,
+                                Metrics* metrics = nullptr) -> NamedOverlaps;
+
+// Counts the k-mers of reads in a pass of their own first.
+auto FindReverseComplementPairs(Config const& cfg, ReadStore reads,
+                                Metrics* metrics = nullptr) -> NamedOverlaps;
+
+// Streaming variant; reads are located in a first pass over the input and only
+// the ones needed by the current batch are kept in memory.
+auto FindReverseComplementPairs(Config const& cfg,
+                                std::filesystem::path const& reads_path,
+                                Metrics* metrics = nullptr) -> NamedOverlaps;
+
+// Streaming variant which keeps the sketches and batch indexes of the input in
+// cache_path. The cache is built on the first run and memory mapped by later
+// runs with the same input, k, w, strand mode, seeding and frequent k-mer
+// filter, which skip loading, counting and minimizing the reads.
+auto FindReverseComplementPairs(Config const& cfg,
+                                std::filesystem::path const& reads_path,
+                                std::filesystem::path const& cache_path,
+                                Metrics* metrics = nullptr) -> NamedOverlaps;
+
+// Incremental variant: adds reads to state, which holds the reads of earlier
+// runs, and returns the pairs of all reads in it. Only the new reads are
+// indexed, in length windows, and each window is queried by the earlier and
+// new reads whose lengths can pair up with it, so pairs of two earlier reads
+// are not mapped again. The counts of the new reads are added to the ones
+// state keeps; the k-mers of earlier reads are only counted again when the
+// counts outgrow the size they were kept at. Names point into state and stay
+// valid until it changes.
+auto FindReverseComplementPairs(Config const& cfg, CountedReads reads,
+                                std::shared_ptr<RunState> state,
+                                Metrics* metrics = nullptr) -> NamedOverlaps;
+
+auto FindReverseComplementPairs(Config const& cfg, ReadStore reads,
+                                std::shared_ptr<RunState> state,
+                                Metrics* metrics = nullptr) -> NamedOverlaps;
+
+// Sharded run which maps only the length windows of shard cfg.shard_index out
+// of cfg.n_shards; MergeShards combines the shards of a run into the pairs a
+// single run finds.
+auto FindShardCandidates(Config const& cfg, CountedReads reads,
+                         Metrics* metrics = nullptr) -> ShardCandidates;
+
+auto FindShardCandidates(Config const& cfg, ReadStore reads,
+                         Metrics* metrics = nullptr) -> ShardCandidates;
+
+// Streaming variant; only the reads of the shard's batches are loaded.
+auto FindShardCandidates(Config const& cfg,
+                         std::filesystem::path const& reads_path,
+                         Metrics* metrics = nullptr) -> ShardCandidates;
 
 }  // namespace sniff
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "sniff/overlap.h"
+
+namespace sniff {
+
+// Best overlap score and partner of every read, shared by all mapping
+// threads. Each read holds one packed 64 bit word (float score bits above
+// the partner id) raised with a compare-and-swap max, so updates never lock
+// and ties go to the larger partner id.
+class BestPairs {
+ public:
+  explicit BestPairs(std::size_t n_reads) : best_(n_reads) {}
+
+  // Raises the best overlap of both reads of ovlp to ovlp if it scores
+  // higher; returns true if ovlp became the best overlap of both.
+  auto Update(Overlap const& ovlp) -> bool;
+
+  // Whether ovlp is still the best overlap of both of its reads.
+  auto IsBest(Overlap const& ovlp) const -> bool;
+
+  // Whether ovlp is still the best overlap of at least one of its reads.
+  auto IsBestOfEither(Overlap const& ovlp) const -> bool;
+
+ private:
+  std::vector<std::atomic<std::uint64_t>> best_;
+};
+
+}  // namespace sniff
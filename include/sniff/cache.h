@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "sniff/frequency.h"
+#include "sniff/index.h"
+#include "sniff/kmer.h"
+#include "sniff/minimize.h"
+
+namespace sniff {
+
+// What a cache was built from; a cache is only used by runs with an equal key.
+struct CacheKey {
+  std::uint32_t kmer_len;
+  std::uint32_t window_len;
+  bool canonical;
+  Seeding seeding = Seeding::kMinimizer;
+  std::uint32_t syncmer_len = 9;
+  // cached indexes leave out the k-mers this frequency makes frequent
+  double filter_freq = 0.0002;
+
+  // size and modification time of the input
+  std::uint64_t input_size;
+  std::int64_t input_mtime;
+
+  friend auto operator==(CacheKey const&, CacheKey const&) -> bool = default;
+};
+
+auto CreateCacheKey(MinimizeConfig const& cfg, double filter_freq,
+                    std::filesystem::path const& input_path) -> CacheKey;
+
+struct MappedFile;
+
+// Where the minimizers of one read are stored; the reverse complement ones
+// follow the forward ones.
+struct CachedMinimizers {
+  std::uint64_t offset;
+  std::uint32_t n_forward;
+  std::uint32_t n_reverse_complement;
+};
+
+// Where the index of one batch is stored.
+struct CachedIndex {
+  std::uint32_t first;
+  std::uint32_t last;
+  std::uint32_t bucket_bits;
+  std::uint32_t padding;
+
+  std::uint64_t buckets_offset;
+  std::uint64_t n_buckets;
+  std::uint64_t entries_offset;
+  std::uint64_t n_entries;
+  std::uint64_t targets_offset;
+  std::uint64_t n_targets;
+};
+
+// Read only view of a cache file written by SketchCacheWriter. The file is
+// mapped as a whole and every accessor but Frequent points into the mapping,
+// so only the frequent k-mer counts are copied when it is opened. Reads are
+// in length sorted order; the file is in host byte order and not meant to
+// move between machines.
+//
+// Layout: a fixed header, then the read lengths, names, frequent k-mer
+// counts, per read minimizers and batch indexes in the order they were
+// written, and a table of contents at the end which locates all of them.
+class SketchCache {
+ public:
+  // Returns nullopt if the file does not exist, is not a cache of this
+  // version or was built for another key.
+  static auto Open(std::filesystem::path const& path, CacheKey const& key)
+      -> std::optional<SketchCache>;
+
+  auto size() const -> std::size_t { return lengths_.size(); }
+
+  auto Lengths() const -> std::span<std::uint32_t const> { return lengths_; }
+
+  auto Name(std::uint32_t read_id) const -> std::string_view;
+
+  // Minimizers are available for reads with ids lower than NumSketched().
+  auto NumSketched() const -> std::uint32_t { return n_sketched_; }
+
+  auto Forward(std::uint32_t read_id) const -> std::span<KMer const>;
+
+  auto ReverseComplement(std::uint32_t read_id) const
+      -> std::span<KMer const>;
+
+  // Reverse complement index over reads with ids in [first, last), if a batch
+  // with that range was cached. The index points into the mapping and keeps
+  // it alive.
+  auto FindIndex(std::uint32_t first, std::uint32_t last) const
+      -> std::optional<Index>;
+
+  // Finished counts of the k-mers of all reads.
+  auto Frequent() const -> FrequentKMers const& { return *frequent_; }
+
+ private:
+  SketchCache() = default;
+
+  std::shared_ptr<MappedFile const> file_;
+
+  std::span<std::uint32_t const> lengths_;
+  std::span<std::uint64_t const> name_offsets_;
+  std::string_view names_;
+
+  std::uint32_t n_sketched_ = 0;
+  std::span<CachedMinimizers const> minimizers_;
+  std::span<CachedIndex const> indexes_;
+
+  std::shared_ptr<FrequentKMers const> frequent_;
+};
+
+// Writes a cache file; reads have to be written first, followed by their
+// minimizers in consecutive id ranges and the batch indexes built from them.
+// The frequent k-mer counts have to be written before Finish.
+// The file is written next to path and only moved there by Finish, so a
+// failed run never leaves a partial cache behind.
+class SketchCacheWriter {
+ public:
+  SketchCacheWriter(std::filesystem::path path, CacheKey const& key);
+
+  SketchCacheWriter(SketchCacheWriter const&) = delete;
+  auto operator=(SketchCacheWriter const&) -> SketchCacheWriter& = delete;
+
+  ~SketchCacheWriter();
+
+  auto WriteReads(std::span<std::uint32_t const> lengths,
+                  std::span<std::string_view const> names) -> void;
+
+  // Minimizers of reads with ids in [first_id, first_id + minimizers.size()).
+  auto WriteMinimizers(std::uint32_t first_id,
+                       std::span<StrandMinimizers const> minimizers) -> void;
+
+  auto WriteIndex(std::uint32_t first, std::uint32_t last, Index const& index)
+      -> void;
+
+  // Counts after Finish was called on them; their sample is left out.
+  auto WriteFrequentKMers(FrequentKMers const& frequent) -> void;
+
+  auto Finish() -> void;
+
+ private:
+  auto Align() -> void;
+  auto Write(void const* data, std::size_t size) -> std::uint64_t;
+
+  std::filesystem::path path_;
+  std::filesystem::path tmp_path_;
+  std::ofstream file_;
+  std::uint64_t offset_ = 0;
+  bool is_finished_ = false;
+
+  CacheKey key_;
+  std::uint64_t lengths_offset_ = 0;
+  std::uint64_t name_offsets_offset_ = 0;
+  std::uint64_t names_offset_ = 0;
+  std::uint64_t names_size_ = 0;
+
+  std::uint32_t n_sketched_ = 0;
+  std::vector<CachedMinimizers> minimizers_;
+  std::vector<CachedIndex> indexes_;
+
+  std::uint32_t frequent_block_bits_ = 0;
+  std::uint32_t frequent_threshold_ = 0;
+  std::uint64_t n_frequent_kmers_ = 0;
+  std::uint64_t frequent_cells_offset_ = 0;
+  std::uint64_t n_frequent_cells_ = 0;
+};
+
+}  // namespace sniff
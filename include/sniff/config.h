@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <filesystem>
 
+#include "sniff/minimize.h"
+
 namespace sniff {
 
 struct Config {
@@ -11,6 +13,19 @@ struct Config {
   double filter_freq;
   std::uint32_t kmer_len;
   std::uint32_t window_len;
+  bool canonical;
+  Seeding seeding = Seeding::kMinimizer;
+  std::uint32_t syncmer_len = 9;
+  // targets chained per query: the max_targets sharing most seeds with it,
+  // of those sharing at least min_target_share of the best one's seeds
+  std::uint32_t max_targets = 16;
+  double min_target_share = 0.2;
+  // bytes the batch loop may use; batches are capped at a fixed number of
+  // bases when zero
+  std::uint64_t max_memory = 0;
+  // only the length windows of shard shard_index out of n_shards are mapped
+  std::uint32_t shard_index = 0;
+  std::uint32_t n_shards = 1;
 };
 
 }  // namespace sniff
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "sniff/kmer.h"
+
+namespace sniff {
+
+// Counts as caches and run states keep them: the cells of all blocks one
+// after the other. The sample is only needed to go on counting.
+struct FrequentKMerCounts {
+  std::uint32_t block_bits;
+  std::uint32_t threshold;
+  std::uint64_t n_kmers;
+  std::span<std::uint16_t const> cells;
+
+  std::uint32_t sample_level = 0;
+  std::span<std::uint64_t const> sample = {};
+};
+
+// Occurrences of every k-mer of a run, counted while the reads are loaded,
+// before any index is built. Counts live in a count-min sketch of saturating
+// 16 bit cells, so they only ever overestimate and do not depend on the order
+// of concurrent Add calls; the rows of a k-mer share one cache line. A hash
+// sample of the distinct k-mers, capped in size, stands in for all of them
+// when the threshold is picked.
+//
+// The top bits of a k-mer's hash pick its block, so halving the blocks adds
+// up pairs of them into exactly the sketch fewer blocks would have counted.
+// Finish folds the sketch down to the size the number of k-mers calls for,
+// which leaves the counts of a set of k-mers the same however large the
+// sketch was made up front.
+class FrequentKMers {
+ public:
+  // expected_kmers sizes the sketch at about one cell per k-mer; it should
+  // rather be too large, as sketches are only ever folded down.
+  explicit FrequentKMers(std::uint64_t expected_kmers);
+
+  // Throws std::invalid_argument if counts are not valid, see IsValid.
+  explicit FrequentKMers(FrequentKMerCounts const& counts);
+
+  // Whether counts hold a sketch of a size FrequentKMers makes and a sample
+  // as Finish leaves it: sorted, unique, within its level and the cap.
+  static auto IsValid(FrequentKMerCounts const& counts) -> bool;
+
+  // Counts kmers; safe to call concurrently with itself.
+  auto Add(std::span<KMer const> kmers) -> void;
+
+  // Adds the counts and sample of other; the larger sketch of the two is
+  // folded down to the smaller one. Not safe to call concurrently.
+  auto Add(FrequentKMers const& other) -> void;
+
+  // K-mers counted at least as often as the 1 - freq quantile of the distinct
+  // k-mers, and at least twice, are frequent from here on. Counting may go on
+  // afterwards, followed by another Finish.
+  auto Finish(double freq) -> void;
+
+  auto Count(std::uint64_t value) const -> std::uint32_t;
+
+  auto Threshold() const -> std::uint32_t { return threshold_; }
+
+  auto IsFrequent(std::uint64_t value) const -> bool {
+    return Count(value) >= threshold_;
+  }
+
+  // Number of k-mers added so far.
+  auto NumKMers() const -> std::uint64_t {
+    return n_kmers_.load(std::memory_order_relaxed);
+  }
+
+  // log2 of the number of blocks; the sketch of n k-mers is folded down to
+  // BlockBits(n) by Finish.
+  auto BlockBits() const -> std::uint32_t { return block_bits_; }
+  static auto BlockBits(std::uint64_t n_kmers) -> std::uint32_t;
+
+  // Copy of the cells in the layout of FrequentKMerCounts.
+  auto Cells() const -> std::vector<std::uint16_t>;
+
+  auto SampleLevel() const -> std::uint32_t {
+    return sample_level_.load(std::memory_order_relaxed);
+  }
+
+  // Mixed values of the sampled k-mers; sorted and unique after Finish.
+  auto Sample() const -> std::span<std::uint64_t const> { return sample_; }
+
+  // Bytes held by the sketch.
+  auto SizeBytes() const -> std::size_t;
+
+ private:
+  // four rows of eight cells
+  struct alignas(64) Block {
+    std::array<std::atomic<std::uint16_t>, 32> cells;
+  };
+
+  // merges blocks until 2^block_bits remain
+  auto Fold(std::uint32_t block_bits) -> void;
+
+  auto CountMixed(std::uint64_t mixed) const -> std::uint32_t;
+
+  // drops sampled values above the raised level until at most the cap remain
+  auto ShrinkSample() -> void;
+
+  std::uint32_t block_bits_;
+  std::vector<Block> blocks_;
+  std::atomic<std::uint64_t> n_kmers_ = 0;
+
+  std::mutex sample_mutex_;
+  std::atomic<std::uint32_t> sample_level_ = 0;
+  std::vector<std::uint64_t> sample_;
+  std::size_t n_sample_unique_ = 0;
+
+  // nothing is frequent until Finish
+  std::uint32_t threshold_ = 0U - 1;
+};
+
+}  // namespace sniff
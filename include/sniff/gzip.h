@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace sniff {
+
+// Whether data starts with a plausible gzip member header; used both to tell
+// gzipped from plain input and to guess where members start.
+auto IsGzipHeader(std::span<char const> data) -> bool;
+
+// Start of the gzip member following the one which starts at offset, or
+// data.size() if none is found. BGZF blocks record their size in the header,
+// so the next one is found exactly; otherwise the data is scanned for the next
+// plausible header, which may be a false positive inside compressed data.
+auto FindNextGzipMember(std::span<char const> data, std::size_t offset)
+    -> std::size_t;
+
+// Inflates member, which has to hold exactly one complete gzip member, and
+// appends the result to dst. Returns false and leaves dst as it was if it does
+// not, or if its checksum does not match; this makes it safe to inflate
+// members at guessed boundaries and only trust the ones which succeed.
+auto InflateGzipMember(std::span<char const> member, std::string* dst) -> bool;
+
+// Incremental inflate of a sequence of gzip members, fed in arbitrary pieces.
+class GzipStream {
+ public:
+  GzipStream();
+
+  GzipStream(GzipStream const&) = delete;
+  auto operator=(GzipStream const&) -> GzipStream& = delete;
+
+  ~GzipStream();
+
+  auto IsInMember() const -> bool { return is_in_member_; }
+
+  // Whether data which is not gzip followed a member; it and everything fed
+  // after it is ignored, like trailing garbage is by gzip.
+  auto IsFinished() const -> bool { return is_finished_; }
+
+  // Inflates from the start of src and appends to dst until src is consumed
+  // or the current member ends; returns how many bytes of src were consumed.
+  // A new member is started if none is in progress. Throws if a member is
+  // not valid gzip.
+  auto Inflate(std::span<char const> src, std::string* dst) -> std::size_t;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+  bool is_in_member_ = false;
+  bool is_finished_ = false;
+};
+
+}  // namespace sniff
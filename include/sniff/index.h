@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "sniff/kmer.h"
+
+namespace sniff {
+
+struct Target {
+  std::uint32_t read_id;
+  KMer kmer;
+};
+
+// Fixed size lookup slot for a distinct minimizer; its postings are
+// targets[offset, next entry's offset).
+struct IndexEntry {
+  std::uint32_t fingerprint;
+  std::uint32_t offset;
+};
+
+// Immutable minimizer index. Postings are grouped by a mixed hash of the
+// minimizer value; the top bucket_bits of that hash select a run of entries in
+// buckets, and the low 32 bits are kept in each entry to skip foreign values
+// without touching the postings.
+struct Index {
+  std::uint32_t bucket_bits;
+  std::span<std::uint32_t const> buckets;
+  std::span<IndexEntry const> entries;
+  std::span<Target const> targets;
+
+  // keeps the arrays alive; owned vectors for built indexes and the mapped
+  // file for cached ones
+  std::shared_ptr<void const> storage;
+};
+
+auto CreateIndex(std::vector<Target> targets) -> Index;
+
+auto FindTargets(Index const& index, std::uint64_t value)
+    -> std::span<Target const>;
+
+}  // namespace sniff
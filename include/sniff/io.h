@@ -1,18 +1,70 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
 #include "sniff/config.h"
-
-namespace biosoup {
-class NucleicAcid;
-}
+#include "sniff/read_store.h"
 
 namespace sniff {
 
-auto LoadReads(std::filesystem::path const& path)
-    -> std::vector<std::unique_ptr<biosoup::NucleicAcid>>;
+// Where a read starts in the (uncompressed) input stream and how many bases it
+// holds; lets the reads be pulled back in on demand after the first pass.
+struct ReadLocation {
+  std::string name;
+  std::uint64_t offset;
+  std::uint32_t length;
+};
+
+// Sees the reads of an input in batches while they are loaded or located,
+// from as many threads at once as there are batches in flight; ids of a batch
+// start at 0.
+using ReadsVisitor = std::function<auto(ReadStore const&)->void>;
+
+// Reads in input order, with ids starting at 0.
+auto LoadReads(std::filesystem::path const& path,
+               ReadsVisitor const& visit = {}) -> ReadStore;
+
+// Guess of the number of bases in the input from its size, for sizing what
+// is filled while it is read; gzipped input is taken to have been compressed
+// about five fold.
+auto EstimateBases(std::filesystem::path const& path) -> std::uint64_t;
+
+// Input of the streaming loader, which has to seek in it. Seeking in gzipped
+// data means inflating everything before the target, so gzipped input is
+// inflated once into the temporary directory; the copy is removed with this.
+class SeekableInput {
+ public:
+  explicit SeekableInput(std::filesystem::path const& path);
+
+  SeekableInput(SeekableInput const&) = delete;
+  auto operator=(SeekableInput const&) -> SeekableInput& = delete;
+
+  ~SeekableInput();
+
+  auto Path() const -> std::filesystem::path const& { return path_; }
+
+ private:
+  std::filesystem::path path_;
+  bool is_temporary_ = false;
+};
+
+// First pass of the streaming loader; scans the input without keeping any
+// sequence data in memory beyond the batches handed to visit. Throws for
+// gzipped input, see SeekableInput.
+auto LocateReads(std::filesystem::path const& path,
+                 ReadsVisitor const& visit = {}) -> std::vector<ReadLocation>;
+
+// Second pass of the streaming loader; loads reads at given locations and
+// appends them to dst in the order in which they were passed in. Throws for
+// gzipped input, see SeekableInput.
+auto LoadReads(std::filesystem::path const& path,
+               std::span<ReadLocation const> locations, ReadStore* dst)
+    -> void;
 
-}
+}  // namespace sniff
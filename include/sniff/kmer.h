@@ -7,7 +7,9 @@ namespace sniff {
 
 struct KMer {
   std::uint32_t position;
-  std::uint64_t value;
+  std::uint64_t value : 63;
+  // set for canonical k-mers whose value comes from the reverse complement
+  std::uint64_t strand : 1;
 
   friend constexpr auto operator<=>(KMer const& lhs, KMer const& rhs) = default;
 };
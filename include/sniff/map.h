@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <span>
+#include <vector>
 
 #include "sniff/config.h"
 #include "sniff/match.h"
@@ -12,8 +14,28 @@ struct MapConfig {
   std::uint32_t min_chain_length = 4;
   std::uint32_t max_chain_gap_length = 100;
   std::uint32_t kmer_len;
+  // number of preceding matches considered as a predecessor of each match
+  std::uint32_t max_chain_lookback = 64;
 };
 
+// Scratch space for Map; reusing it between calls avoids heap allocations
+// once the buffers have grown to fit the largest input.
+struct MapBuffers {
+  std::vector<Match> matches;
+  std::vector<std::int32_t> query_pos;
+  std::vector<std::int32_t> target_pos;
+  std::vector<std::int32_t> scores;
+  std::vector<std::uint32_t> prev;
+  std::vector<std::int32_t> candidates;
+};
+
+// Chains matches between one query and one target and returns the overlap
+// spanned by the best scoring chain, if it holds at least min_chain_length
+// matches.
 auto Map(MapConfig cfg, std::span<Match const> matches) -> std::vector<Overlap>;
 
+// Appends the overlap to dst.
+auto Map(MapConfig cfg, std::span<Match const> matches, MapBuffers* buffers,
+         std::vector<Overlap>* dst) -> void;
+
 }  // namespace sniff
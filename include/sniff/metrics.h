@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace sniff {
+
+enum class Stage : std::uint8_t {
+  kLoad,
+  kSketch,
+  kSort,
+  kIndex,
+  kThreshold,
+  kLookup,
+  kChain,
+  kMerge,
+  kOutput,
+};
+
+inline constexpr auto kNumStages = std::size_t(9);
+
+enum class Counter : std::uint8_t {
+  kReads,
+  kBases,
+  kMinimizers,
+  // postings of query minimizers looked up in an index
+  kHits,
+  // postings left out of indexes because their k-mer is frequent in the run
+  kFrequencyFiltered,
+  // hits dropped because the two reads differ too much in length
+  kLengthRatioRejected,
+  // hits on targets which share too few seeds with the query to be chained
+  kVoteRejected,
+  kChains,
+  // chains which pass overlap scoring
+  kOverlaps,
+  kPairs,
+};
+
+inline constexpr auto kNumCounters = std::size_t(10);
+
+using Counters = std::array<std::uint64_t, kNumCounters>;
+
+// One length window of the pair search; counters hold what the batch itself
+// produced.
+struct BatchMetrics {
+  std::uint32_t first_query;
+  std::uint32_t first_target;
+  std::uint32_t last;
+
+  std::uint64_t index_targets;
+  std::uint32_t threshold;
+
+  double prepare_seconds;
+  double map_seconds;
+
+  Counters counters;
+};
+
+// Thread safe collection of per stage times, item counters and per batch
+// records of one run. Stage totals are summed over the threads which ran
+// them, so stages spread over many threads report thread time rather than
+// wall time.
+class Metrics {
+ public:
+  Metrics();
+
+  Metrics(Metrics const&) = delete;
+  auto operator=(Metrics const&) -> Metrics& = delete;
+
+  ~Metrics();
+
+  auto Add(Counter counter, std::uint64_t n) -> void;
+
+  // Sums of all threads' counters.
+  auto Totals() const -> Counters;
+
+  // Batches are added by one thread at a time.
+  auto AddBatch(BatchMetrics const& batch) -> void;
+
+  auto ToJson() const -> std::string;
+
+ private:
+  friend class StageTimer;
+
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// Adds the time, the bytes allocated where an allocation counter is set and,
+// where perf_event_open is available, the cpu cycles and cache misses of the
+// calling thread between construction and destruction to a stage. Does nothing
+// if metrics is null. Stages which fan out to other threads internally only
+// count the calling thread's share of cycles and allocations.
+class StageTimer {
+ public:
+  StageTimer(Metrics* metrics, Stage stage);
+
+  StageTimer(StageTimer const&) = delete;
+  auto operator=(StageTimer const&) -> StageTimer& = delete;
+
+  ~StageTimer();
+
+ private:
+  Metrics* metrics_;
+  Stage stage_;
+
+  std::chrono::steady_clock::time_point start_;
+  std::uint64_t start_bytes_allocated_;
+  std::array<std::uint64_t, 2> start_hardware_counters_;
+};
+
+// Bytes allocated by the calling thread so far. The library does not hook
+// allocations itself; programs which do set a counter before the first
+// StageTimer, and stages report no allocated bytes otherwise.
+using AllocationCounter = auto (*)() -> std::uint64_t;
+
+auto SetAllocationCounter(AllocationCounter counter) -> void;
+
+}  // namespace sniff
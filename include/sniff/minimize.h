@@ -1,19 +1,72 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <string_view>
 #include <vector>
 
 #include "sniff/kmer.h"
 
+namespace biosoup {
+class NucleicAcid;
+}
+
 namespace sniff {
 
+// How seeds are sampled from a read:
+//  - kMinimizer: the k-mer of smallest hash in each window of w k-mers
+//  - kOpenSyncmer: k-mers whose smallest s-mer sits in their middle
+//  - kClosedSyncmer: k-mers whose smallest s-mer is their first or last one
+//  - kRandstrobe: each closed syncmer of ceil(k / 2) bases over s-mers of
+//    floor(s / 2) bases linked with the one of the next w syncmers past it
+//    minimizing the xor of their hashes; seeds sit at the first one
+enum class Seeding : std::uint8_t {
+  kMinimizer,
+  kOpenSyncmer,
+  kClosedSyncmer,
+  kRandstrobe
+};
+
+// Throws std::invalid_argument for unknown names.
+auto ParseSeeding(std::string_view name) -> Seeding;
+
 struct MinimizeConfig {
   std::uint32_t kmer_len = 15;
   std::uint32_t window_len = 5;
   bool minhash = false;
+  // minimize over min(k-mer, reverse complement k-mer) and record the strand
+  bool canonical = false;
+  Seeding seeding = Seeding::kMinimizer;
+  // s of syncmers and randstrobes; s-mers are canonical along with k-mers
+  std::uint32_t syncmer_len = 9;
+};
+
+// Seeds per k-mer of a random sequence.
+auto SeedDensity(MinimizeConfig cfg) -> double;
+
+// Reverse complement minimizer positions are relative to the start of the
+// reverse complement sequence.
+struct StrandMinimizers {
+  std::vector<KMer> forward;
+  std::vector<KMer> reverse_complement;
 };
 
+// Seeds are sampled as cfg.seeding selects; throws std::invalid_argument for
+// syncmers with s outside [1, k) and for canonical randstrobes or ones with
+// s < 2.
 auto Minimize(MinimizeConfig cfg, std::string_view sequence)
     -> std::vector<KMer>;
 
+// Minimizes both strands of a read in one sweep over its packed 2-bit data;
+// words hold 32 bases each with the first base in the low bits.
+auto Minimize(MinimizeConfig cfg, std::span<std::uint64_t const> words,
+              std::uint32_t sequence_len) -> StrandMinimizers;
+
+auto Minimize(MinimizeConfig cfg, biosoup::NucleicAcid const& read)
+    -> StrandMinimizers;
+
+// The forward member of the packed overload alone.
+auto MinimizeForward(MinimizeConfig cfg, std::span<std::uint64_t const> words,
+                     std::uint32_t sequence_len) -> std::vector<KMer>;
+
 }  // namespace sniff
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "sniff/overlap.h"
+
+namespace sniff {
+
+// Regression tree in LightGBM's layout; node i is internal, negative children
+// ~leaf point into leaf_value.
+struct Tree {
+  std::vector<std::uint32_t> split_feature;
+  std::vector<double> threshold;
+  std::vector<std::uint8_t> decision_type;
+  std::vector<std::int32_t> left_child;
+  std::vector<std::int32_t> right_child;
+  std::vector<double> leaf_value;
+};
+
+// Gradient boosted trees of a binary classifier.
+struct Model {
+  std::uint32_t n_features;
+  double sigmoid;
+  std::vector<Tree> trees;
+};
+
+// Parses a model saved in LightGBM's text format (Booster.save_model); only
+// binary objectives with numerical splits are supported.
+auto ParseModel(std::string_view text) -> Model;
+
+auto LoadModel(std::filesystem::path const& path) -> Model;
+
+// Probability of the positive class for every row of model.n_features values
+// in features.
+auto Predict(Model const& model, std::span<double const> features)
+    -> std::vector<double>;
+
+inline constexpr auto kNumOverlapFeatures = 6U;
+
+// Coverage, left and right overhang of the query and then of the target, each
+// relative to the read length.
+auto OverlapFeatures(OverlapNamed const& ovlp)
+    -> std::array<double, kNumOverlapFeatures>;
+
+// Keeps overlaps that the model classifies as true pairs.
+auto FilterOverlaps(Model const& model, std::vector<OverlapNamed> overlaps)
+    -> std::vector<OverlapNamed>;
+
+}  // namespace sniff
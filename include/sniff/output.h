@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "sniff/overlap.h"
+
+namespace sniff {
+
+// kCsv: header line and one comma separated row per overlap
+// kPaf: minimap2's pairwise mapping format; strand is always '-' and target
+//   coordinates are on the forward target strand
+// kBinary: little endian; "SNIFFOVL", u32 version, u32 record size,
+//   u64 n names, u64 n records, the name table of (u32 length, bytes) entries
+//   in ascending order and fixed size records of eight u32 values: query
+//   index, length, start, end, then the same for the target; indices point
+//   into the name table
+enum class OutputFormat : std::uint8_t { kCsv, kPaf, kBinary };
+
+struct OutputConfig {
+  OutputFormat format = OutputFormat::kCsv;
+  // write a gzip stream; chunks are compressed in parallel as separate members
+  bool compress = false;
+};
+
+auto ParseOutputFormat(std::string_view name) -> OutputFormat;
+
+// Formats rows in parallel into large buffers and writes them to the file
+// descriptor fd with writev.
+auto WriteOverlaps(OutputConfig cfg, std::span<OverlapNamed const> overlaps,
+                   int fd) -> void;
+
+}  // namespace sniff
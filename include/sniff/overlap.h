@@ -2,7 +2,9 @@
 
 #include <compare>
 #include <cstdint>
-#include <string>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 namespace sniff {
 
@@ -23,13 +25,14 @@ struct Overlap {
                                     const Overlap& rhs) = default;
 };
 
+// Names point into storage owned elsewhere, see NamedOverlaps.
 struct OverlapNamed {
-  std::string query_name;
+  std::string_view query_name;
   std::uint32_t query_length;
   std::uint32_t query_start;
   std::uint32_t query_end;
 
-  std::string target_name;
+  std::string_view target_name;
   std::uint32_t target_length;
   std::uint32_t target_start;
   std::uint32_t target_end;
@@ -38,6 +41,13 @@ struct OverlapNamed {
                           const OverlapNamed& rhs) = default;
 };
 
+// Overlaps of a run together with the storage of the read names they point
+// into, which lives as long as any copy of storage does.
+struct NamedOverlaps {
+  std::vector<OverlapNamed> overlaps;
+  std::shared_ptr<void const> storage;
+};
+
 auto ReverseOverlap(Overlap const& ovlp) -> Overlap;
 auto OverlapLength(Overlap const& ovlp) -> std::uint32_t;
 auto OverlapRatio(Overlap const& ovlp) -> double;
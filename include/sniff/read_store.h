@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace biosoup {
+class NucleicAcid;
+}
+
+namespace sniff {
+
+// Reads with consecutive ids [FirstId(), LastId()) kept as parallel arrays;
+// names and packed 2-bit sequences share one buffer each and are addressed by
+// offset, so per read lookups are plain array loads.
+class ReadStore {
+ public:
+  explicit ReadStore(std::uint32_t first_id = 0) : first_id_(first_id) {}
+
+  // Appends a copy of the read under id LastId().
+  auto Append(biosoup::NucleicAcid const& read) -> void;
+
+  // Appends a read given as text; throws on characters which are not
+  // nucleotide codes.
+  auto Append(std::string_view name, std::string_view data) -> void;
+
+  // Appends all reads of reads in order.
+  auto Append(ReadStore const& reads) -> void;
+
+  // Copy of the store which holds the reads with ids order[0], order[1], ...
+  // under ids FirstId(), FirstId() + 1, ...
+  auto Permute(std::span<std::uint32_t const> order) const -> ReadStore;
+
+  // Frees the sequences; names and lengths stay available and sequences read
+  // as empty.
+  auto ReleaseSequences() -> void;
+
+  auto size() const -> std::size_t { return lengths_.size(); }
+  auto empty() const -> bool { return lengths_.empty(); }
+
+  auto FirstId() const -> std::uint32_t { return first_id_; }
+  auto LastId() const -> std::uint32_t { return first_id_ + lengths_.size(); }
+
+  auto Lengths() const -> std::span<std::uint32_t const> { return lengths_; }
+
+  auto Length(std::uint32_t read_id) const -> std::uint32_t {
+    return lengths_[read_id - first_id_];
+  }
+
+  auto Name(std::uint32_t read_id) const -> std::string_view {
+    auto const idx = read_id - first_id_;
+    return std::string_view(names_.data() + name_offsets_[idx],
+                            name_offsets_[idx + 1] - name_offsets_[idx]);
+  }
+
+  // Packed 2-bit codes, 32 bases per word with the first base in the low bits.
+  auto Sequence(std::uint32_t read_id) const
+      -> std::span<std::uint64_t const> {
+    auto const idx = read_id - first_id_;
+    return std::span(sequences_.data() + sequence_offsets_[idx],
+                     sequence_offsets_[idx + 1] - sequence_offsets_[idx]);
+  }
+
+  // Sequence decoded to ACGT.
+  auto InflateData(std::uint32_t read_id) const -> std::string;
+
+ private:
+  std::uint32_t first_id_;
+
+  std::vector<std::uint32_t> lengths_;
+  std::vector<std::uint64_t> name_offsets_ = {0};
+  std::vector<std::uint64_t> sequence_offsets_ = {0};
+
+  std::string names_;
+  std::vector<std::uint64_t> sequences_;
+};
+
+}  // namespace sniff
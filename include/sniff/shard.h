@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sniff/overlap.h"
+
+namespace sniff {
+
+// Output of one shard of a sharded run: the overlaps which are the best of at
+// least one of their reads within the shard's share of length windows. Read
+// ids are positions in the length sorted input, which every shard of the same
+// input agrees on; scores are kept so shards can be merged exactly.
+struct ShardCandidates {
+  std::uint32_t shard_index = 0;
+  std::uint32_t n_shards = 1;
+  std::uint64_t n_reads = 0;
+  std::vector<Overlap> overlaps;
+  // (read id, name) of the reads in overlaps, ordered by id
+  std::vector<std::pair<std::uint32_t, std::string>> names;
+};
+
+// Little endian; "SNIFFSHD", u32 version, u32 shard index, u32 n shards,
+// u64 n reads, u64 n names, u64 n records, the name table of (u32 read id,
+// u32 length, bytes) entries and records of eight u32 overlap fields in
+// declaration order followed by the f64 score.
+auto WriteShard(ShardCandidates const& shard, int fd) -> void;
+
+auto ReadShard(std::filesystem::path const& path) -> ShardCandidates;
+
+// Resolves the candidates of all shards of a run like the batch loop resolves
+// its batches: best partners are raised over every candidate and an overlap is
+// kept if it ends up the best of both its reads. Throws unless shards holds
+// every shard of the same input exactly once.
+auto MergeShards(std::vector<ShardCandidates> shards) -> NamedOverlaps;
+
+}  // namespace sniff
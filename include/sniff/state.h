@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "sniff/frequency.h"
+#include "sniff/kmer.h"
+#include "sniff/minimize.h"
+#include "sniff/overlap.h"
+
+namespace sniff {
+
+// What incremental runs keep between invocations: every read added so far
+// with its forward sketch, the counts of their k-mers, and the overlaps which
+// hold the best partner of at least one read, with their scores. Read ids are
+// positions in the order the reads were added; runs only add reads, so ids
+// never change.
+class RunState {
+ public:
+  RunState(std::uint32_t kmer_len, std::uint32_t window_len, bool canonical,
+           Seeding seeding = Seeding::kMinimizer,
+           std::uint32_t syncmer_len = 9, double filter_freq = 0.0002)
+      : kmer_len_(kmer_len),
+        window_len_(window_len),
+        canonical_(canonical),
+        seeding_(seeding),
+        syncmer_len_(syncmer_len),
+        filter_freq_(filter_freq) {}
+
+  auto KMerLength() const -> std::uint32_t { return kmer_len_; }
+  auto WindowLength() const -> std::uint32_t { return window_len_; }
+  auto IsCanonical() const -> bool { return canonical_; }
+  auto SeedingScheme() const -> Seeding { return seeding_; }
+  auto SyncmerLength() const -> std::uint32_t { return syncmer_len_; }
+  auto FilterFrequency() const -> double { return filter_freq_; }
+
+  auto size() const -> std::size_t { return lengths_.size(); }
+
+  auto Lengths() const -> std::span<std::uint32_t const> { return lengths_; }
+
+  auto Name(std::uint32_t read_id) const -> std::string_view {
+    return std::string_view(
+        names_.data() + name_offsets_[read_id],
+        name_offsets_[read_id + 1] - name_offsets_[read_id]);
+  }
+
+  // Forward minimizers of a read.
+  auto Minimizers(std::uint32_t read_id) const -> std::span<KMer const> {
+    return std::span(minimizers_.data() + minimizer_offsets_[read_id],
+                     minimizer_offsets_[read_id + 1] -
+                         minimizer_offsets_[read_id]);
+  }
+
+  // Adds a read under id size().
+  auto Append(std::string_view name, std::uint32_t length,
+              std::span<KMer const> minimizers) -> void;
+
+  auto Candidates() const -> std::span<Overlap const> { return candidates_; }
+
+  auto SetCandidates(std::vector<Overlap> candidates) -> void {
+    candidates_ = std::move(candidates);
+  }
+
+  // Finished counts of the k-mers of all reads; null while there are none.
+  auto Frequent() const -> FrequentKMers const* { return frequent_.get(); }
+
+  auto SetFrequent(std::unique_ptr<FrequentKMers> frequent) -> void {
+    frequent_ = std::move(frequent);
+  }
+
+ private:
+  std::uint32_t kmer_len_;
+  std::uint32_t window_len_;
+  bool canonical_;
+  Seeding seeding_;
+  std::uint32_t syncmer_len_;
+  double filter_freq_;
+
+  std::vector<std::uint32_t> lengths_;
+  std::vector<std::uint64_t> name_offsets_ = {0};
+  std::string names_;
+
+  std::vector<std::uint64_t> minimizer_offsets_ = {0};
+  std::vector<KMer> minimizers_;
+
+  std::vector<Overlap> candidates_;
+
+  std::unique_ptr<FrequentKMers> frequent_;
+};
+
+// Returns nullopt if path does not exist; throws if it is not a state file.
+auto LoadRunState(std::filesystem::path const& path)
+    -> std::optional<RunState>;
+
+// Little endian; "SNIFFRUN", u32 version, u32 k, u32 w, u32 canonical,
+// u32 seeding, u32 s, f64 filter frequency, u64 n reads, u64 n candidates,
+// then per read u32 length, u32 name length, name, u32 n minimizers and (u32
+// position, u64 value with the strand in the top bit) minimizers, and the
+// candidates as eight u32 overlap fields in declaration order followed by the
+// f64 score. The k-mer counts follow as u32 block bits, zero if there are
+// none and then nothing else, u32 threshold, u64 n k-mers, u32 sample level,
+// u64 n cells, u16 cells, u64 n sampled and the u64 sampled values.
+// The file is written next to path and only moved there once complete, so a
+// failed run leaves the previous state in place.
+auto SaveRunState(RunState const& state, std::filesystem::path const& path)
+    -> void;
+
+}  // namespace sniff
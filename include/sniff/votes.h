@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace sniff {
+
+// Seeds one query shares with each target read, counted in an open addressing
+// table which keeps its slots from one query to the next. Selecting targets
+// from the counts lets mapping chain only the likely partners of a query.
+class TargetVotes {
+ public:
+  TargetVotes();
+
+  // Forgets the counts of the previous query.
+  auto Clear() -> void;
+
+  auto Add(std::uint32_t target_id) -> void;
+
+  auto Votes(std::uint32_t target_id) const -> std::uint32_t;
+
+  // Keeps targets with at least min_votes votes and at least min_share of the
+  // votes of the best target; of those, the max_targets with most votes, ties
+  // going to the smaller id. Returns the number of targets kept.
+  auto Select(std::uint32_t min_votes, double min_share,
+              std::uint32_t max_targets) -> std::size_t;
+
+  auto IsSelected(std::uint32_t target_id) const -> bool;
+
+ private:
+  struct Slot {
+    std::uint32_t target_id;
+    // the top bit marks selected targets
+    std::uint32_t votes;
+  };
+
+  auto Find(std::uint32_t target_id) const -> std::size_t;
+
+  auto Grow() -> void;
+
+  std::uint32_t slot_bits_;
+  std::vector<Slot> slots_;
+  // indices of the slots in use
+  std::vector<std::uint32_t> used_;
+  std::vector<Slot> ranked_;
+};
+
+}  // namespace sniff
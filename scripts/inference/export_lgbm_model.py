@@ -0,0 +1,26 @@
+import argparse
+
+import joblib
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        prog='export_lgbm_model',
+        description='export a pickled lgbm model to the text format sniff '
+                    'loads with --model',
+    )
+
+    parser.add_argument(
+        '-m', '--model', type=str, required=True,
+        help='path to pickled lgbm model file',
+    )
+
+    parser.add_argument(
+        '-o', '--output', type=str, required=True,
+        help='path of the exported text model',
+    )
+
+    args = parser.parse_args()
+
+    model = joblib.load(args.model)
+    booster = getattr(model, 'booster_', model)
+    booster.save_model(args.output)
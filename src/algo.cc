@@ -1,27 +1,72 @@
 #include "sniff/algo.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
 #include <cmath>
-#include <functional>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <numeric>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
-#include <variant>
+#include <utility>
 
 // 3rd party
-#include "ankerl/unordered_dense.h"
-#include "biosoup/nucleic_acid.hpp"
 #include "biosoup/timer.hpp"
 #include "fmt/core.h"
 #include "tbb/tbb.h"
 
 // sniff
+#include "sniff/best_pairs.h"
+#include "sniff/cache.h"
+#include "sniff/frequency.h"
+#include "sniff/index.h"
+#include "sniff/io.h"
 #include "sniff/map.h"
 #include "sniff/match.h"
+#include "sniff/metrics.h"
 #include "sniff/minimize.h"
+#include "sniff/read_store.h"
+#include "sniff/shard.h"
 #include "sniff/sketch.h"
+#include "sniff/state.h"
+#include "sniff/votes.h"
 
 static constexpr auto kIndexSize = 1U << 30U;
 
+// Memory held per minimizer of a batch's reads, which --max-memory batch
+// sizing is based on. A built index keeps the posting, about one entry and up
+// to two bucket slots; building one also holds the reverse complement
+// minimizers and the unsorted copy of the postings; queries keep their forward
+// sketches.
+static constexpr auto kIndexBytesPerMinimizer =
+    sizeof(sniff::Target) + sizeof(sniff::IndexEntry) +
+    2 * sizeof(std::uint32_t);
+static constexpr auto kBuildBytesPerMinimizer =
+    sizeof(sniff::KMer) + sizeof(sniff::Target);
+static constexpr auto kSketchBytesPerMinimizer = sizeof(sniff::KMer);
+
+// batches below this many bases are not worth overlapping with mapping; the
+// budget goes to one batch at a time instead
+static constexpr auto kMinPipelinedBatchBases = std::uint64_t(1) << 24U;
+
+// postings of one index are addressed with 32 bit offsets
+static constexpr auto kMaxIndexTargets =
+    std::uint64_t(std::numeric_limits<std::uint32_t>::max() / 2);
+
+// read id marking postings of frequent k-mers while an index is extracted
+static constexpr auto kFrequentTarget =
+    std::numeric_limits<std::uint32_t>::max();
+
+// matches a chain needs before it is scored as an overlap
+static constexpr auto kMinChainLength = std::uint32_t(4);
+
 static constexpr auto kIntercept = -23.47084474;
 
 static constexpr auto kCoefs = std::tuple{
@@ -39,409 +84,610 @@ requires((std::is_integral_v<Args> || std::is_floating_point_v<Args>) ||
   return (1. / (1. + std::exp(-x)));
 }
 
-template <class... Ts>
-struct overloaded : Ts... {
-  using Ts::operator()...;
+// Scratch space of one mapping thread, reused by every query it maps. The
+// buffers only grow, so mapping runs without heap allocations once they fit
+// the largest query.
+struct MappingBuffers {
+  // postings of the query's minimizers, looked up once for voting and for
+  // the matches of the selected targets
+  std::vector<std::pair<sniff::KMer, std::span<sniff::Target const>>> hits;
+  sniff::TargetVotes votes;
+  std::vector<sniff::Match> matches;
+  std::vector<std::uint32_t> target_intervals;
+  sniff::MapBuffers map;
+  std::vector<sniff::Overlap> chains;
+
+  // overlaps this thread made the best of both their reads; only the ones
+  // that stay best until all batches are mapped are reported
+  std::vector<sniff::Overlap> overlaps;
 };
 
-template <class... Ts>
-overloaded(Ts...) -> overloaded<Ts...>;
-
-struct Target {
-  std::uint32_t read_id;
-  sniff::KMer kmer;
-};
+using ThreadMappingBuffers = tbb::enumerable_thread_specific<MappingBuffers>;
+
+// RcMinimizers -> reverse complement minimizers; minimizers[idx] belong to the
+// read with id first_id + idx. Postings of frequent k-mers are left out.
+static auto ExtractRcMinimizers(
+    std::uint32_t first_id, std::span<sniff::StrandMinimizers const> minimizers,
+    sniff::FrequentKMers const& frequent, sniff::Metrics* metrics)
+    -> std::vector<sniff::Target> {
+  auto offsets = std::vector<std::size_t>(minimizers.size() + 1, 0);
+  for (std::size_t idx = 0; idx < minimizers.size(); ++idx) {
+    offsets[idx + 1] =
+        offsets[idx] + minimizers[idx].reverse_complement.size();
+  }
 
-struct KMerLocator {
-  std::uint32_t count;
-  std::variant<Target, Target const*> value;
-};
+  // frequent postings are marked in parallel and dropped in one sweep
+  auto dst = std::vector<sniff::Target>(offsets.back());
+  tbb::parallel_for(
+      std::size_t(0), minimizers.size(),
+      [first_id, minimizers, &frequent, &offsets,
+       &dst](std::size_t const idx) -> void {
+        auto const read_id = static_cast<std::uint32_t>(first_id + idx);
+        auto out = dst.begin() + offsets[idx];
+        for (auto const kmer : minimizers[idx].reverse_complement) {
+          *out++ = sniff::Target{
+              .read_id = frequent.IsFrequent(kmer.value) ? kFrequentTarget
+                                                         : read_id,
+              .kmer = kmer};
+        }
+      });
 
-using KMerLocIndex = ankerl::unordered_dense::map<std::uint64_t, KMerLocator>;
+  auto const n_frequent = std::erase_if(dst, [](sniff::Target const& target) {
+    return target.read_id == kFrequentTarget;
+  });
+  if (metrics) {
+    metrics->Add(sniff::Counter::kFrequencyFiltered, n_frequent);
+  }
 
-struct Index {
-  KMerLocIndex locations;
-  std::vector<Target> kmers;
-};
+  return dst;
+}
 
-static auto FlattenOverlapVec(std::vector<std::vector<sniff::Overlap>> overlaps)
-    -> std::vector<sniff::Overlap> {
-  auto dst = std::vector<sniff::Overlap>();
-  dst.reserve(std::transform_reduce(
-      overlaps.begin(), overlaps.end(), std::size_t(0), std::plus<>{},
-      [](std::vector<sniff::Overlap> const& vec) -> std::size_t {
-        return vec.size();
-      }));
+// Rc stands for "reverse complement"
+static auto CreateRcKMerIndex(
+    std::uint32_t first_target_id,
+    std::span<sniff::StrandMinimizers const> target_minimizers,
+    sniff::FrequentKMers const& frequent, sniff::Metrics* metrics)
+    -> sniff::Index {
+  return sniff::CreateIndex(ExtractRcMinimizers(
+      first_target_id, target_minimizers, frequent, metrics));
+}
 
-  for (auto& it : overlaps) {
-    dst.insert(dst.end(), it.begin(), it.end());
-    std::vector<sniff::Overlap>{}.swap(it);
+// Scores a chained overlap from its coverage and overhangs on both reads;
+// keeps it only if both reads are covered well enough.
+static auto ScoreOverlap(sniff::Config const& cfg, sniff::Overlap ovlp)
+    -> std::optional<sniff::Overlap> {
+  auto const query_len = ovlp.query_length;
+  auto const query_score =
+      static_cast<double>(ovlp.query_end - ovlp.query_start) / query_len;
+
+  auto const target_len = ovlp.target_length;
+  auto const target_score =
+      static_cast<double>(ovlp.target_end - ovlp.target_start) / target_len;
+
+  auto const query_lhs_overhang =
+      static_cast<double>(ovlp.query_start) / query_len;
+  auto const query_rhs_overhang =
+      static_cast<double>(query_len - ovlp.query_end) / query_len;
+
+  auto const target_lhs_overhang =
+      static_cast<double>(ovlp.target_start) / target_len;
+  auto const target_rhs_overhang =
+      static_cast<double>(target_len - ovlp.target_end) / target_len;
+
+  auto const ovlp_score = ScoreOvlp(
+      std::tuple(query_score, query_lhs_overhang, query_rhs_overhang,
+                 target_score, target_lhs_overhang, target_rhs_overhang));
+
+  if (query_score > cfg.beta_p && target_score > cfg.beta_p &&
+      ovlp_score > 0.50) {
+    ovlp.score = ovlp_score;
+    return ovlp;
   }
 
-  return dst;
+  return std::nullopt;
 }
 
-static auto CreateRcString(std::unique_ptr<biosoup::NucleicAcid> const& read)
-    -> std::string {
-  auto dst = std::string(read->inflated_len, '\0');
-  for (std::uint32_t i = 0; i < dst.size(); ++i) {
-    dst[i] = biosoup::kNucleotideDecoder[3 ^ read->Code(dst.size() - 1 - i)];
+// Chains buffers->matches of one query and offers the overlaps it keeps to
+// best_pairs. With keep_candidates set, overlaps holding the best partner of
+// just one read are kept as well; runs whose results are combined later need
+// the best partner of every read.
+static auto MapMatches(sniff::Config const& cfg,
+                       std::span<std::uint32_t const> read_lens,
+                       bool keep_candidates, sniff::BestPairs* best_pairs,
+                       MappingBuffers* buffers, sniff::Metrics* metrics)
+    -> void {
+  auto const timer = sniff::StageTimer(metrics, sniff::Stage::kChain);
+  auto n_chains = std::size_t(0);
+  auto n_overlaps = std::size_t(0);
+
+  auto& matches = buffers->matches;
+  std::sort(matches.begin(), matches.end(),
+            [](sniff::Match const& lhs, sniff::Match const& rhs) -> bool {
+              return lhs.target_id < rhs.target_id;
+            });
+
+  auto& target_intervals = buffers->target_intervals;
+  target_intervals.assign(1, 0);
+  for (std::uint32_t i = 0; i < matches.size(); ++i) {
+    if (i + 1 == matches.size() ||
+        matches[i].target_id != matches[i + 1].target_id) {
+      target_intervals.push_back(i + 1);
+    }
   }
 
-  return dst;
-}
+  auto const map_cfg = sniff::MapConfig{.min_chain_length = kMinChainLength,
+                                        .max_chain_gap_length = 800,
+                                        .kmer_len = cfg.kmer_len};
+  for (std::size_t idx = 0; idx + 1 < target_intervals.size(); ++idx) {
+    auto& chains = buffers->chains;
+    chains.clear();
+    sniff::Map(map_cfg,
+               std::span(matches.cbegin() + target_intervals[idx],
+                         matches.cbegin() + target_intervals[idx + 1]),
+               &buffers->map, &chains);
+
+    n_chains += chains.size();
+    for (auto ovlp : chains) {
+      ovlp.query_length = read_lens[ovlp.query_id];
+      ovlp.target_length = read_lens[ovlp.target_id];
+      auto const scored = ScoreOverlap(cfg, ovlp);
+      n_overlaps += scored.has_value();
+      if (!scored) {
+        continue;
+      }
+      if (best_pairs->Update(*scored) ||
+          (keep_candidates && best_pairs->IsBestOfEither(*scored))) {
+        buffers->overlaps.push_back(*scored);
+      }
+    }
+  }
 
-static auto GetReadRefFromSpan(
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> reads,
-    std::uint32_t read_id) -> std::unique_ptr<biosoup::NucleicAcid> const& {
-  return *std::lower_bound(
-      reads.begin(), reads.end(), read_id,
-      [](std::unique_ptr<biosoup::NucleicAcid> const& read,
-         std::uint32_t read_id) -> bool { return read->id < read_id; });
+  if (metrics) {
+    metrics->Add(sniff::Counter::kChains, n_chains);
+    metrics->Add(sniff::Counter::kOverlaps, n_overlaps);
+  }
 }
 
-static auto GetFrequencyThreshold(KMerLocIndex const& index, double freq)
-    -> std::uint32_t {
-  if (index.size() <= 2) {
-    return 0U - 1;
+static auto MapSketchToIndex(sniff::Config const& cfg,
+                             std::span<std::uint32_t const> read_lens,
+                             sniff::Sketch const& sketch,
+                             sniff::Index const& index, bool keep_candidates,
+                             sniff::BestPairs* best_pairs,
+                             MappingBuffers* buffers, sniff::Metrics* metrics)
+    -> void {
+  auto const min_short_long_ratio = 1.0 - cfg.alpha_p;
+  auto const query_len = read_lens[sketch.read_id];
+  auto& hits = buffers->hits;
+  auto& votes = buffers->votes;
+  auto& read_matches = buffers->matches;
+  hits.clear();
+  votes.Clear();
+  read_matches.clear();
+
+  auto n_hits = std::size_t(0);
+  auto n_voted = std::size_t(0);
+  auto n_length_ratio_rejected = std::size_t(0);
+
+  auto const is_candidate =
+      [read_lens, min_short_long_ratio, query_len, &query_sketch = sketch,
+       &n_length_ratio_rejected](sniff::KMer const& query_kmer,
+                                 sniff::Target const& target) -> bool {
+    if (query_sketch.read_id >= target.read_id ||
+        query_kmer.strand != target.kmer.strand) {
+      return false;
+    }
+    auto const target_len = read_lens[target.read_id];
+    auto const len_ratio = 1. * std::min(query_len, target_len) /
+                           std::max(query_len, target_len);
+    if (len_ratio < min_short_long_ratio) {
+      ++n_length_ratio_rejected;
+      return false;
+    }
+
+    return true;
+  };
+
+  {
+    auto const timer = sniff::StageTimer(metrics, sniff::Stage::kLookup);
+    for (auto const& query_kmer : sketch.minimizers) {
+      auto const targets = sniff::FindTargets(index, query_kmer.value);
+      if (targets.empty()) {
+        continue;
+      }
+
+      n_hits += targets.size();
+      hits.emplace_back(query_kmer, targets);
+      for (auto const& target : targets) {
+        if (is_candidate(query_kmer, target)) {
+          votes.Add(target.read_id);
+          ++n_voted;
+        }
+      }
+    }
+
+    // targets sharing fewer seeds than a chain holds can not overlap the
+    // query; matches are only made for the targets that are kept
+    votes.Select(kMinChainLength, cfg.min_target_share, cfg.max_targets);
+    for (auto const& [query_kmer, targets] : hits) {
+      for (auto const& target : targets) {
+        if (query_kmer.strand == target.kmer.strand &&
+            votes.IsSelected(target.read_id)) {
+          read_matches.push_back(
+              sniff::Match{.query_id = sketch.read_id,
+                           .query_pos = query_kmer.position,
+                           .target_id = target.read_id,
+                           .target_pos = target.kmer.position});
+        }
+      }
+    }
   }
-  auto counts = std::vector<std::uint32_t>();
-  counts.reserve(index.size());
 
-  for (auto it : index) {
-    counts.push_back(it.second.count);
+  if (metrics) {
+    metrics->Add(sniff::Counter::kHits, n_hits);
+    metrics->Add(sniff::Counter::kLengthRatioRejected,
+                 n_length_ratio_rejected);
+    metrics->Add(sniff::Counter::kVoteRejected,
+                 n_voted - read_matches.size());
   }
 
-  auto const idx = static_cast<std::size_t>(counts.size() * (1. - freq));
-  std::nth_element(counts.begin(), counts.begin() + idx, counts.end());
-  return counts[idx];
+  MapMatches(cfg, read_lens, keep_candidates, best_pairs, buffers, metrics);
+}
+
+// Queries are mapped serially per thread; a nested parallel loop could let a
+// thread pick up another query while its buffers are in use.
+static auto MapSpanToIndex(sniff::Config const& cfg,
+                           std::span<std::uint32_t const> read_lens,
+                           std::span<sniff::Sketch const> query_sketches,
+                           sniff::Index const& target_index,
+                           bool keep_candidates, sniff::BestPairs* best_pairs,
+                           ThreadMappingBuffers& thread_buffers,
+                           sniff::Metrics* metrics) -> void {
+  tbb::parallel_for(
+      std::size_t(0), query_sketches.size(),
+      [&cfg, read_lens, query_sketches, &target_index, keep_candidates,
+       best_pairs, &thread_buffers, metrics](std::size_t idx) {
+        MapSketchToIndex(cfg, read_lens, query_sketches[idx], target_index,
+                         keep_candidates, best_pairs, &thread_buffers.local(),
+                         metrics);
+      });
 }
 
-// RcMinimizers -> reverse complement minimizers
-static auto ExtractRcMinimizersSortedByVal(
-    sniff::Config const& cfg,
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> reads)
-    -> std::vector<Target> {
-  auto dst = std::vector<Target>();
-  auto const minimize_cfg = sniff::MinimizeConfig{
-      .kmer_len = cfg.kmer_len, .window_len = cfg.window_len, .minhash = false};
+static auto MinimizeConfigOf(sniff::Config const& cfg)
+    -> sniff::MinimizeConfig {
+  return sniff::MinimizeConfig{.kmer_len = cfg.kmer_len,
+                               .window_len = cfg.window_len,
+                               .minhash = false,
+                               .canonical = cfg.canonical,
+                               .seeding = cfg.seeding,
+                               .syncmer_len = cfg.syncmer_len};
+}
 
-  auto cnt = std::atomic_size_t(0);
-  auto sketches = std::vector<std::vector<Target>>(reads.size());
+// Minimizes reads with ids in [first, last).
+static auto MinimizeReads(sniff::Config const& cfg,
+                          sniff::ReadStore const& reads, std::uint32_t first,
+                          std::uint32_t last, sniff::Metrics* metrics)
+    -> std::vector<sniff::StrandMinimizers> {
+  auto const minimize_cfg = MinimizeConfigOf(cfg);
 
+  auto dst = std::vector<sniff::StrandMinimizers>(last - first);
   tbb::parallel_for(
-      std::size_t(0), reads.size(),
-      [&reads, &minimize_cfg, &cnt, &sketches](std::size_t const idx) -> void {
-        auto const rc_kmers =
-            Minimize(minimize_cfg, CreateRcString(reads[idx]));
-        cnt += rc_kmers.size();
-
-        sketches[idx].reserve(rc_kmers.size());
-        for (auto const kmer : rc_kmers) {
-          sketches[idx].push_back(
-              Target{.read_id = reads[idx]->id, .kmer = kmer});
+      first, last,
+      [&reads, &minimize_cfg, &dst, first,
+       metrics](std::uint32_t read_id) -> void {
+        auto const timer = sniff::StageTimer(metrics, sniff::Stage::kSketch);
+        auto& minimizers = dst[read_id - first];
+        minimizers = Minimize(minimize_cfg, reads.Sequence(read_id),
+                              reads.Length(read_id));
+        if (metrics) {
+          metrics->Add(sniff::Counter::kMinimizers, minimizers.forward.size());
         }
       });
 
-  dst.reserve(cnt);
-  for (auto& sketch : sketches) {
-    dst.insert(dst.end(), sketch.begin(), sketch.end());
-    std::vector<Target>{}.swap(sketch);
-  }
+  return dst;
+}
+
+// Adds the forward minimizers of all reads of a store to frequent.
+static auto CountReads(sniff::Config const& cfg, sniff::ReadStore const& reads,
+                       sniff::FrequentKMers* frequent, sniff::Metrics* metrics)
+    -> void {
+  auto const minimize_cfg = MinimizeConfigOf(cfg);
+  tbb::parallel_for(
+      reads.FirstId(), reads.LastId(),
+      [&reads, &minimize_cfg, frequent, metrics](std::uint32_t read_id) {
+        auto const timer =
+            sniff::StageTimer(metrics, sniff::Stage::kThreshold);
+        frequent->Add(sniff::MinimizeForward(
+            minimize_cfg, reads.Sequence(read_id), reads.Length(read_id)));
+      });
+}
+
+// Counts sized for the k-mers of n_bases bases of reads and n_kept_kmers
+// counted before.
+static auto CreateFrequentKMers(sniff::Config const& cfg,
+                                std::uint64_t n_bases,
+                                std::uint64_t n_kept_kmers = 0)
+    -> std::unique_ptr<sniff::FrequentKMers> {
+  return std::make_unique<sniff::FrequentKMers>(
+      static_cast<std::uint64_t>(n_bases *
+                                 sniff::SeedDensity(MinimizeConfigOf(cfg))) +
+      n_kept_kmers);
+}
 
-  tbb::parallel_sort(dst.begin(), dst.end(),
-                     [](Target const& lhs, Target const& rhs) -> bool {
-                       return lhs.kmer.value < rhs.kmer.value;
-                     });
+// K-mers counted by earlier runs on state.
+static auto KeptKMers(sniff::RunState const& state) -> std::uint64_t {
+  return state.Frequent() ? state.Frequent()->NumKMers() : 0;
+}
+
+// Counts the reads a loader sees into frequent.
+static auto CountingVisitor(sniff::Config const& cfg,
+                            sniff::FrequentKMers* frequent,
+                            sniff::Metrics* metrics) -> sniff::ReadsVisitor {
+  return [&cfg, frequent, metrics](sniff::ReadStore const& reads) -> void {
+    CountReads(cfg, reads, frequent, metrics);
+  };
+}
+
+// Picks the threshold once the k-mers of all reads are counted.
+static auto FinishCounting(sniff::Config const& cfg,
+                           sniff::FrequentKMers* frequent) -> void {
+  frequent->Finish(cfg.filter_freq);
+  fmt::print(stderr,
+             "[FindReverseComplementPairs] frequent k-mer threshold: {}\n",
+             frequent->Threshold());
+}
+
+// Counts reads which were loaded without counting, in a pass of their own.
+static auto CountLoadedReads(sniff::Config const& cfg, sniff::ReadStore reads,
+                             std::uint64_t n_kept_kmers,
+                             sniff::Metrics* metrics) -> sniff::CountedReads {
+  auto const read_lens = reads.Lengths();
+  auto const n_bases =
+      std::accumulate(read_lens.begin(), read_lens.end(), std::uint64_t(0));
+  auto dst = sniff::CountedReads{
+      .reads = std::move(reads),
+      .frequent = CreateFrequentKMers(cfg, n_bases, n_kept_kmers)};
+  CountReads(cfg, dst.reads, dst.frequent.get(), metrics);
 
   return dst;
 }
 
-static auto IndexKMers(std::span<Target const> target_kmers) -> KMerLocIndex {
-  auto dst = KMerLocIndex();
-  for (std::uint32_t i = 0, j = i; i < target_kmers.size(); ++j) {
-    if (j < target_kmers.size() &&
-        target_kmers[i].kmer.value == target_kmers[j].kmer.value) {
-      continue;
-    }
+static auto SortReads(sniff::ReadStore const& reads) -> sniff::ReadStore {
+  auto order = std::vector<std::uint32_t>(reads.size());
+  std::iota(order.begin(), order.end(), reads.FirstId());
+  std::stable_sort(order.begin(), order.end(),
+                   [&reads](std::uint32_t lhs, std::uint32_t rhs) -> bool {
+                     return reads.Length(lhs) < reads.Length(rhs);
+                   });
 
-    auto& locator = dst[target_kmers[i].kmer.value];
-    locator.count = j - i;
+  return reads.Permute(order);
+}
 
-    if (locator.count == 1) {
-      locator.value = target_kmers[i];
-    } else {
-      locator.value = std::addressof(target_kmers[i]);
-    }
+static auto SortLocations(std::vector<sniff::ReadLocation> locations)
+    -> std::vector<sniff::ReadLocation> {
+  std::stable_sort(
+      locations.begin(), locations.end(),
+      [](sniff::ReadLocation const& lhs, sniff::ReadLocation const& rhs)
+          -> bool { return lhs.length < rhs.length; });
 
-    i = j;
+  return locations;
+}
+
+// Resident set size of the process, or zero if it can not be read.
+static auto ResidentBytes() -> std::uint64_t {
+  auto statm = std::ifstream("/proc/self/statm");
+  auto size_pages = std::uint64_t(0);
+  auto resident_pages = std::uint64_t(0);
+  if (!(statm >> size_pages >> resident_pages)) {
+    return 0;
   }
 
-  return dst;
-};
+  return resident_pages * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+}
 
-// Rc stands for "reverse complement"
-static auto CreateRcKMerIndex(
-    sniff::Config const& cfg,
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> target_reads)
-    -> Index {
-  auto target_kmers = ExtractRcMinimizersSortedByVal(cfg, target_reads);
-  return {.locations = IndexKMers(target_kmers),
-          .kmers = std::move(target_kmers)};
-}
-
-// Assumes that the input is grouped by (query_id, target_id) pairs and overlaps
-// in a group are non-overlapping and sorted by ascending (query, target)
-// positions.
-static auto MergeOverlaps(
-    sniff::Config const& cfg,
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> query_reads,
-    std::span<sniff::Overlap const> overlaps) -> std::vector<sniff::Overlap> {
-  auto dst = std::vector<sniff::Overlap>();
-  if (overlaps.empty()) {
-    return dst;
-  }
-
-  auto buff = std::vector<sniff::Overlap>{overlaps.front()};
-  auto merge_overlaps =
-      [&cfg, query_reads](
-          std::vector<sniff::Overlap> ovlps) -> std::optional<sniff::Overlap> {
-    if (ovlps.empty()) {
-      return std::nullopt;
+// Picks how many bases a batch may index and how many batches are in flight
+// so that indexes and sketches stay within cfg.max_memory on top of what the
+// process already holds. Seed density starts at the one expected for random
+// sequence and follows the batches prepared so far.
+class BatchSizer {
+ public:
+  BatchSizer(sniff::Config const& cfg, std::size_t n_reads)
+      : is_budgeted_(cfg.max_memory > 0),
+        expected_density_(sniff::SeedDensity(MinimizeConfigOf(cfg))) {
+    if (!is_budgeted_) {
+      return;
     }
 
-    std::sort(ovlps.begin(), ovlps.end(),
-              [](sniff::Overlap const& lhs, sniff::Overlap const& rhs) -> bool {
-                return lhs.query_start < rhs.query_start;
-              });
-
-    if (not std::is_sorted(
-            ovlps.begin(), ovlps.end(),
-            [](sniff::Overlap const& lhs, sniff::Overlap const& rhs) -> bool {
-              return lhs.target_start < rhs.target_start;
-            })) {
-      return std::nullopt;
-    }
+    // best partners are tracked for every read throughout
+    auto const fixed = ResidentBytes() + n_reads * sizeof(std::uint64_t);
+    budget_ = cfg.max_memory > fixed ? cfg.max_memory - fixed : 0;
+    depth_ = MaxBases(2) >= kMinPipelinedBatchBases ? 2 : 1;
+  }
 
-    auto const query_len = ovlps.front().query_length;
-    auto const query_score = static_cast<double>(ovlps.back().query_end -
-                                                 ovlps.front().query_start) /
-                             query_len;
-
-    auto const target_len = ovlps.front().target_length;
-    auto const target_score = static_cast<double>(ovlps.back().target_end -
-                                                  ovlps.front().target_start) /
-                              ovlps.front().target_length;
-
-    auto const query_lhs_overhang =
-        static_cast<double>(ovlps.front().query_start) / query_len;
-    auto const query_rhs_overhang =
-        static_cast<double>(query_len - ovlps.back().query_end) / query_len;
-
-    auto const target_lhs_overhang =
-        static_cast<double>(ovlps.front().target_start) / target_len;
-    auto const target_rhs_overhang =
-        static_cast<double>(target_len - ovlps.front().target_end) / target_len;
-
-    auto const ovlp_score = ScoreOvlp(
-        std::tuple(query_score, query_lhs_overhang, query_rhs_overhang,
-                   target_score, target_lhs_overhang, target_rhs_overhang));
-
-    if (query_score > cfg.beta_p && target_score > cfg.beta_p &&
-        ovlp_score > 0.50) {
-      return sniff::Overlap{.query_id = ovlps.front().query_id,
-                            .query_length = ovlps.front().query_length,
-                            .query_start = ovlps.front().query_start,
-                            .query_end = ovlps.back().query_end,
-
-                            .target_id = ovlps.front().target_id,
-                            .target_length = ovlps.front().target_length,
-                            .target_start = ovlps.front().target_start,
-                            .target_end = ovlps.back().target_end,
-
-                            .score = ovlp_score};
-    }
+  auto IsBudgeted() const -> bool { return is_budgeted_; }
 
-    return std::nullopt;
-  };
+  auto Budget() const -> std::uint64_t { return budget_; }
 
-  for (std::uint32_t i = 0, j = i = 1;
-       i < overlaps.size() && j < overlaps.size(); ++j) {
-    if ((overlaps[i].query_id == overlaps[j].query_id &&
-         overlaps[i].target_id == overlaps[j].target_id)) {
-      buff.push_back(overlaps[j]);
-    } else {
-      if (auto const opt_ovlp = merge_overlaps(buff); opt_ovlp) {
-        dst.push_back(*opt_ovlp);
-      }
+  // Number of batches prepared or mapped at once.
+  auto Depth() const -> std::size_t { return depth_; }
 
-      buff.clear();
-      buff.push_back(overlaps[j]);
+  auto MaxBases() const -> std::uint64_t {
+    return is_budgeted_ ? MaxBases(depth_) : kIndexSize;
+  }
 
-      i = j;
-    }
+  auto Observe(std::uint64_t n_bases, std::uint64_t n_minimizers) -> void {
+    n_bases_ += n_bases;
+    n_minimizers_ += n_minimizers;
   }
 
-  if (auto const opt_ovlp = merge_overlaps(buff); opt_ovlp) {
-    dst.push_back(*opt_ovlp);
+ private:
+  auto Density() const -> double {
+    return n_bases_ > 0 ? static_cast<double>(n_minimizers_) / n_bases_
+                        : expected_density_;
   }
 
-  return dst;
+  // an index and the sketches of each batch in flight, the sketches of the
+  // batch queried before them and the scratch space of the one being built
+  auto MaxBases(std::size_t depth) const -> std::uint64_t {
+    auto const density = std::max(Density(), 1e-3);
+    auto const bytes_per_base =
+        density * static_cast<double>(depth * kIndexBytesPerMinimizer +
+                                      kBuildBytesPerMinimizer +
+                                      (depth + 1) * kSketchBytesPerMinimizer);
+
+    return std::max<std::uint64_t>(
+        1, std::min(static_cast<std::uint64_t>(budget_ / bytes_per_base),
+                    static_cast<std::uint64_t>(kMaxIndexTargets / density)));
+  }
+
+  bool is_budgeted_;
+  double expected_density_;
+  std::uint64_t budget_ = 0;
+  std::size_t depth_ = 2;
+
+  std::uint64_t n_bases_ = 0;
+  std::uint64_t n_minimizers_ = 0;
 };
 
-static auto MapMatches(
-    sniff::Config const& cfg,
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> query_reads,
-    std::vector<sniff::Match> matches) -> std::vector<sniff::Overlap> {
-  std::sort(matches.begin(), matches.end(),
-            [](sniff::Match const& lhs, sniff::Match const& rhs) -> bool {
-              return lhs.target_id < rhs.target_id;
-            });
+// One length window of the batch loop; reads with ids in [first_query, last)
+// are mapped onto the index of reads with ids in [first_target, last).
+struct Batch {
+  std::uint32_t first_query;
+  std::uint32_t first_target;
+  std::uint32_t last;
 
-  auto target_intervals = std::vector<std::uint32_t>{0};
-  for (std::uint32_t i = 0; i < matches.size(); ++i) {
-    if (i + 1 == matches.size() ||
-        matches[i].target_id != matches[i + 1].target_id) {
-      target_intervals.push_back(i + 1);
-    }
-  }
+  // forward sketches of the reads first minimized by the previous batch and by
+  // this one; together they cover the queries
+  std::shared_ptr<std::vector<sniff::Sketch> const> prev_sketches;
+  std::shared_ptr<std::vector<sniff::Sketch> const> sketches;
 
-  auto ovlps_buff = std::vector<std::vector<sniff::Overlap>>(matches.size());
-  tbb::parallel_for(
-      std::size_t(0), target_intervals.size() - 1,
-      [&cfg, query_reads, &matches, &target_intervals,
-       &ovlps_buff](std::size_t read_idx) -> void {
-        auto local_matches =
-            std::span(matches.begin() + target_intervals[read_idx],
-                      matches.begin() + target_intervals[read_idx + 1]);
-
-        ovlps_buff[read_idx] =
-            [&cfg, query_reads](std::vector<sniff::Overlap> overlaps)
-            -> std::vector<sniff::Overlap> {
-          using namespace std::placeholders;
-          auto const get_read = std::bind(GetReadRefFromSpan, query_reads, _1);
-          for (auto& ovlp : overlaps) {
-            ovlp.query_length = get_read(ovlp.query_id)->inflated_len;
-            ovlp.target_length = get_read(ovlp.target_id)->inflated_len;
-          }
+  sniff::Index index;
 
-          return MergeOverlaps(cfg, query_reads, overlaps);
-        }(Map({.min_chain_length = 4,
-               .max_chain_gap_length = 800,
-               .kmer_len = cfg.kmer_len},
-              local_matches));
-      });
+  sniff::BatchMetrics metrics;
+};
+
+// Counters only the mapping stage adds to; their growth while a batch is
+// mapped belongs to that batch even though the next one is being prepared.
+static constexpr auto kMappingCounters = std::array{
+    sniff::Counter::kHits,
+    sniff::Counter::kLengthRatioRejected,
+    sniff::Counter::kVoteRejected,
+    sniff::Counter::kChains,
+    sniff::Counter::kOverlaps,
+};
 
-  return FlattenOverlapVec(std::move(ovlps_buff));
+static auto SecondsSince(std::chrono::steady_clock::time_point start)
+    -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
 }
 
-static auto MapSketchToIndex(
-    sniff::Config const& cfg,
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> query_reads,
-    sniff::Sketch const& sketch, KMerLocIndex const& index, double threshold)
-    -> std::vector<sniff::Overlap> {
-  auto const min_short_long_ratio = 1.0 - cfg.alpha_p;
-  auto read_matches = std::vector<sniff::Match>();
+// Moves the forward minimizers out into sketches; minimizers[idx] belong to
+// the read with id first_id + idx.
+static auto TakeForwardSketches(std::uint32_t first_id,
+                                std::span<sniff::StrandMinimizers> minimizers)
+    -> std::vector<sniff::Sketch> {
+  auto dst = std::vector<sniff::Sketch>(minimizers.size());
+  for (std::size_t idx = 0; idx < minimizers.size(); ++idx) {
+    dst[idx] = sniff::Sketch{
+        .read_id = static_cast<std::uint32_t>(first_id + idx),
+        .minimizers = std::move(minimizers[idx].forward)};
+  }
 
-  using namespace std::placeholders;
-  auto const get_read = std::bind(GetReadRefFromSpan, query_reads, _1);
+  return dst;
+}
 
-  auto const try_match =
-      [get_read, min_short_long_ratio, &query_sketch = sketch, &read_matches,
-       threshold](sniff::KMer const& query_kmer, Target const& target) -> void {
-    if (query_sketch.read_id >= target.read_id) {
-      return;
-    }
-    auto const len_ratio =
-        1. *
-        std::min(get_read(query_sketch.read_id)->inflated_len,
-                 get_read(target.read_id)->inflated_len) /
-        std::max(get_read(query_sketch.read_id)->inflated_len,
-                 get_read(target.read_id)->inflated_len);
-    if (len_ratio < min_short_long_ratio) {
-      return;
+// End of the length window starting at read first, which has to be a read:
+// the window takes in reads until it holds max_bases or its last read is too
+// long to pair up with read first. Every batching over read_lens cuts its
+// windows here, one after the other, so all runs over the same reads agree.
+template <class LengthScaler>
+static auto FindBatchEnd(std::span<std::uint32_t const> read_lens,
+                         std::uint32_t first, std::uint64_t max_bases,
+                         LengthScaler const& scale_len) -> std::uint32_t {
+  auto last = first;
+  for (auto batch_size = std::uint64_t(0);; ++last) {
+    batch_size += read_lens[last];
+    if (batch_size >= max_bases || last + 1U == read_lens.size() ||
+        scale_len(read_lens[last]) >= read_lens[first]) {
+      break;
     }
+  }
 
-    read_matches.push_back(sniff::Match{.query_id = query_sketch.read_id,
-                                        .query_pos = query_kmer.position,
-                                        .target_id = target.read_id,
-                                        .target_pos = target.kmer.position});
-  };
+  return last + 1;
+}
 
-  for (auto const& query_kmer : sketch.minimizers) {
-    auto const cl = index.find(query_kmer.value);
-    if (cl == index.end() || cl->second.count >= threshold) {
-      continue;
-    }
+// Batches [first, last) of the batch loop belong to shard cfg.shard_index;
+// shards get runs of consecutive batches, so each one only minimizes the
+// batch before its run on top of its own.
+template <class LengthScaler>
+static auto FindShardBatches(sniff::Config const& cfg,
+                             std::span<std::uint32_t const> read_lens,
+                             std::uint64_t max_bases,
+                             LengthScaler const& scale_len)
+    -> std::pair<std::size_t, std::size_t> {
+  if (cfg.n_shards <= 1) {
+    return {0, std::numeric_limits<std::size_t>::max()};
+  }
 
-    std::visit(
-        overloaded{[&try_match, &query_kmer](Target const& targe_kmer) -> void {
-                     try_match(query_kmer, targe_kmer);
-                   },
-                   [count = cl->second.count, &try_match,
-                    &query_kmer](Target const* target_kmers_ptr) -> void {
-                     for (std::uint32_t i = 0; i < count; ++i) {
-                       try_match(query_kmer, *(target_kmers_ptr + i));
-                     }
-                   }},
-        cl->second.value);
+  auto n_batches = std::size_t(0);
+  for (auto first = std::uint32_t(0); first < read_lens.size(); ++n_batches) {
+    first = FindBatchEnd(read_lens, first, max_bases, scale_len);
   }
 
-  return MapMatches(cfg, query_reads, std::move(read_matches));
+  return {n_batches * cfg.shard_index / cfg.n_shards,
+          n_batches * (cfg.shard_index + 1) / cfg.n_shards};
 }
 
-static auto MapSpanToIndex(
-    sniff::Config const& cfg,
-    std::span<std::unique_ptr<biosoup::NucleicAcid> const> query_reads,
-    KMerLocIndex const& target_index, double threshold)
+// Runs the length sorted batching over reads whose ids match their position in
+// read_lens; minimize_reads(first, last) has to return minimizers of reads
+// with ids in [first, last), and is called with consecutive ranges unless the
+// run is sharded, which skips the ranges of other shards' batches. Sharded
+// runs return the overlaps which are the best of either of their reads.
+// create_index(first, minimizers) returns the index of a batch, built from the
+// reverse complement minimizers of its reads without the frequent ones by
+// default. Batches are prepared one ahead of the one being mapped, so at most
+// two indexes are alive at once.
+template <class ReadsMinimizer, class IndexCreator>
+static auto FindBestOverlaps(sniff::Config const& cfg,
+                             std::span<std::uint32_t const> read_lens,
+                             sniff::FrequentKMers const& frequent,
+                             sniff::Metrics* metrics,
+                             ReadsMinimizer&& minimize_reads,
+                             IndexCreator&& create_index)
     -> std::vector<sniff::Overlap> {
-  auto const minimize_cfg = sniff::MinimizeConfig{
-      .kmer_len = cfg.kmer_len, .window_len = cfg.window_len, .minhash = false};
-
-  auto ovlps_buff =
-      std::vector<std::vector<sniff::Overlap>>(query_reads.size());
-  tbb::parallel_for(std::size_t(0), query_reads.size(),
-                    [&cfg, query_reads, &target_index, threshold, &minimize_cfg,
-                     &ovlps_buff](std::size_t idx) {
-                      auto sketch = sniff::Sketch{
-                          .read_id = query_reads[idx]->id,
-                          .minimizers = Minimize(
-                              minimize_cfg, query_reads[idx]->InflateData())};
-
-                      ovlps_buff[idx] = MapSketchToIndex(
-                          cfg, query_reads, sketch, target_index, threshold);
-                    });
-
-  return FlattenOverlapVec(std::move(ovlps_buff));
-}
-
-auto SortReadsAndReindex(
-    std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads)
-    -> std::vector<std::unique_ptr<biosoup::NucleicAcid>> {
-  std::sort(reads.begin(), reads.end(),
-            [](std::unique_ptr<biosoup::NucleicAcid> const& lhs,
-               std::unique_ptr<biosoup::NucleicAcid> const& rhs) -> bool {
-              return lhs->inflated_len < rhs->inflated_len;
-            });
-
-  for (std::uint32_t idx = 0; idx < reads.size(); ++idx) {
-    reads[idx]->id = idx;
+  if (metrics) {
+    metrics->Add(sniff::Counter::kReads, read_lens.size());
+    metrics->Add(sniff::Counter::kBases,
+                 std::accumulate(read_lens.begin(), read_lens.end(),
+                                 std::uint64_t(0)));
   }
 
-  return reads;
-};
-
-namespace sniff {
-
-auto FindReverseComplementPairs(
-    Config const& cfg, std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads)
-    -> std::vector<OverlapNamed> {
-  reads = SortReadsAndReindex(std::move(reads));
-  auto const delim = reads.size() + 1;
+  // shards have to agree on the batch bounds, which budgeted batches adapt
+  // to what the process observes
+  if (cfg.n_shards > 1 && cfg.max_memory > 0) {
+    throw std::invalid_argument(
+        "[sniff::FindReverseComplementPairs] sharded runs need fixed batch "
+        "sizes; max_memory is not supported");
+  }
+  if (cfg.shard_index >= cfg.n_shards) {
+    throw std::invalid_argument(
+        "[sniff::FindReverseComplementPairs] invalid shard " +
+        std::to_string(cfg.shard_index) + "/" + std::to_string(cfg.n_shards));
+  }
 
-  auto ovlps = std::vector<sniff::Overlap>(
-      reads.size(),
-      sniff::Overlap{.query_id = static_cast<std::uint32_t>(delim)});
+  auto const is_sharded = cfg.n_shards > 1;
+  auto best_pairs = sniff::BestPairs(read_lens.size());
+  auto thread_buffers = ThreadMappingBuffers();
+
+  auto batch_sizer = BatchSizer(cfg, read_lens.size());
+  if (batch_sizer.IsBudgeted()) {
+    fmt::print(stderr,
+               "[FindReverseComplementPairs] batch memory budget: {:.3f} GB; "
+               "pipeline depth: {}; first batch: {} bases\n",
+               batch_sizer.Budget() / 1e9, batch_sizer.Depth(),
+               batch_sizer.MaxBases());
+  }
 
   auto timer = biosoup::Timer{};
   timer.Start();
@@ -451,43 +697,154 @@ auto FindReverseComplementPairs(
     return read_len * p;
   };
 
-  auto prev_i = std::size_t(0);
-  auto batch_size = std::size_t(0);
-  auto const max_batch_size = kIndexSize;
-  for (std::uint32_t i = 0, j = i; j < reads.size(); ++j) {
-    batch_size += reads[j]->inflated_len;
-    if (batch_size < max_batch_size && j + 1U < reads.size() &&
-        scale_len(reads[j]->inflated_len) < reads[i]->inflated_len) {
-      continue;
+  auto prev_i = std::uint32_t(0);
+  auto i = std::uint32_t(0);
+  auto j = std::uint32_t(0);
+
+  auto batch_idx = std::size_t(0);
+  auto const shard_batches =
+      FindShardBatches(cfg, read_lens, batch_sizer.MaxBases(), scale_len);
+
+  // reads indexed by a batch are queried again by the next one; their forward
+  // sketches are kept around instead of minimizing them twice
+  auto sketched_last = std::uint32_t(0);
+  auto sketches = std::shared_ptr<std::vector<sniff::Sketch> const>();
+
+  auto const prepare_batch =
+      [&](tbb::flow_control& flow_control) -> std::shared_ptr<Batch> {
+    auto const start = std::chrono::steady_clock::now();
+
+    // batches ahead of the shard's run are skipped; only the last one is
+    // minimized, as the first batch of the run queries its reads
+    for (; i != read_lens.size() && batch_idx < shard_batches.first;
+         ++batch_idx) {
+      j = FindBatchEnd(read_lens, i, batch_sizer.MaxBases(), scale_len);
+      if (batch_idx + 1 == shard_batches.first) {
+        auto minimizers = minimize_reads(sketched_last, j);
+        sketches = std::make_shared<std::vector<sniff::Sketch> const>(
+            TakeForwardSketches(sketched_last, minimizers));
+      }
+
+      sketched_last = j;
+      prev_i = i;
+      i = j;
+    }
+
+    if (i == read_lens.size() || batch_idx == shard_batches.second) {
+      flow_control.stop();
+      return nullptr;
+    }
+    ++batch_idx;
+    j = FindBatchEnd(read_lens, i, batch_sizer.MaxBases(), scale_len);
+
+    auto minimizers = minimize_reads(sketched_last, j);
+    auto batch_sketches = TakeForwardSketches(sketched_last, minimizers);
+    auto n_minimizers = std::uint64_t(0);
+    auto n_bases = std::uint64_t(0);
+    for (auto const& sketch : batch_sketches) {
+      n_minimizers += sketch.minimizers.size();
+      n_bases += read_lens[sketch.read_id];
     }
 
-    auto index = CreateRcKMerIndex(
-        cfg, std::span(reads.cbegin() + i, reads.cbegin() + j));
+    // the pipeline maps the previous batch meanwhile, but only index
+    // creation drops frequent postings
+    auto const n_filtered = [metrics]() -> std::uint64_t {
+      return metrics ? metrics->Totals()[static_cast<std::size_t>(
+                           sniff::Counter::kFrequencyFiltered)]
+                     : 0;
+    };
+    auto const n_filtered_before = n_filtered();
+    auto index = sniff::Index();
+    {
+      auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kIndex);
+      index = create_index(
+          i, std::span<sniff::StrandMinimizers const>(minimizers).subspan(
+                 i - sketched_last));
+    }
 
-    auto batch_ovlps = MapSpanToIndex(
-        cfg, std::span(reads.cbegin() + prev_i, reads.cbegin() + j),
-        index.locations,
-        GetFrequencyThreshold(index.locations, cfg.filter_freq));
+    auto batch = std::make_shared<Batch>(Batch{
+        .first_query = prev_i,
+        .first_target = i,
+        .last = j,
+        .prev_sketches = std::exchange(
+            sketches, std::make_shared<std::vector<sniff::Sketch> const>(
+                          std::move(batch_sketches))),
+        .sketches = sketches,
+        .index = std::move(index)});
+
+    batch->metrics = sniff::BatchMetrics{
+        .first_query = prev_i,
+        .first_target = i,
+        .last = j,
+        .index_targets = batch->index.targets.size(),
+        .threshold = frequent.Threshold(),
+        .prepare_seconds = SecondsSince(start),
+        .map_seconds = 0,
+        .counters = {}};
+    batch->metrics.counters[static_cast<std::size_t>(
+        sniff::Counter::kMinimizers)] = n_minimizers;
+    batch->metrics.counters[static_cast<std::size_t>(
+        sniff::Counter::kFrequencyFiltered)] =
+        n_filtered() - n_filtered_before;
+    batch_sizer.Observe(n_bases, n_minimizers);
+
+    sketched_last = j;
+    prev_i = i;
+    i = j;
 
-    for (auto const& ovlp : batch_ovlps) {
-      if (ovlp.score > ovlps[ovlp.query_id].score &&
-          ovlp.score > ovlps[ovlp.target_id].score) {
-        ovlps[ovlp.query_id] = ovlps[ovlp.target_id] = ovlp;
+    return batch;
+  };
+
+  auto const map_batch = [&](std::shared_ptr<Batch> const& batch) -> void {
+    auto const start = std::chrono::steady_clock::now();
+    auto const totals = metrics ? metrics->Totals() : sniff::Counters{};
+    if (batch->prev_sketches) {
+      auto const queries = std::span(*batch->prev_sketches);
+      MapSpanToIndex(
+          cfg, read_lens,
+          std::span(std::partition_point(queries.begin(), queries.end(),
+                                         [&batch](sniff::Sketch const& sketch) {
+                                           return sketch.read_id <
+                                                  batch->first_query;
+                                         }),
+                    queries.end()),
+          batch->index, is_sharded, &best_pairs, thread_buffers, metrics);
+    }
+    MapSpanToIndex(cfg, read_lens, *batch->sketches, batch->index, is_sharded,
+                   &best_pairs, thread_buffers, metrics);
+
+    if (metrics) {
+      auto batch_metrics = batch->metrics;
+      batch_metrics.map_seconds = SecondsSince(start);
+
+      auto const map_totals = metrics->Totals();
+      for (auto const counter : kMappingCounters) {
+        auto const idx = static_cast<std::size_t>(counter);
+        batch_metrics.counters[idx] = map_totals[idx] - totals[idx];
       }
+      metrics->AddBatch(batch_metrics);
     }
 
     fmt::print(stderr, "\r[FindReverseComplementPairs]({:12.3f}) {:2.3f}%",
-               timer.Lap(), 100. * j / reads.size());
-    batch_size = std::size_t(0);
-    prev_i = i;
-    i = j + 1;
-  }
+               timer.Lap(), 100. * batch->last / read_lens.size());
+  };
 
-  ovlps.erase(std::remove_if(ovlps.begin(), ovlps.end(),
-                             [delim](sniff::Overlap const& ovlp) -> bool {
-                               return ovlp.query_id == delim;
-                             }),
-              ovlps.end());
+  tbb::parallel_pipeline(
+      batch_sizer.Depth(), tbb::make_filter<void, std::shared_ptr<Batch>>(
+             tbb::filter_mode::serial_in_order, prepare_batch) &
+             tbb::make_filter<std::shared_ptr<Batch>, void>(
+                 tbb::filter_mode::serial_in_order, map_batch));
+
+  auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kMerge);
+  auto ovlps = std::vector<sniff::Overlap>();
+  for (auto const& buffers : thread_buffers) {
+    std::copy_if(buffers.overlaps.cbegin(), buffers.overlaps.cend(),
+                 std::back_inserter(ovlps),
+                 [is_sharded, &best_pairs](sniff::Overlap const& ovlp) -> bool {
+                   return is_sharded ? best_pairs.IsBestOfEither(ovlp)
+                                     : best_pairs.IsBest(ovlp);
+                 });
+  }
 
   std::sort(ovlps.begin(), ovlps.end());
   ovlps.erase(std::unique(ovlps.begin(), ovlps.end()), ovlps.end());
@@ -495,17 +852,69 @@ auto FindReverseComplementPairs(
   fmt::print(stderr, "\n[FindReverseComplementPairs]({:12.3f}) n pairs: {}\n",
              timer.Stop(), ovlps.size());
 
-  auto dst = std::vector<OverlapNamed>();
-  dst.reserve(ovlps.size());
+  return ovlps;
+}
+
+// Inflating gzipped input for the streaming loader counts as loading.
+static auto OpenSeekableInput(std::filesystem::path const& reads_path,
+                              sniff::Metrics* metrics) -> sniff::SeekableInput {
+  auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kLoad);
+  return sniff::SeekableInput(reads_path);
+}
+
+// First pass of the streaming loader; the k-mers of the reads are counted
+// into frequent on the way and reads are ordered by length.
+static auto LocateAndSortReads(
+    sniff::Config const& cfg, std::filesystem::path const& reads_path,
+    std::unique_ptr<sniff::FrequentKMers>* frequent, sniff::Metrics* metrics)
+    -> std::vector<sniff::ReadLocation> {
+  *frequent = CreateFrequentKMers(cfg, sniff::EstimateBases(reads_path));
+  auto locations = std::vector<sniff::ReadLocation>();
+  {
+    auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kLoad);
+    locations = sniff::LocateReads(
+        reads_path, CountingVisitor(cfg, frequent->get(), metrics));
+  }
+  FinishCounting(cfg, frequent->get());
+
+  auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kSort);
+  return SortLocations(std::move(locations));
+}
+
+// Loads reads at locations[first, last) and minimizes them.
+static auto LoadAndMinimizeReads(sniff::Config const& cfg,
+                                 std::filesystem::path const& reads_path,
+                                 std::span<sniff::ReadLocation const> locations,
+                                 std::uint32_t first, std::uint32_t last,
+                                 sniff::Metrics* metrics)
+    -> std::vector<sniff::StrandMinimizers> {
+  auto store = sniff::ReadStore(first);
+  {
+    auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kLoad);
+    sniff::LoadReads(reads_path, locations.subspan(first, last - first),
+                     &store);
+  }
+
+  return MinimizeReads(cfg, store, first, last, metrics);
+}
+
+// Names are views into storage, which has to own whatever get_name returns
+// views into.
+template <class NameGetter>
+static auto NameOverlaps(std::span<sniff::Overlap const> ovlps,
+                         std::shared_ptr<void const> storage,
+                         NameGetter&& get_name) -> sniff::NamedOverlaps {
+  auto dst = sniff::NamedOverlaps{.storage = std::move(storage)};
+  dst.overlaps.reserve(ovlps.size());
 
   for (auto ovlp : ovlps) {
-    dst.push_back(OverlapNamed{
-        .query_name = reads[ovlp.query_id]->name,
+    dst.overlaps.push_back(sniff::OverlapNamed{
+        .query_name = get_name(ovlp.query_id),
         .query_length = ovlp.query_length,
         .query_start = ovlp.query_start,
         .query_end = ovlp.query_end,
 
-        .target_name = reads[ovlp.target_id]->name,
+        .target_name = get_name(ovlp.target_id),
         .target_length = ovlp.target_length,
         .target_start = ovlp.target_start,
         .target_end = ovlp.target_end,
@@ -515,4 +924,485 @@ auto FindReverseComplementPairs(
   return dst;
 }
 
+// Sorts counted reads by length and runs the batch loop over them.
+static auto FindOverlapsInMemory(sniff::Config const& cfg,
+                                 sniff::CountedReads* reads,
+                                 sniff::Metrics* metrics)
+    -> std::vector<sniff::Overlap> {
+  FinishCounting(cfg, reads->frequent.get());
+  {
+    auto const stage_timer = sniff::StageTimer(metrics, sniff::Stage::kSort);
+    reads->reads = SortReads(reads->reads);
+  }
+
+  auto const& frequent = reads->frequent;
+  return FindBestOverlaps(
+      cfg, reads->reads.Lengths(), *frequent, metrics,
+      [&cfg, reads, metrics](std::uint32_t first, std::uint32_t last)
+          -> std::vector<sniff::StrandMinimizers> {
+        return MinimizeReads(cfg, reads->reads, first, last, metrics);
+      },
+      [&frequent, metrics](
+          std::uint32_t first,
+          std::span<sniff::StrandMinimizers const> minimizers) -> sniff::Index {
+        return CreateRcKMerIndex(first, minimizers, *frequent, metrics);
+      });
+}
+
+// Runs the batch loop over located reads sorted by length, whose k-mers were
+// counted into frequent while they were located; every read is loaded right
+// before it is minimized, and dropped afterwards.
+static auto FindOverlapsStreaming(
+    sniff::Config const& cfg, std::filesystem::path const& reads_path,
+    std::span<sniff::ReadLocation const> locations,
+    sniff::FrequentKMers const& frequent, sniff::Metrics* metrics)
+    -> std::vector<sniff::Overlap> {
+  auto read_lens = std::vector<std::uint32_t>(locations.size());
+  std::transform(locations.begin(), locations.end(), read_lens.begin(),
+                 [](sniff::ReadLocation const& location) -> std::uint32_t {
+                   return location.length;
+                 });
+
+  return FindBestOverlaps(
+      cfg, read_lens, frequent, metrics,
+      [&cfg, &reads_path, locations, metrics](
+          std::uint32_t first,
+          std::uint32_t last) -> std::vector<sniff::StrandMinimizers> {
+        return LoadAndMinimizeReads(cfg, reads_path, locations, first, last,
+                                    metrics);
+      },
+      [&frequent, metrics](
+          std::uint32_t first,
+          std::span<sniff::StrandMinimizers const> minimizers) -> sniff::Index {
+        return CreateRcKMerIndex(first, minimizers, frequent, metrics);
+      });
+}
+
+// Shard output of a sharded batch loop over n_reads reads; names are copied
+// as shards outlive the reads.
+template <class NameGetter>
+static auto CreateShardCandidates(sniff::Config const& cfg,
+                                  std::size_t n_reads,
+                                  std::vector<sniff::Overlap> ovlps,
+                                  NameGetter&& get_name)
+    -> sniff::ShardCandidates {
+  auto read_ids = std::vector<std::uint32_t>();
+  read_ids.reserve(ovlps.size() * 2);
+  for (auto const& ovlp : ovlps) {
+    read_ids.push_back(ovlp.query_id);
+    read_ids.push_back(ovlp.target_id);
+  }
+  std::sort(read_ids.begin(), read_ids.end());
+  read_ids.erase(std::unique(read_ids.begin(), read_ids.end()),
+                 read_ids.end());
+
+  auto dst = sniff::ShardCandidates{.shard_index = cfg.shard_index,
+                                    .n_shards = cfg.n_shards,
+                                    .n_reads = n_reads,
+                                    .overlaps = std::move(ovlps)};
+  dst.names.reserve(read_ids.size());
+  for (auto const read_id : read_ids) {
+    dst.names.emplace_back(read_id, std::string(get_name(read_id)));
+  }
+
+  return dst;
+}
+
+namespace sniff {
+
+auto LoadCountedReads(Config const& cfg, std::filesystem::path const& path,
+                      Metrics* metrics) -> CountedReads {
+  auto dst = CountedReads{.reads = ReadStore(),
+                          .frequent =
+                              CreateFrequentKMers(cfg, EstimateBases(path))};
+  dst.reads =
+      LoadReads(path, CountingVisitor(cfg, dst.frequent.get(), metrics));
+
+  return dst;
+}
+
+auto LoadCountedReads(Config const& cfg, std::filesystem::path const& path,
+                      RunState const& state, Metrics* metrics)
+    -> CountedReads {
+  auto dst = CountedReads{
+      .reads = ReadStore(),
+      .frequent = CreateFrequentKMers(cfg, EstimateBases(path),
+                                      KeptKMers(state))};
+  dst.reads =
+      LoadReads(path, CountingVisitor(cfg, dst.frequent.get(), metrics));
+
+  return dst;
+}
+
+auto FindReverseComplementPairs(Config const& cfg, CountedReads reads,
+                                Metrics* metrics) -> NamedOverlaps {
+  auto const ovlps = FindOverlapsInMemory(cfg, &reads, metrics);
+
+  // only the names are needed from here on
+  reads.reads.ReleaseSequences();
+  auto const store = std::make_shared<ReadStore const>(std::move(reads.reads));
+  return NameOverlaps(ovlps, store, [&store](std::uint32_t read_id) {
+    return store->Name(read_id);
+  });
+}
+
+auto FindReverseComplementPairs(Config const& cfg, ReadStore reads,
+                                Metrics* metrics) -> NamedOverlaps {
+  return FindReverseComplementPairs(
+      cfg, CountLoadedReads(cfg, std::move(reads), 0, metrics), metrics);
+}
+
+auto FindReverseComplementPairs(Config const& cfg,
+                                std::filesystem::path const& reads_path,
+                                Metrics* metrics) -> NamedOverlaps {
+  auto const input = OpenSeekableInput(reads_path, metrics);
+  auto frequent = std::unique_ptr<FrequentKMers>();
+  auto const shared_locations =
+      std::make_shared<std::vector<ReadLocation> const>(
+          LocateAndSortReads(cfg, input.Path(), &frequent, metrics));
+  auto const& locations = *shared_locations;
+
+  auto const ovlps =
+      FindOverlapsStreaming(cfg, input.Path(), locations, *frequent, metrics);
+  return NameOverlaps(ovlps, shared_locations,
+                      [&locations](std::uint32_t read_id) {
+                        return std::string_view(locations[read_id].name);
+                      });
+}
+
+auto FindReverseComplementPairs(Config const& cfg,
+                                std::filesystem::path const& reads_path,
+                                std::filesystem::path const& cache_path,
+                                Metrics* metrics) -> NamedOverlaps {
+  auto const key =
+      CreateCacheKey(MinimizeConfigOf(cfg), cfg.filter_freq, reads_path);
+
+  if (auto const cache = SketchCache::Open(cache_path, key)) {
+    fmt::print(stderr,
+               "[sniff::FindReverseComplementPairs] using cache: {} ({} reads)"
+               "\n",
+               cache_path.string(), cache->size());
+
+    // the k-mers were counted when the cache was built
+    auto const* const frequent = &cache->Frequent();
+    fmt::print(stderr,
+               "[FindReverseComplementPairs] frequent k-mer threshold: {}\n",
+               frequent->Threshold());
+
+    // forward minimizers are copied out for the sketches; batch indexes are
+    // used in place and only rebuilt when --alpha moved the batch bounds
+    auto const ovlps = FindBestOverlaps(
+        cfg, cache->Lengths(), *frequent, metrics,
+        [&cache, metrics](std::uint32_t first, std::uint32_t last)
+            -> std::vector<StrandMinimizers> {
+          if (last > cache->NumSketched()) {
+            throw std::runtime_error(
+                "[sniff::FindReverseComplementPairs] cache is missing "
+                "minimizers of read " +
+                std::to_string(last - 1));
+          }
+
+          auto const stage_timer = StageTimer(metrics, Stage::kSketch);
+          auto dst = std::vector<StrandMinimizers>(last - first);
+          tbb::parallel_for(first, last,
+                            [&cache, &dst, first](std::uint32_t read_id) {
+                              auto const forward = cache->Forward(read_id);
+                              dst[read_id - first].forward.assign(
+                                  forward.begin(), forward.end());
+                            });
+
+          if (metrics) {
+            for (auto const& minimizers : dst) {
+              metrics->Add(Counter::kMinimizers, minimizers.forward.size());
+            }
+          }
+
+          return dst;
+        },
+        [&cache, &frequent, metrics](
+            std::uint32_t first,
+            std::span<StrandMinimizers const> minimizers) -> Index {
+          auto const last =
+              static_cast<std::uint32_t>(first + minimizers.size());
+          if (auto index = cache->FindIndex(first, last)) {
+            return std::move(*index);
+          }
+
+          auto target_minimizers = std::vector<StrandMinimizers>(last - first);
+          for (auto read_id = first; read_id < last; ++read_id) {
+            auto const rc = cache->ReverseComplement(read_id);
+            target_minimizers[read_id - first].reverse_complement.assign(
+                rc.begin(), rc.end());
+          }
+
+          return CreateRcKMerIndex(first, target_minimizers, *frequent,
+                                   metrics);
+        });
+
+    // names point into the mapping, which the copy keeps alive
+    return NameOverlaps(
+        ovlps, std::make_shared<SketchCache const>(*cache),
+        [&cache](std::uint32_t read_id) { return cache->Name(read_id); });
+  }
+
+  fmt::print(stderr, "[sniff::FindReverseComplementPairs] building cache: {}\n",
+             cache_path.string());
+
+  // the key names the input as given, reads come from the seekable copy
+  auto const input = OpenSeekableInput(reads_path, metrics);
+  auto const& input_path = input.Path();
+  auto frequent = std::unique_ptr<FrequentKMers>();
+  auto const shared_locations =
+      std::make_shared<std::vector<ReadLocation> const>(
+          LocateAndSortReads(cfg, input_path, &frequent, metrics));
+  auto const& locations = *shared_locations;
+
+  auto read_lens = std::vector<std::uint32_t>(locations.size());
+  auto names = std::vector<std::string_view>(locations.size());
+  for (std::size_t idx = 0; idx < locations.size(); ++idx) {
+    read_lens[idx] = locations[idx].length;
+    names[idx] = locations[idx].name;
+  }
+
+  auto writer = SketchCacheWriter(cache_path, key);
+  writer.WriteReads(read_lens, names);
+  writer.WriteFrequentKMers(*frequent);
+
+  // both callbacks run in the serial stage preparing batches, so the writer
+  // sees reads and indexes in order
+  auto const ovlps = FindBestOverlaps(
+      cfg, read_lens, *frequent, metrics,
+      [&cfg, &input_path, &locations, &writer, metrics](
+          std::uint32_t first,
+          std::uint32_t last) -> std::vector<StrandMinimizers> {
+        auto dst = LoadAndMinimizeReads(cfg, input_path, locations, first,
+                                        last, metrics);
+        writer.WriteMinimizers(first, dst);
+        return dst;
+      },
+      [&writer, &frequent, metrics](
+          std::uint32_t first,
+          std::span<StrandMinimizers const> minimizers) -> Index {
+        auto dst = CreateRcKMerIndex(first, minimizers, *frequent, metrics);
+        writer.WriteIndex(first, first + minimizers.size(), dst);
+        return dst;
+      });
+
+  writer.Finish();
+
+  return NameOverlaps(ovlps, shared_locations,
+                      [&locations](std::uint32_t read_id) {
+                        return std::string_view(locations[read_id].name);
+                      });
+}
+
+auto FindReverseComplementPairs(Config const& cfg, CountedReads counted,
+                                std::shared_ptr<RunState> state,
+                                Metrics* metrics) -> NamedOverlaps {
+  if (state->KMerLength() != cfg.kmer_len ||
+      state->WindowLength() != cfg.window_len ||
+      state->IsCanonical() != cfg.canonical ||
+      state->SeedingScheme() != cfg.seeding ||
+      state->SyncmerLength() != cfg.syncmer_len ||
+      state->FilterFrequency() != cfg.filter_freq) {
+    throw std::invalid_argument(
+        "[sniff::FindReverseComplementPairs] state was built with another k, "
+        "w, strand mode, seeding or frequent k-mer filter");
+  }
+
+  auto const reads = [&counted, metrics]() -> ReadStore {
+    auto const stage_timer = StageTimer(metrics, Stage::kSort);
+    return SortReads(counted.reads);
+  }();
+
+  auto timer = biosoup::Timer{};
+  timer.Start();
+
+  // new reads are added after the ones of earlier runs, in length order
+  auto const first_new = static_cast<std::uint32_t>(state->size());
+  auto const new_lens = reads.Lengths();
+  auto read_lens = std::vector<std::uint32_t>(state->Lengths().begin(),
+                                              state->Lengths().end());
+  read_lens.insert(read_lens.end(), new_lens.begin(), new_lens.end());
+  if (metrics) {
+    metrics->Add(Counter::kReads, new_lens.size());
+    metrics->Add(Counter::kBases, std::accumulate(new_lens.begin(),
+                                                  new_lens.end(),
+                                                  std::uint64_t(0)));
+  }
+
+  // k-mers of earlier runs count along with the new ones; the kept counts
+  // are added in as they are unless the new reads make them outgrow their
+  // size, in which case the earlier reads are counted again at the size the
+  // new counts were made for. Sizes double, so reads are counted again about
+  // twice on average as runs go on.
+  auto frequent = std::move(counted.frequent);
+  if (auto const* kept = state->Frequent()) {
+    if (kept->BlockBits() < FrequentKMers::BlockBits(kept->NumKMers() +
+                                                     frequent->NumKMers())) {
+      fmt::print(stderr,
+                 "[FindReverseComplementPairs] counting k-mers of {} earlier "
+                 "reads again\n",
+                 first_new);
+      tbb::parallel_for(
+          std::uint32_t(0), first_new,
+          [&state, &frequent, metrics](std::uint32_t read_id) {
+            auto const timer = StageTimer(metrics, Stage::kThreshold);
+            frequent->Add(state->Minimizers(read_id));
+          });
+    } else {
+      frequent->Add(*kept);
+    }
+  }
+  FinishCounting(cfg, frequent.get());
+
+  auto best_pairs = BestPairs(read_lens.size());
+  for (auto const& ovlp : state->Candidates()) {
+    best_pairs.Update(ovlp);
+  }
+  auto thread_buffers = ThreadMappingBuffers();
+
+  auto by_length = std::vector<std::uint32_t>(read_lens.size());
+  std::iota(by_length.begin(), by_length.end(), 0);
+  std::stable_sort(by_length.begin(), by_length.end(),
+                   [&read_lens](std::uint32_t lhs, std::uint32_t rhs) -> bool {
+                     return read_lens[lhs] < read_lens[rhs];
+                   });
+
+  auto const min_ratio = 1.0 - cfg.alpha_p;
+  auto const scale_len = [min_ratio](std::uint32_t read_len) -> std::uint32_t {
+    return read_len * min_ratio;
+  };
+
+  // windows are sized as in full runs, the stored sketches of earlier runs
+  // being part of what the process already holds
+  auto batch_sizer = BatchSizer(cfg, read_lens.size());
+  if (batch_sizer.IsBudgeted()) {
+    fmt::print(stderr,
+               "[FindReverseComplementPairs] batch memory budget: {:.3f} GB; "
+               "first batch: {} bases\n",
+               batch_sizer.Budget() / 1e9, batch_sizer.MaxBases());
+  }
+
+  for (auto first = std::uint32_t(0); first < new_lens.size();) {
+    auto const last =
+        FindBatchEnd(new_lens, first, batch_sizer.MaxBases(), scale_len);
+
+    auto minimizers = MinimizeReads(cfg, reads, first, last, metrics);
+    auto n_bases = std::uint64_t(0);
+    auto n_minimizers = std::uint64_t(0);
+    for (auto read_id = first; read_id < last; ++read_id) {
+      n_bases += reads.Length(read_id);
+      n_minimizers += minimizers[read_id - first].forward.size();
+      state->Append(reads.Name(read_id), reads.Length(read_id),
+                    minimizers[read_id - first].forward);
+    }
+    batch_sizer.Observe(n_bases, n_minimizers);
+
+    auto index = Index();
+    {
+      auto const stage_timer = StageTimer(metrics, Stage::kIndex);
+      index = CreateRcKMerIndex(first_new + first, minimizers, *frequent,
+                                metrics);
+    }
+
+    // queries are all sketched reads whose length can pair up with one of the
+    // window's; mapping only keeps pairs whose query has the lower id
+    auto const min_len = std::floor(new_lens[first] * min_ratio);
+    auto const max_len = min_ratio > 0
+                             ? new_lens[last - 1] / min_ratio
+                             : std::numeric_limits<double>::max();
+    auto queries = std::vector<Sketch>();
+    for (auto it = std::partition_point(
+             by_length.begin(), by_length.end(),
+             [&read_lens, min_len](std::uint32_t read_id) -> bool {
+               return read_lens[read_id] < min_len;
+             });
+         it != by_length.end() && read_lens[*it] <= max_len; ++it) {
+      if (*it < first_new + last) {
+        auto const kmers = state->Minimizers(*it);
+        queries.push_back(Sketch{
+            .read_id = *it,
+            .minimizers = std::vector<KMer>(kmers.begin(), kmers.end())});
+      }
+    }
+
+    MapSpanToIndex(cfg, read_lens, queries, index, true, &best_pairs,
+                   thread_buffers, metrics);
+
+    fmt::print(stderr, "\r[FindReverseComplementPairs]({:12.3f}) {:2.3f}%",
+               timer.Lap(), 100. * last / new_lens.size());
+    first = last;
+  }
+
+  auto const stage_timer = StageTimer(metrics, Stage::kMerge);
+  auto candidates = std::vector<Overlap>(state->Candidates().begin(),
+                                         state->Candidates().end());
+  for (auto const& buffers : thread_buffers) {
+    candidates.insert(candidates.end(), buffers.overlaps.begin(),
+                      buffers.overlaps.end());
+  }
+  std::erase_if(candidates, [&best_pairs](Overlap const& ovlp) -> bool {
+    return !best_pairs.IsBestOfEither(ovlp);
+  });
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  auto ovlps = std::vector<Overlap>();
+  std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(ovlps),
+               [&best_pairs](Overlap const& ovlp) -> bool {
+                 return best_pairs.IsBest(ovlp);
+               });
+  state->SetCandidates(std::move(candidates));
+  state->SetFrequent(std::move(frequent));
+
+  fmt::print(stderr, "\n[FindReverseComplementPairs]({:12.3f}) n pairs: {}\n",
+             timer.Stop(), ovlps.size());
+
+  auto const& names = *state;
+  return NameOverlaps(ovlps, std::move(state), [&names](std::uint32_t read_id) {
+    return names.Name(read_id);
+  });
+}
+
+auto FindReverseComplementPairs(Config const& cfg, ReadStore reads,
+                                std::shared_ptr<RunState> state,
+                                Metrics* metrics) -> NamedOverlaps {
+  auto counted = CountLoadedReads(cfg, std::move(reads), KeptKMers(*state),
+                                  metrics);
+  return FindReverseComplementPairs(cfg, std::move(counted), std::move(state),
+                                    metrics);
+}
+
+auto FindShardCandidates(Config const& cfg, CountedReads reads,
+                         Metrics* metrics) -> ShardCandidates {
+  auto ovlps = FindOverlapsInMemory(cfg, &reads, metrics);
+  return CreateShardCandidates(cfg, reads.reads.size(), std::move(ovlps),
+                               [&reads](std::uint32_t read_id) {
+                                 return reads.reads.Name(read_id);
+                               });
+}
+
+auto FindShardCandidates(Config const& cfg, ReadStore reads,
+                         Metrics* metrics) -> ShardCandidates {
+  return FindShardCandidates(
+      cfg, CountLoadedReads(cfg, std::move(reads), 0, metrics), metrics);
+}
+
+auto FindShardCandidates(Config const& cfg,
+                         std::filesystem::path const& reads_path,
+                         Metrics* metrics) -> ShardCandidates {
+  auto const input = OpenSeekableInput(reads_path, metrics);
+  auto frequent = std::unique_ptr<FrequentKMers>();
+  auto const locations =
+      LocateAndSortReads(cfg, input.Path(), &frequent, metrics);
+  auto ovlps = FindOverlapsStreaming(cfg, input.Path(), locations, *frequent,
+                                     metrics);
+  return CreateShardCandidates(cfg, locations.size(), std::move(ovlps),
+                               [&locations](std::uint32_t read_id) {
+                                 return locations[read_id].name;
+                               });
+}
+
 }  // namespace sniff
@@ -0,0 +1,50 @@
+#include "sniff/best_pairs.h"
+
+#include <bit>
+
+// scores are positive so their float bits order like the values
+static auto Pack(double score, std::uint32_t partner_id) -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+             std::bit_cast<std::uint32_t>(static_cast<float>(score)))
+             << 32U |
+         partner_id;
+}
+
+static auto RaiseTo(std::atomic<std::uint64_t>& best, std::uint64_t val)
+    -> bool {
+  auto curr = best.load(std::memory_order_relaxed);
+  while (curr < val) {
+    if (best.compare_exchange_weak(curr, val, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+namespace sniff {
+
+auto BestPairs::Update(Overlap const& ovlp) -> bool {
+  auto const is_query_best =
+      RaiseTo(best_[ovlp.query_id], Pack(ovlp.score, ovlp.target_id));
+  auto const is_target_best =
+      RaiseTo(best_[ovlp.target_id], Pack(ovlp.score, ovlp.query_id));
+
+  return is_query_best && is_target_best;
+}
+
+auto BestPairs::IsBest(Overlap const& ovlp) const -> bool {
+  return best_[ovlp.query_id].load(std::memory_order_relaxed) ==
+             Pack(ovlp.score, ovlp.target_id) &&
+         best_[ovlp.target_id].load(std::memory_order_relaxed) ==
+             Pack(ovlp.score, ovlp.query_id);
+}
+
+auto BestPairs::IsBestOfEither(Overlap const& ovlp) const -> bool {
+  return best_[ovlp.query_id].load(std::memory_order_relaxed) ==
+             Pack(ovlp.score, ovlp.target_id) ||
+         best_[ovlp.target_id].load(std::memory_order_relaxed) ==
+             Pack(ovlp.score, ovlp.query_id);
+}
+
+}  // namespace sniff
@@ -0,0 +1,457 @@
+#include "sniff/cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+static constexpr auto kMagic =
+    std::array<char, 8>{'S', 'N', 'I', 'F', 'F', 'S', 'K', 'C'};
+static constexpr auto kVersion = std::uint32_t(5);
+
+// sections are aligned so they can be used in place once mapped
+static constexpr auto kAlignment = std::uint64_t(8);
+
+struct CacheHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t kmer_len;
+  std::uint32_t window_len;
+  std::uint32_t canonical;
+  std::uint32_t seeding;
+  std::uint32_t syncmer_len;
+  double filter_freq;
+  std::uint64_t input_size;
+  std::int64_t input_mtime;
+  std::uint64_t contents_offset;
+};
+
+struct CacheContents {
+  std::uint64_t n_reads;
+  std::uint64_t lengths_offset;
+  std::uint64_t name_offsets_offset;
+  std::uint64_t names_offset;
+  std::uint64_t names_size;
+
+  std::uint64_t n_sketched;
+  std::uint64_t minimizers_offset;
+  std::uint64_t n_indexes;
+  std::uint64_t indexes_offset;
+
+  std::uint32_t frequent_block_bits;
+  std::uint32_t frequent_threshold;
+  std::uint64_t n_frequent_kmers;
+  std::uint64_t frequent_cells_offset;
+  std::uint64_t n_frequent_cells;
+};
+
+namespace sniff {
+
+struct MappedFile {
+  MappedFile(void const* data, std::size_t size) : data(data), size(size) {}
+
+  MappedFile(MappedFile const&) = delete;
+  auto operator=(MappedFile const&) -> MappedFile& = delete;
+
+  ~MappedFile() { munmap(const_cast<void*>(data), size); }
+
+  template <class T>
+  auto At(std::uint64_t offset) const -> T const* {
+    return reinterpret_cast<T const*>(static_cast<char const*>(data) + offset);
+  }
+
+  // Whether n elements of type T starting at offset lie within the file and
+  // are aligned for T.
+  template <class T>
+  auto Contains(std::uint64_t offset, std::uint64_t n) const -> bool {
+    return offset % alignof(T) == 0 && offset <= size &&
+           n <= (size - offset) / sizeof(T);
+  }
+
+  void const* data;
+  std::size_t size;
+};
+
+auto CreateCacheKey(MinimizeConfig const& cfg, double filter_freq,
+                    std::filesystem::path const& input_path) -> CacheKey {
+  return CacheKey{.kmer_len = cfg.kmer_len,
+                  .window_len = cfg.window_len,
+                  .canonical = cfg.canonical,
+                  .seeding = cfg.seeding,
+                  .syncmer_len = cfg.syncmer_len,
+                  .filter_freq = filter_freq,
+                  .input_size = std::filesystem::file_size(input_path),
+                  .input_mtime = static_cast<std::int64_t>(
+                      std::filesystem::last_write_time(input_path)
+                          .time_since_epoch()
+                          .count())};
+}
+
+auto SketchCache::Open(std::filesystem::path const& path, CacheKey const& key)
+    -> std::optional<SketchCache> {
+  auto const fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return std::nullopt;
+  }
+
+  struct stat file_stat;
+  auto const is_stat = fstat(fd, &file_stat) == 0;
+  auto const size = static_cast<std::size_t>(file_stat.st_size);
+  if (!is_stat || size < sizeof(CacheHeader)) {
+    close(fd);
+    return std::nullopt;
+  }
+
+  auto* const data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return std::nullopt;
+  }
+
+  auto file = std::make_shared<MappedFile const>(data, size);
+  auto const& header = *file->At<CacheHeader>(0);
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.kmer_len != key.kmer_len || header.window_len != key.window_len ||
+      (header.canonical != 0) != key.canonical ||
+      header.seeding != static_cast<std::uint32_t>(key.seeding) ||
+      header.syncmer_len != key.syncmer_len ||
+      header.filter_freq != key.filter_freq ||
+      header.input_size != key.input_size ||
+      header.input_mtime != key.input_mtime ||
+      !file->Contains<CacheContents>(header.contents_offset, 1)) {
+    return std::nullopt;
+  }
+
+  auto const& contents = *file->At<CacheContents>(header.contents_offset);
+  if (!file->Contains<std::uint32_t>(contents.lengths_offset,
+                                     contents.n_reads) ||
+      !file->Contains<std::uint64_t>(contents.name_offsets_offset,
+                                     contents.n_reads + 1) ||
+      !file->Contains<char>(contents.names_offset, contents.names_size) ||
+      contents.n_sketched > contents.n_reads ||
+      !file->Contains<CachedMinimizers>(contents.minimizers_offset,
+                                        contents.n_reads) ||
+      !file->Contains<CachedIndex>(contents.indexes_offset,
+                                   contents.n_indexes) ||
+      !file->Contains<std::uint16_t>(contents.frequent_cells_offset,
+                                     contents.n_frequent_cells)) {
+    return std::nullopt;
+  }
+
+  auto const frequent = FrequentKMerCounts{
+      .block_bits = contents.frequent_block_bits,
+      .threshold = contents.frequent_threshold,
+      .n_kmers = contents.n_frequent_kmers,
+      .cells =
+          std::span(file->At<std::uint16_t>(contents.frequent_cells_offset),
+                    contents.n_frequent_cells)};
+  if (!FrequentKMers::IsValid(frequent)) {
+    return std::nullopt;
+  }
+
+  auto dst = SketchCache();
+  dst.lengths_ = std::span(file->At<std::uint32_t>(contents.lengths_offset),
+                           contents.n_reads);
+  dst.name_offsets_ =
+      std::span(file->At<std::uint64_t>(contents.name_offsets_offset),
+                contents.n_reads + 1);
+  dst.names_ = std::string_view(file->At<char>(contents.names_offset),
+                                contents.names_size);
+  dst.n_sketched_ = static_cast<std::uint32_t>(contents.n_sketched);
+  dst.minimizers_ =
+      std::span(file->At<CachedMinimizers>(contents.minimizers_offset),
+                contents.n_reads);
+  dst.indexes_ = std::span(file->At<CachedIndex>(contents.indexes_offset),
+                           contents.n_indexes);
+
+  // validate everything accessors index into, so a truncated or corrupted
+  // file is rebuilt instead of read out of bounds
+  auto const is_valid_read = [&file, &dst](std::size_t idx) -> bool {
+    auto const& minimizers = dst.minimizers_[idx];
+    return dst.name_offsets_[idx] <= dst.name_offsets_[idx + 1] &&
+           dst.name_offsets_[idx + 1] <= dst.names_.size() &&
+           file->Contains<KMer>(minimizers.offset,
+                                std::uint64_t(minimizers.n_forward) +
+                                    minimizers.n_reverse_complement);
+  };
+
+  // FindTargets reads the entries between two consecutive buckets, the
+  // entry after the last of them, and the targets between two consecutive
+  // entries; the last entry only marks the end of the targets
+  auto const is_valid_index = [&file, &dst](CachedIndex const& index) -> bool {
+    if (index.first > index.last || index.last > dst.size() ||
+        index.bucket_bits == 0 || index.bucket_bits > 32 ||
+        index.n_buckets != (std::uint64_t(1) << index.bucket_bits) + 1 ||
+        index.n_entries == 0 ||
+        !file->Contains<std::uint32_t>(index.buckets_offset,
+                                       index.n_buckets) ||
+        !file->Contains<IndexEntry>(index.entries_offset, index.n_entries) ||
+        !file->Contains<Target>(index.targets_offset, index.n_targets)) {
+      return false;
+    }
+
+    auto const buckets = std::span(
+        file->At<std::uint32_t>(index.buckets_offset), index.n_buckets);
+    if (!std::is_sorted(buckets.begin(), buckets.end()) ||
+        buckets.back() >= index.n_entries) {
+      return false;
+    }
+
+    auto const entries = std::span(
+        file->At<IndexEntry>(index.entries_offset), index.n_entries);
+    for (std::size_t idx = 0; idx + 1 < entries.size(); ++idx) {
+      if (entries[idx].offset >= entries[idx + 1].offset) {
+        return false;
+      }
+    }
+    if (entries.back().offset != index.n_targets) {
+      return false;
+    }
+
+    auto const targets = std::span(file->At<Target>(index.targets_offset),
+                                   index.n_targets);
+    return std::all_of(targets.begin(), targets.end(),
+                       [&index](Target const& target) -> bool {
+                         return target.read_id >= index.first &&
+                                target.read_id < index.last;
+                       });
+  };
+
+  for (std::size_t idx = 0; idx < dst.size(); ++idx) {
+    if (!is_valid_read(idx)) {
+      return std::nullopt;
+    }
+  }
+
+  if (!std::all_of(dst.indexes_.begin(), dst.indexes_.end(),
+                   is_valid_index)) {
+    return std::nullopt;
+  }
+
+  dst.frequent_ = std::make_shared<FrequentKMers const>(frequent);
+  dst.file_ = std::move(file);
+  return dst;
+}
+
+auto SketchCache::Name(std::uint32_t read_id) const -> std::string_view {
+  return names_.substr(name_offsets_[read_id],
+                       name_offsets_[read_id + 1] - name_offsets_[read_id]);
+}
+
+auto SketchCache::Forward(std::uint32_t read_id) const
+    -> std::span<KMer const> {
+  auto const& entry = minimizers_[read_id];
+  return std::span(file_->At<KMer>(entry.offset), entry.n_forward);
+}
+
+auto SketchCache::ReverseComplement(std::uint32_t read_id) const
+    -> std::span<KMer const> {
+  auto const& entry = minimizers_[read_id];
+  return std::span(file_->At<KMer>(entry.offset) + entry.n_forward,
+                   entry.n_reverse_complement);
+}
+
+auto SketchCache::FindIndex(std::uint32_t first, std::uint32_t last) const
+    -> std::optional<Index> {
+  auto const it = std::find_if(indexes_.begin(), indexes_.end(),
+                               [first, last](CachedIndex const& index) {
+                                 return index.first == first &&
+                                        index.last == last;
+                               });
+  if (it == indexes_.end()) {
+    return std::nullopt;
+  }
+
+  return Index{
+      .bucket_bits = it->bucket_bits,
+      .buckets = std::span(file_->At<std::uint32_t>(it->buckets_offset),
+                           it->n_buckets),
+      .entries = std::span(file_->At<IndexEntry>(it->entries_offset),
+                           it->n_entries),
+      .targets = std::span(file_->At<Target>(it->targets_offset),
+                           it->n_targets),
+      .storage = file_};
+}
+
+SketchCacheWriter::SketchCacheWriter(std::filesystem::path path,
+                                     CacheKey const& key)
+    : path_(std::move(path)),
+      tmp_path_(path_.string() + ".tmp"),
+      file_(tmp_path_, std::ios::binary | std::ios::trunc),
+      key_(key) {
+  if (!file_) {
+    throw std::runtime_error(
+        "[sniff::SketchCacheWriter] failed to open: " + tmp_path_.string());
+  }
+
+  // rewritten by Finish once the contents are known
+  auto const header = CacheHeader();
+  Write(&header, sizeof(header));
+}
+
+SketchCacheWriter::~SketchCacheWriter() {
+  if (!is_finished_) {
+    file_.close();
+    auto ec = std::error_code();
+    std::filesystem::remove(tmp_path_, ec);
+  }
+}
+
+auto SketchCacheWriter::WriteReads(std::span<std::uint32_t const> lengths,
+                                   std::span<std::string_view const> names)
+    -> void {
+  if (lengths.size() != names.size()) {
+    throw std::invalid_argument(
+        "[sniff::SketchCacheWriter::WriteReads] lengths and names differ in "
+        "size");
+  }
+
+  Align();
+  lengths_offset_ = Write(lengths.data(), lengths.size_bytes());
+
+  auto name_offsets = std::vector<std::uint64_t>(names.size() + 1, 0);
+  for (std::size_t idx = 0; idx < names.size(); ++idx) {
+    name_offsets[idx + 1] = name_offsets[idx] + names[idx].size();
+  }
+
+  Align();
+  name_offsets_offset_ =
+      Write(name_offsets.data(), name_offsets.size() * sizeof(std::uint64_t));
+
+  names_offset_ = offset_;
+  names_size_ = name_offsets.back();
+  for (auto const name : names) {
+    Write(name.data(), name.size());
+  }
+
+  minimizers_.assign(lengths.size(), CachedMinimizers{});
+}
+
+auto SketchCacheWriter::WriteMinimizers(
+    std::uint32_t first_id, std::span<StrandMinimizers const> minimizers)
+    -> void {
+  if (first_id != n_sketched_ ||
+      first_id + minimizers.size() > minimizers_.size()) {
+    throw std::invalid_argument(
+        "[sniff::SketchCacheWriter::WriteMinimizers] reads have to be "
+        "written in consecutive ranges");
+  }
+
+  Align();
+  for (auto const& read_minimizers : minimizers) {
+    auto const& forward = read_minimizers.forward;
+    auto const& reverse_complement = read_minimizers.reverse_complement;
+    minimizers_[n_sketched_++] = CachedMinimizers{
+        .offset = offset_,
+        .n_forward = static_cast<std::uint32_t>(forward.size()),
+        .n_reverse_complement =
+            static_cast<std::uint32_t>(reverse_complement.size())};
+
+    Write(forward.data(), forward.size() * sizeof(KMer));
+    Write(reverse_complement.data(),
+          reverse_complement.size() * sizeof(KMer));
+  }
+}
+
+auto SketchCacheWriter::WriteIndex(std::uint32_t first, std::uint32_t last,
+                                   Index const& index) -> void {
+  auto dst = CachedIndex{.first = first,
+                         .last = last,
+                         .bucket_bits = index.bucket_bits,
+                         .padding = 0,
+                         .n_buckets = index.buckets.size(),
+                         .n_entries = index.entries.size(),
+                         .n_targets = index.targets.size()};
+
+  Align();
+  dst.buckets_offset = Write(index.buckets.data(), index.buckets.size_bytes());
+  Align();
+  dst.entries_offset = Write(index.entries.data(), index.entries.size_bytes());
+  Align();
+  dst.targets_offset = Write(index.targets.data(), index.targets.size_bytes());
+
+  indexes_.push_back(dst);
+}
+
+auto SketchCacheWriter::WriteFrequentKMers(FrequentKMers const& frequent)
+    -> void {
+  auto const cells = frequent.Cells();
+  frequent_block_bits_ = frequent.BlockBits();
+  frequent_threshold_ = frequent.Threshold();
+  n_frequent_kmers_ = frequent.NumKMers();
+  n_frequent_cells_ = cells.size();
+
+  Align();
+  frequent_cells_offset_ =
+      Write(cells.data(), cells.size() * sizeof(std::uint16_t));
+}
+
+auto SketchCacheWriter::Finish() -> void {
+  if (n_frequent_cells_ == 0) {
+    throw std::invalid_argument(
+        "[sniff::SketchCacheWriter::Finish] frequent k-mer counts were not "
+        "written");
+  }
+
+  auto contents = CacheContents{
+      .n_reads = minimizers_.size(),
+      .lengths_offset = lengths_offset_,
+      .name_offsets_offset = name_offsets_offset_,
+      .names_offset = names_offset_,
+      .names_size = names_size_,
+      .n_sketched = n_sketched_,
+      .n_indexes = indexes_.size(),
+      .frequent_block_bits = frequent_block_bits_,
+      .frequent_threshold = frequent_threshold_,
+      .n_frequent_kmers = n_frequent_kmers_,
+      .frequent_cells_offset = frequent_cells_offset_,
+      .n_frequent_cells = n_frequent_cells_};
+
+  Align();
+  contents.minimizers_offset =
+      Write(minimizers_.data(), minimizers_.size() * sizeof(CachedMinimizers));
+  contents.indexes_offset =
+      Write(indexes_.data(), indexes_.size() * sizeof(CachedIndex));
+
+  auto header = CacheHeader{.magic = kMagic,
+                            .version = kVersion,
+                            .kmer_len = key_.kmer_len,
+                            .window_len = key_.window_len,
+                            .canonical = key_.canonical,
+                            .seeding = static_cast<std::uint32_t>(key_.seeding),
+                            .syncmer_len = key_.syncmer_len,
+                            .filter_freq = key_.filter_freq,
+                            .input_size = key_.input_size,
+                            .input_mtime = key_.input_mtime};
+  header.contents_offset = Write(&contents, sizeof(contents));
+
+  file_.seekp(0);
+  file_.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  file_.close();
+  if (!file_) {
+    throw std::runtime_error(
+        "[sniff::SketchCacheWriter::Finish] failed to write: " +
+        tmp_path_.string());
+  }
+
+  std::filesystem::rename(tmp_path_, path_);
+  is_finished_ = true;
+}
+
+auto SketchCacheWriter::Align() -> void {
+  static constexpr auto kZeros = std::array<char, kAlignment>{};
+  Write(kZeros.data(), (kAlignment - offset_ % kAlignment) % kAlignment);
+}
+
+auto SketchCacheWriter::Write(void const* data, std::size_t size)
+    -> std::uint64_t {
+  file_.write(static_cast<char const*>(data), size);
+  return std::exchange(offset_, offset_ + size);
+}
+
+}  // namespace sniff
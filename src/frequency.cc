@@ -0,0 +1,277 @@
+#include "sniff/frequency.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+static constexpr auto kNumRows = std::uint32_t(4);
+static constexpr auto kRowBits = std::uint32_t(3);
+static constexpr auto kNumBlockCells = std::size_t(kNumRows << kRowBits);
+static constexpr auto kMinBlockBits = std::uint32_t(10);
+static constexpr auto kMaxBlockBits = std::uint32_t(28);
+
+// distinct k-mers kept for picking the threshold
+static constexpr auto kSampleCap = std::size_t(1U << 20U);
+
+// sampled values are scattered into buckets by their top bits before sorting
+static constexpr auto kSortBucketBits = 10U;
+
+// k-mers seen once can not be frequent, however small the run
+static constexpr auto kMinThreshold = std::uint32_t(2);
+
+static auto MixValue(std::uint64_t val) -> std::uint64_t {
+  val ^= val >> 33U;
+  val *= 0xff51afd7ed558ccdULL;
+  val ^= val >> 33U;
+  val *= 0xc4ceb9fe1a85ec53ULL;
+  val ^= val >> 33U;
+  return val;
+}
+
+// Level l keeps the k-mers whose mixed value has its top l bits clear; each
+// level keeps half of the previous one.
+static auto IsSampled(std::uint64_t mixed, std::uint32_t level) -> bool {
+  return level == 0 || mixed >> (64U - level) == 0;
+}
+
+// Sorts mixed values sampled at level by scattering them into buckets by the
+// top bits left free by the level, which are evenly spread, and sorting each
+// bucket on its own.
+static auto SortSampled(std::uint32_t level, std::span<std::uint64_t> values)
+    -> void {
+  auto const bucket_of = [level](std::uint64_t mixed) -> std::size_t {
+    return level >= 64U ? 0 : (mixed << level) >> (64U - kSortBucketBits);
+  };
+
+  auto offsets = std::vector<std::size_t>((1U << kSortBucketBits) + 1U, 0);
+  for (auto const mixed : values) {
+    ++offsets[bucket_of(mixed) + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  auto scattered = std::vector<std::uint64_t>(values.size());
+  auto next = offsets;
+  for (auto const mixed : values) {
+    scattered[next[bucket_of(mixed)]++] = mixed;
+  }
+  for (std::size_t bucket = 0; bucket + 1 < offsets.size(); ++bucket) {
+    std::sort(scattered.begin() + offsets[bucket],
+              scattered.begin() + offsets[bucket + 1]);
+  }
+
+  std::copy(scattered.begin(), scattered.end(), values.begin());
+}
+
+// The top bits of the mixed value pick the block, the lowest ones a cell in
+// each of its rows.
+static auto CellOf(std::uint64_t mixed, std::uint32_t row) -> std::size_t {
+  return (row << kRowBits) |
+         ((mixed >> (row * kRowBits)) & ((1U << kRowBits) - 1U));
+}
+
+namespace sniff {
+
+FrequentKMers::FrequentKMers(std::uint64_t expected_kmers)
+    : block_bits_(BlockBits(expected_kmers)),
+      blocks_(std::size_t(1) << block_bits_) {}
+
+FrequentKMers::FrequentKMers(FrequentKMerCounts const& counts)
+    : block_bits_(counts.block_bits),
+      blocks_(IsValid(counts) ? std::size_t(1) << block_bits_ : 0),
+      n_kmers_(counts.n_kmers),
+      sample_level_(counts.sample_level),
+      sample_(counts.sample.begin(), counts.sample.end()),
+      n_sample_unique_(sample_.size()),
+      threshold_(counts.threshold) {
+  if (blocks_.empty()) {
+    throw std::invalid_argument("[sniff::FrequentKMers] invalid counts");
+  }
+
+  auto cell = counts.cells.begin();
+  for (auto& block : blocks_) {
+    for (auto& dst : block.cells) {
+      dst.store(*cell++, std::memory_order_relaxed);
+    }
+  }
+}
+
+auto FrequentKMers::IsValid(FrequentKMerCounts const& counts) -> bool {
+  return counts.block_bits >= kMinBlockBits &&
+         counts.block_bits <= kMaxBlockBits &&
+         counts.cells.size() ==
+             (std::size_t(1) << counts.block_bits) * kNumBlockCells &&
+         counts.sample_level <= 64 && counts.sample.size() <= kSampleCap &&
+         std::adjacent_find(counts.sample.begin(), counts.sample.end(),
+                            std::greater_equal<>()) == counts.sample.end() &&
+         (counts.sample.empty() ||
+          IsSampled(counts.sample.back(), counts.sample_level));
+}
+
+auto FrequentKMers::BlockBits(std::uint64_t n_kmers) -> std::uint32_t {
+  return std::clamp<std::uint32_t>(std::bit_width(n_kmers >> (kRowBits + 2U)),
+                                   kMinBlockBits, kMaxBlockBits);
+}
+
+auto FrequentKMers::Add(std::span<KMer const> kmers) -> void {
+  n_kmers_.fetch_add(kmers.size(), std::memory_order_relaxed);
+
+  auto const level = sample_level_.load(std::memory_order_relaxed);
+  auto sampled = std::vector<std::uint64_t>();
+  for (auto const& kmer : kmers) {
+    auto const mixed = MixValue(kmer.value);
+    auto& block = blocks_[mixed >> (64U - block_bits_)];
+    for (std::uint32_t row = 0; row < kNumRows; ++row) {
+      auto& cell = block.cells[CellOf(mixed, row)];
+      auto count = cell.load(std::memory_order_relaxed);
+      while (count != UINT16_MAX &&
+             !cell.compare_exchange_weak(count, count + 1,
+                                         std::memory_order_relaxed)) {
+      }
+    }
+
+    if (IsSampled(mixed, level)) {
+      sampled.push_back(mixed);
+    }
+  }
+
+  if (sampled.empty()) {
+    return;
+  }
+
+  auto const lock = std::scoped_lock(sample_mutex_);
+  auto const current_level = sample_level_.load(std::memory_order_relaxed);
+  std::copy_if(sampled.begin(), sampled.end(), std::back_inserter(sample_),
+               [current_level](std::uint64_t mixed) {
+                 return IsSampled(mixed, current_level);
+               });
+  if (sample_.size() >= 2 * std::max(n_sample_unique_, kSampleCap)) {
+    ShrinkSample();
+  }
+}
+
+auto FrequentKMers::Add(FrequentKMers const& other) -> void {
+  Fold(other.block_bits_);
+
+  auto const shift = other.block_bits_ - block_bits_;
+  for (std::size_t idx = 0; idx < other.blocks_.size(); ++idx) {
+    auto& block = blocks_[idx >> shift];
+    for (std::size_t cell = 0; cell < block.cells.size(); ++cell) {
+      auto const sum =
+          block.cells[cell].load(std::memory_order_relaxed) +
+          other.blocks_[idx].cells[cell].load(std::memory_order_relaxed);
+      block.cells[cell].store(std::min<std::uint32_t>(sum, UINT16_MAX),
+                              std::memory_order_relaxed);
+    }
+  }
+  n_kmers_.fetch_add(other.NumKMers(), std::memory_order_relaxed);
+
+  // values are kept at the higher of the two levels, as ShrinkSample would
+  auto const level = std::max(SampleLevel(), other.SampleLevel());
+  sample_level_.store(level, std::memory_order_relaxed);
+  sample_.insert(sample_.end(), other.sample_.begin(), other.sample_.end());
+  std::erase_if(sample_, [level](std::uint64_t mixed) {
+    return !IsSampled(mixed, level);
+  });
+  n_sample_unique_ = 0;  // sort the merged sample afresh
+  ShrinkSample();
+}
+
+auto FrequentKMers::Fold(std::uint32_t block_bits) -> void {
+  if (block_bits >= block_bits_) {
+    return;
+  }
+
+  // saturated cells stay saturated, so adding up saturated sums is exact
+  auto const shift = block_bits_ - block_bits;
+  auto folded = std::vector<Block>(std::size_t(1) << block_bits);
+  for (std::size_t idx = 0; idx < blocks_.size(); ++idx) {
+    auto& block = folded[idx >> shift];
+    for (std::size_t cell = 0; cell < block.cells.size(); ++cell) {
+      auto const sum = block.cells[cell].load(std::memory_order_relaxed) +
+                       blocks_[idx].cells[cell].load(std::memory_order_relaxed);
+      block.cells[cell].store(std::min<std::uint32_t>(sum, UINT16_MAX),
+                              std::memory_order_relaxed);
+    }
+  }
+
+  blocks_.swap(folded);
+  block_bits_ = block_bits;
+}
+
+auto FrequentKMers::ShrinkSample() -> void {
+  // the first n_sample_unique_ values are still sorted and unique from the
+  // last call, so only the values added since are sorted
+  auto const added = sample_.begin() + n_sample_unique_;
+  SortSampled(sample_level_.load(std::memory_order_relaxed),
+              {added, sample_.end()});
+  std::inplace_merge(sample_.begin(), added, sample_.end());
+  sample_.erase(std::unique(sample_.begin(), sample_.end()), sample_.end());
+
+  // raising the level only ever drops k-mers the final sample would drop too,
+  // so the sample does not depend on the order k-mers came in; the values a
+  // level keeps are a prefix of the sorted sample
+  while (sample_.size() > kSampleCap) {
+    auto const level = sample_level_.load(std::memory_order_relaxed) + 1;
+    sample_level_.store(level, std::memory_order_relaxed);
+    sample_.erase(std::partition_point(sample_.begin(), sample_.end(),
+                                       [level](std::uint64_t mixed) {
+                                         return IsSampled(mixed, level);
+                                       }),
+                  sample_.end());
+  }
+  n_sample_unique_ = sample_.size();
+}
+
+auto FrequentKMers::Finish(double freq) -> void {
+  Fold(BlockBits(NumKMers()));
+  ShrinkSample();
+  if (sample_.size() <= 2) {
+    return;
+  }
+
+  auto counts = std::vector<std::uint32_t>(sample_.size());
+  std::transform(sample_.begin(), sample_.end(), counts.begin(),
+                 [this](std::uint64_t mixed) { return CountMixed(mixed); });
+
+  auto const idx = std::min(
+      static_cast<std::size_t>(counts.size() * (1. - freq)), counts.size() - 1);
+  std::nth_element(counts.begin(), counts.begin() + idx, counts.end());
+  threshold_ = std::max(counts[idx], kMinThreshold);
+}
+
+auto FrequentKMers::Count(std::uint64_t value) const -> std::uint32_t {
+  return CountMixed(MixValue(value));
+}
+
+auto FrequentKMers::CountMixed(std::uint64_t mixed) const -> std::uint32_t {
+  auto const& block = blocks_[mixed >> (64U - block_bits_)];
+  auto dst = std::uint32_t(UINT16_MAX);
+  for (std::uint32_t row = 0; row < kNumRows; ++row) {
+    dst = std::min<std::uint32_t>(
+        dst, block.cells[CellOf(mixed, row)].load(std::memory_order_relaxed));
+  }
+
+  return dst;
+}
+
+auto FrequentKMers::Cells() const -> std::vector<std::uint16_t> {
+  auto dst = std::vector<std::uint16_t>();
+  dst.reserve(SizeBytes() / sizeof(std::uint16_t));
+  for (auto const& block : blocks_) {
+    for (auto const& cell : block.cells) {
+      dst.push_back(cell.load(std::memory_order_relaxed));
+    }
+  }
+
+  return dst;
+}
+
+auto FrequentKMers::SizeBytes() const -> std::size_t {
+  return blocks_.size() * sizeof(Block);
+}
+
+}  // namespace sniff
@@ -0,0 +1,195 @@
+#include "sniff/gzip.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr auto kHeaderSize = std::size_t(10);
+static constexpr auto kTrailerSize = std::size_t(8);
+static constexpr auto kInflateStep = std::size_t(1U << 18U);  // 256 KiB
+
+static constexpr auto kFlagExtra = std::uint8_t(1U << 2U);
+static constexpr auto kFlagReserved = std::uint8_t(0xe0);
+
+static auto ByteAt(std::span<char const> data, std::size_t offset)
+    -> std::uint32_t {
+  return static_cast<std::uint8_t>(data[offset]);
+}
+
+// Size of the BGZF block which starts at data, or 0 if it is not one; BGZF
+// stores it in a "BC" extra subfield.
+static auto BgzfBlockSize(std::span<char const> data) -> std::size_t {
+  if (data.size() < kHeaderSize + 8 || ByteAt(data, 0) != 0x1f ||
+      ByteAt(data, 1) != 0x8b || !(ByteAt(data, 3) & kFlagExtra)) {
+    return 0;
+  }
+
+  auto const extra_len = ByteAt(data, 10) | ByteAt(data, 11) << 8U;
+  auto const extra_end = std::min(kHeaderSize + 2 + extra_len, data.size());
+  for (auto offset = kHeaderSize + 2; offset + 4 <= extra_end;) {
+    auto const len = ByteAt(data, offset + 2) | ByteAt(data, offset + 3) << 8U;
+    if (data[offset] == 'B' && data[offset + 1] == 'C' && len == 2 &&
+        offset + 6 <= extra_end) {
+      return (ByteAt(data, offset + 4) | ByteAt(data, offset + 5) << 8U) + 1;
+    }
+    offset += 4 + len;
+  }
+
+  return 0;
+}
+
+static auto AsBytes(std::span<char const> data) -> Bytef* {
+  return reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+}
+
+namespace sniff {
+
+auto IsGzipHeader(std::span<char const> data) -> bool {
+  if (data.size() < kHeaderSize + kTrailerSize) {
+    return false;
+  }
+
+  // magic, deflate, no reserved flags, a compression level hint gzip writes
+  // and a known operating system
+  auto const xfl = ByteAt(data, 8);
+  auto const os = ByteAt(data, 9);
+  return ByteAt(data, 0) == 0x1f && ByteAt(data, 1) == 0x8b &&
+         ByteAt(data, 2) == Z_DEFLATED && !(ByteAt(data, 3) & kFlagReserved) &&
+         (xfl == 0 || xfl == 2 || xfl == 4) && (os <= 13 || os == 255);
+}
+
+auto FindNextGzipMember(std::span<char const> data, std::size_t offset)
+    -> std::size_t {
+  if (auto const block_size = BgzfBlockSize(data.subspan(offset));
+      block_size != 0 && offset + block_size <= data.size()) {
+    auto const next = offset + block_size;
+    if (next == data.size() || IsGzipHeader(data.subspan(next))) {
+      return next;
+    }
+  }
+
+  for (auto next = offset + kHeaderSize + kTrailerSize; next < data.size();
+       ++next) {
+    auto const first = data.data() + next;
+    auto const magic = static_cast<char const*>(
+        std::memchr(first, 0x1f, data.size() - next));
+    if (magic == nullptr) {
+      break;
+    }
+
+    next += magic - first;
+    if (IsGzipHeader(data.subspan(next))) {
+      return next;
+    }
+  }
+
+  return data.size();
+}
+
+auto InflateGzipMember(std::span<char const> member, std::string* dst)
+    -> bool {
+  if (member.size() < kHeaderSize + kTrailerSize) {
+    return false;
+  }
+
+  // the trailer holds the inflated size modulo 2^32; members at guessed
+  // boundaries which inflate to more than that are not complete members
+  auto const tail = member.size() - 4;
+  auto const inflated_size =
+      ByteAt(member, tail) | ByteAt(member, tail + 1) << 8U |
+      ByteAt(member, tail + 2) << 16U | ByteAt(member, tail + 3) << 24U;
+
+  auto stream = z_stream{};
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    throw std::runtime_error(
+        "[sniff::InflateGzipMember] failed to init inflate");
+  }
+
+  auto const dst_size = dst->size();
+  dst->resize(dst_size + inflated_size);
+  stream.next_in = AsBytes(member);
+  stream.avail_in = member.size();
+  stream.next_out = reinterpret_cast<Bytef*>(dst->data() + dst_size);
+  stream.avail_out = inflated_size;
+
+  // one extra byte of output space tells a member which inflates to more
+  // than its trailer claims from one which fits exactly
+  auto spare = char();
+  auto status = inflate(&stream, Z_FINISH);
+  if (status == Z_BUF_ERROR && stream.avail_out == 0) {
+    stream.next_out = reinterpret_cast<Bytef*>(&spare);
+    stream.avail_out = 1;
+    status = inflate(&stream, Z_FINISH);
+  }
+
+  auto const is_complete = status == Z_STREAM_END && stream.avail_in == 0 &&
+                           stream.total_out == inflated_size;
+  inflateEnd(&stream);
+  if (!is_complete) {
+    dst->resize(dst_size);
+  }
+
+  return is_complete;
+}
+
+struct GzipStream::Impl {
+  z_stream stream = {};
+};
+
+GzipStream::GzipStream() : impl_(std::make_unique<Impl>()) {
+  if (inflateInit2(&impl_->stream, 15 + 16) != Z_OK) {
+    throw std::runtime_error("[sniff::GzipStream] failed to init inflate");
+  }
+}
+
+GzipStream::~GzipStream() { inflateEnd(&impl_->stream); }
+
+auto GzipStream::Inflate(std::span<char const> src, std::string* dst)
+    -> std::size_t {
+  auto& stream = impl_->stream;
+  if (is_finished_) {
+    return src.size();
+  }
+  if (!is_in_member_) {
+    inflateReset(&stream);
+    is_in_member_ = true;
+  }
+
+  stream.next_in = AsBytes(src);
+  stream.avail_in = src.size();
+  while (true) {
+    auto const dst_size = dst->size();
+    dst->resize(dst_size + kInflateStep);
+    stream.next_out = reinterpret_cast<Bytef*>(dst->data() + dst_size);
+    stream.avail_out = kInflateStep;
+
+    auto const status = inflate(&stream, Z_NO_FLUSH);
+    dst->resize(dst_size + kInflateStep - stream.avail_out);
+    if (status == Z_STREAM_END) {
+      is_in_member_ = false;
+      break;
+    }
+    if (status == Z_BUF_ERROR && stream.avail_in == 0) {
+      break;
+    }
+    if (status == Z_DATA_ERROR && stream.total_in <= 2) {
+      // not even the magic of a new member; ignored like gzip does
+      is_in_member_ = false;
+      is_finished_ = true;
+      return src.size();
+    }
+    if (status != Z_OK) {
+      throw std::runtime_error(
+          "[sniff::GzipStream::Inflate] invalid gzip data");
+    }
+    if (stream.avail_in == 0 && stream.avail_out != 0) {
+      break;
+    }
+  }
+
+  return src.size() - stream.avail_in;
+}
+
+}  // namespace sniff
@@ -0,0 +1,196 @@
+#include "sniff/index.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// 3rd party
+#include "tbb/parallel_for.h"
+
+// shards are selected by the top bits of the mixed value and built
+// independently
+static constexpr auto kShardBits = 8U;
+static constexpr auto kNumShards = 1U << kShardBits;
+
+// number of targets scattered by one task while partitioning
+static constexpr auto kChunkSize = std::size_t(1U << 16U);
+
+// bijective 64 bit finalizer from murmur3; spreads minimizer values evenly
+// over the buckets
+static auto MixValue(std::uint64_t val) -> std::uint64_t {
+  val ^= val >> 33U;
+  val *= 0xff51afd7ed558ccdULL;
+  val ^= val >> 33U;
+  val *= 0xc4ceb9fe1a85ec53ULL;
+  val ^= val >> 33U;
+  return val;
+}
+
+static auto BucketOf(std::uint64_t hash, std::uint32_t bucket_bits)
+    -> std::uint64_t {
+  return hash >> (64U - bucket_bits);
+}
+
+static auto ShardOf(sniff::Target const& target) -> std::uint32_t {
+  return BucketOf(MixValue(target.kmer.value), kShardBits);
+}
+
+// Stable scatter of targets into shards; returns kNumShards + 1 shard offsets.
+static auto PartitionTargets(std::vector<sniff::Target>& targets)
+    -> std::vector<std::size_t> {
+  auto const n_chunks = (targets.size() + kChunkSize - 1) / kChunkSize;
+  auto counts = std::vector<std::size_t>(n_chunks * kNumShards, 0);
+  tbb::parallel_for(std::size_t(0), n_chunks,
+                    [&targets, &counts](std::size_t const chunk) -> void {
+                      auto const first = chunk * kChunkSize;
+                      auto const last =
+                          std::min(first + kChunkSize, targets.size());
+                      auto* chunk_counts = counts.data() + chunk * kNumShards;
+                      for (auto i = first; i < last; ++i) {
+                        ++chunk_counts[ShardOf(targets[i])];
+                      }
+                    });
+
+  // shard major prefix sums so each chunk writes its own slice of a shard
+  auto shard_offsets = std::vector<std::size_t>(kNumShards + 1, 0);
+  for (std::size_t shard = 0, offset = 0; shard < kNumShards; ++shard) {
+    shard_offsets[shard] = offset;
+    for (std::size_t chunk = 0; chunk < n_chunks; ++chunk) {
+      offset += std::exchange(counts[chunk * kNumShards + shard], offset);
+    }
+  }
+  shard_offsets.back() = targets.size();
+
+  auto dst = std::vector<sniff::Target>(targets.size());
+  tbb::parallel_for(
+      std::size_t(0), n_chunks,
+      [&targets, &counts, &dst](std::size_t const chunk) -> void {
+        auto const first = chunk * kChunkSize;
+        auto const last = std::min(first + kChunkSize, targets.size());
+        auto* chunk_offsets = counts.data() + chunk * kNumShards;
+        for (auto i = first; i < last; ++i) {
+          dst[chunk_offsets[ShardOf(targets[i])]++] = targets[i];
+        }
+      });
+
+  targets = std::move(dst);
+  return shard_offsets;
+}
+
+// Arrays of a built index, shared by all copies of it.
+struct IndexStorage {
+  std::vector<std::uint32_t> buckets;
+  std::vector<sniff::IndexEntry> entries;
+  std::vector<sniff::Target> targets;
+};
+
+namespace sniff {
+
+auto CreateIndex(std::vector<Target> targets) -> Index {
+  if (targets.size() >= std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("[sniff::CreateIndex] too many targets");
+  }
+
+  auto const shard_offsets = PartitionTargets(targets);
+
+  // sort each shard and count its distinct values to size the entry table
+  auto shard_entries = std::vector<std::uint32_t>(kNumShards + 1, 0);
+  tbb::parallel_for(
+      std::uint32_t(0), kNumShards,
+      [&targets, &shard_offsets,
+       &shard_entries](std::uint32_t const shard) -> void {
+        auto const first = targets.begin() + shard_offsets[shard];
+        auto const last = targets.begin() + shard_offsets[shard + 1];
+        std::stable_sort(first, last,
+                         [](Target const& lhs, Target const& rhs) -> bool {
+                           return MixValue(lhs.kmer.value) <
+                                  MixValue(rhs.kmer.value);
+                         });
+
+        for (auto it = first; it != last; ++it) {
+          if (it == first || it->kmer.value != std::prev(it)->kmer.value) {
+            ++shard_entries[shard];
+          }
+        }
+      });
+
+  for (std::uint32_t shard = 0, offset = 0; shard <= kNumShards; ++shard) {
+    offset += std::exchange(shard_entries[shard], offset);
+  }
+
+  auto entries = std::vector<IndexEntry>(shard_entries.back() + 1);
+  tbb::parallel_for(
+      std::uint32_t(0), kNumShards,
+      [&targets, &shard_offsets, &shard_entries,
+       &entries](std::uint32_t const shard) -> void {
+        auto dst = entries.begin() + shard_entries[shard];
+        for (auto i = shard_offsets[shard]; i < shard_offsets[shard + 1];
+             ++i) {
+          if (i == shard_offsets[shard] ||
+              targets[i].kmer.value != targets[i - 1].kmer.value) {
+            *dst++ = IndexEntry{
+                .fingerprint =
+                    static_cast<std::uint32_t>(MixValue(targets[i].kmer.value)),
+                .offset = static_cast<std::uint32_t>(i)};
+          }
+        }
+      });
+  entries.back() = IndexEntry{
+      .fingerprint = 0, .offset = static_cast<std::uint32_t>(targets.size())};
+
+  // about one entry per bucket; every entry fills the buckets between its
+  // predecessor's bucket and its own so each bucket is written exactly once
+  auto const n_entries = entries.size() - 1;
+  auto const bucket_bits = std::max(
+      1U, static_cast<std::uint32_t>(std::bit_width(n_entries)));
+  auto buckets = std::vector<std::uint32_t>((1ULL << bucket_bits) + 1U);
+  auto bucket_of_entry = [&targets, &entries,
+                          bucket_bits](std::size_t const idx) -> std::uint64_t {
+    return BucketOf(MixValue(targets[entries[idx].offset].kmer.value),
+                    bucket_bits);
+  };
+
+  tbb::parallel_for(
+      std::size_t(0), n_entries + 1,
+      [&buckets, &bucket_of_entry, n_entries](std::size_t const idx) -> void {
+        auto const first = idx == 0 ? 0 : bucket_of_entry(idx - 1) + 1;
+        auto const last =
+            idx == n_entries ? buckets.size() - 1 : bucket_of_entry(idx);
+        for (auto bucket = first; bucket <= last; ++bucket) {
+          buckets[bucket] = idx;
+        }
+      });
+
+  auto storage = std::make_shared<IndexStorage>(IndexStorage{
+      .buckets = std::move(buckets),
+      .entries = std::move(entries),
+      .targets = std::move(targets)});
+
+  return Index{.bucket_bits = bucket_bits,
+               .buckets = storage->buckets,
+               .entries = storage->entries,
+               .targets = storage->targets,
+               .storage = std::move(storage)};
+}
+
+auto FindTargets(Index const& index, std::uint64_t value)
+    -> std::span<Target const> {
+  auto const hash = MixValue(value);
+  auto const bucket = BucketOf(hash, index.bucket_bits);
+  for (auto i = index.buckets[bucket]; i < index.buckets[bucket + 1]; ++i) {
+    auto const& entry = index.entries[i];
+    if (entry.fingerprint == static_cast<std::uint32_t>(hash) &&
+        index.targets[entry.offset].kmer.value == value) {
+      return std::span(index.targets.data() + entry.offset,
+                       index.entries[i + 1].offset - entry.offset);
+    }
+  }
+
+  return {};
+}
+
+}  // namespace sniff
@@ -1,21 +1,41 @@
 #include "sniff/io.h"
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
 // 3rd party
-#include "bioparser/fasta_parser.hpp"
-#include "bioparser/fastq_parser.hpp"
-#include "biosoup/nucleic_acid.hpp"
 #include "biosoup/timer.hpp"
 #include "fmt/core.h"
 #include "tbb/parallel_for.h"
+#include "tbb/parallel_pipeline.h"
+#include "tbb/task_arena.h"
+#include "zlib.h"
 
 // sniff
+#include "sniff/gzip.h"
 #include "sniff/minimize.h"
 
 namespace sniff {
 
-static constexpr auto kChunkSize = 1U << 26U;  // 64 MiB
+static constexpr auto kInputChunkSize = std::size_t(1U << 22U);  // 4 MiB
+static constexpr auto kReadBufferSize = 1U << 20U;  // 1 MiB
+
+// bases located before they are handed to a visitor at once
+static constexpr auto kLocateBatchBases = std::uint64_t(1U << 22U);
+
+// uncompressed bytes per gzipped byte assumed before inflating
+static constexpr auto kGzipRatio = std::uint64_t(5);
 
 static constexpr auto kFastaSuffxies =
     std::array<char const*, 4>{".fasta", "fasta.gz", ".fa", ".fa.gz"};
@@ -30,51 +50,484 @@ static auto IsSuffixFor(std::string_view const suffix,
              : false;
 }
 
-static auto CreateParser(std::filesystem::path const& path)
-    -> std::unique_ptr<bioparser::Parser<biosoup::NucleicAcid>> {
-  using namespace std::placeholders;
+static auto IsFastq(std::filesystem::path const& path) -> bool {
+  auto const is_suffix = [&path](char const* suffix) -> bool {
+    return IsSuffixFor(suffix, path.c_str());
+  };
+
   if (std::filesystem::exists(path)) {
     if (std::any_of(kFastaSuffxies.cbegin(), kFastaSuffxies.cend(),
-                    std::bind(IsSuffixFor, _1, path.c_str()))) {
-      return bioparser::Parser<biosoup::NucleicAcid>::Create<
-          bioparser::FastaParser>(path.c_str());
+                    is_suffix)) {
+      return false;
     } else if (std::any_of(kFastqSuffixes.cbegin(), kFastqSuffixes.cend(),
-                           std::bind(IsSuffixFor, _1, path.c_str()))) {
-      return bioparser::Parser<biosoup::NucleicAcid>::Create<
-          bioparser::FastqParser>(path.c_str());
+                           is_suffix)) {
+      return true;
     }
   }
 
-  throw std::invalid_argument(
-      "[camel::detail::CreateParser] invalid file path: " + path.string());
+  throw std::invalid_argument("[sniff::IsFastq] invalid file path: " +
+                              path.string());
 }
 
-auto LoadReads(std::filesystem::path const& path)
-    -> std::vector<std::unique_ptr<biosoup::NucleicAcid>> {
-  auto timer = biosoup::Timer();
+// Buffered line reader over a plain file which keeps track of the offset;
+// zlib reads plain files transparently and turns seeks on them into lseek
+// calls. Gzipped files are rejected, as seeks in them inflate from the start.
+class SequenceFile {
+ public:
+  explicit SequenceFile(std::filesystem::path const& path)
+      : file_(gzopen(path.c_str(), "rb")), buffer_(kReadBufferSize) {
+    if (file_ == nullptr) {
+      throw std::runtime_error(
+          "[sniff::SequenceFile] failed to open: " + path.string());
+    }
+    gzbuffer(file_, kReadBufferSize);
+    if (gzdirect(file_) == 0) {
+      gzclose(file_);
+      throw std::invalid_argument(
+          "[sniff::SequenceFile] gzipped input has to be inflated first: " +
+          path.string());
+    }
+  }
 
-  timer.Start();
-  auto parser = CreateParser(path);
-  auto dst = std::vector<std::unique_ptr<biosoup::NucleicAcid>>();
+  SequenceFile(SequenceFile const&) = delete;
+  auto operator=(SequenceFile const&) -> SequenceFile& = delete;
+
+  ~SequenceFile() { gzclose(file_); }
+
+  auto Offset() const -> std::uint64_t { return buffer_offset_ + begin_; }
+
+  auto Seek(std::uint64_t offset) -> void {
+    if (offset >= buffer_offset_ && offset <= buffer_offset_ + end_) {
+      begin_ = offset - buffer_offset_;
+      return;
+    }
+
+    if (gzseek(file_, offset, SEEK_SET) == -1) {
+      throw std::runtime_error("[sniff::SequenceFile::Seek] failed to seek");
+    }
+
+    buffer_offset_ = offset;
+    begin_ = end_ = 0;
+  }
+
+  // Returns the first character of the next line without consuming it.
+  auto Peek() -> int { return Fill() ? buffer_[begin_] : -1; }
+
+  // Consumes one line and appends it to dst if dst is not null; returns the
+  // line length without the line terminator or -1 at the end of the file.
+  auto ReadLine(std::string* dst) -> std::int64_t {
+    if (!Fill()) {
+      return -1;
+    }
+
+    auto len = std::int64_t(0);
+    auto last = '\0';
+    while (Fill()) {
+      auto const first = static_cast<char const*>(buffer_.data()) + begin_;
+      auto const eol = static_cast<char const*>(
+          std::memchr(first, '\n', end_ - begin_));
+      auto const span_end = eol ? eol : buffer_.data() + end_;
+
+      if (span_end != first) {
+        len += span_end - first;
+        last = *(span_end - 1);
+        if (dst) {
+          dst->append(first, span_end - first);
+        }
+      }
+
+      begin_ = span_end - buffer_.data() + (eol ? 1 : 0);
+      if (eol) {
+        break;
+      }
+    }
+
+    if (last == '\r') {
+      --len;
+      if (dst) {
+        dst->pop_back();
+      }
+    }
+
+    return len;
+  }
+
+ private:
+  auto Fill() -> bool {
+    if (begin_ < end_) {
+      return true;
+    }
+
+    buffer_offset_ += end_;
+    begin_ = end_ = 0;
+
+    auto const n_bytes = gzread(file_, buffer_.data(), buffer_.size());
+    if (n_bytes < 0) {
+      throw std::runtime_error("[sniff::SequenceFile::Fill] failed to read");
+    }
+
+    end_ = static_cast<std::size_t>(n_bytes);
+    return end_ > 0;
+  }
+
+  gzFile file_;
+  std::vector<char> buffer_;
+  std::size_t begin_ = 0;
+  std::size_t end_ = 0;
+  std::uint64_t buffer_offset_ = 0;
+};
+
+// Line reader over a buffer with the interface of SequenceFile.
+class LineBuffer {
+ public:
+  explicit LineBuffer(std::string_view data) : data_(data) {}
+
+  auto Offset() const -> std::uint64_t { return offset_; }
+
+  auto Peek() -> int { return offset_ < data_.size() ? data_[offset_] : -1; }
+
+  auto ReadLine(std::string* dst) -> std::int64_t {
+    if (offset_ == data_.size()) {
+      return -1;
+    }
+
+    auto const eol = std::min(data_.find('\n', offset_), data_.size());
+    auto line = data_.substr(offset_, eol - offset_);
+    offset_ = std::min(eol + 1, data_.size());
 
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (dst) {
+      dst->append(line);
+    }
+
+    return line.size();
+  }
+
+ private:
+  std::string_view data_;
+  std::size_t offset_ = 0;
+};
+
+// Reads the next fasta/fastq record; sequence data is only kept when data is
+// not null. Names are shortened to the first whitespace like bioparser does.
+template <class LineReader>
+static auto ReadRecord(LineReader& file, bool is_fastq, std::string& name,
+                       std::string* data) -> std::optional<std::uint32_t> {
+  auto const header = is_fastq ? '@' : '>';
+  while (file.Peek() != -1 && file.Peek() != header) {
+    file.ReadLine(nullptr);
+  }
+
+  name.clear();
+  if (file.ReadLine(&name) == -1) {
+    return std::nullopt;
+  }
+
+  name.erase(0, 1);
+  name.erase(std::min(name.find_first_of(" \t"), name.size()));
+
+  if (data) {
+    data->clear();
+  }
+
+  auto len = std::uint64_t(0);
+  auto const data_end = is_fastq ? '+' : '>';
+  for (auto c = file.Peek(); c != -1 && c != data_end; c = file.Peek()) {
+    len += file.ReadLine(data);
+  }
+
+  if (is_fastq) {
+    file.ReadLine(nullptr);
+    for (auto qual_len = std::uint64_t(0); qual_len < len;) {
+      auto const line_len = file.ReadLine(nullptr);
+      if (line_len == -1) {
+        throw std::runtime_error(
+            "[sniff::ReadRecord] truncated fastq record: " + name);
+      }
+      qual_len += line_len;
+    }
+  }
+
+  return static_cast<std::uint32_t>(len);
+}
+
+// End of the last record which is complete in data, given that more data may
+// follow. Fasta records only end where the next one starts, fastq records end
+// once their quality string is as long as their sequence.
+static auto FindRecordsEnd(std::string_view data, bool is_fastq)
+    -> std::size_t {
+  if (!is_fastq) {
+    auto const header = data.rfind("\n>");
+    return header == std::string_view::npos ? 0 : header + 1;
+  }
+
+  // only lines with a line terminator are known to be complete
+  auto lines = LineBuffer(data.substr(0, data.rfind('\n') + 1));
+  auto dst = std::size_t(0);
   while (true) {
-    auto reads = parser->Parse(kChunkSize);
-    if (reads.empty()) {
+    while (lines.Peek() != -1 && lines.Peek() != '@') {
+      lines.ReadLine(nullptr);
+    }
+    if (lines.ReadLine(nullptr) == -1) {
+      break;
+    }
+
+    auto len = std::int64_t(0);
+    for (auto c = lines.Peek(); c != -1 && c != '+'; c = lines.Peek()) {
+      len += lines.ReadLine(nullptr);
+    }
+    if (lines.ReadLine(nullptr) == -1) {
       break;
     }
-    dst.insert(dst.end(), std::make_move_iterator(reads.begin()),
-               std::make_move_iterator(reads.end()));
 
-    fmt::print(stderr,
-               "\r[sniff::LoadSequences]({:12.3f}) loaded: {} sequences",
-               timer.Lap(), dst.size());
+    auto qual_len = std::int64_t(0);
+    while (qual_len < len) {
+      auto const line_len = lines.ReadLine(nullptr);
+      if (line_len == -1) {
+        break;
+      }
+      qual_len += line_len;
+    }
+    if (qual_len < len) {
+      break;
+    }
+
+    dst = lines.Offset();
   }
 
-  std::sort(dst.begin(), dst.end(),
-            [](std::unique_ptr<biosoup::NucleicAcid> const& lhs,
-               std::unique_ptr<biosoup::NucleicAcid> const& rhs) -> bool {
-              return lhs->id < rhs->id;
-            });
+  return dst;
+}
+
+static auto IsGzipMagic(std::string_view data) -> bool {
+  return data.size() >= 2 && static_cast<std::uint8_t>(data[0]) == 0x1f &&
+         static_cast<std::uint8_t>(data[1]) == 0x8b;
+}
+
+// A piece of the input on its way through LoadReads.
+struct InputChunk {
+  // input as read from the file; gzipped input is cut where a gzip member is
+  // guessed to start
+  std::string bytes;
+  bool is_last = false;
+
+  // guessed member boundaries in bytes; members[i] to members[i + 1] is
+  // inflated speculatively and kept if it is a complete member
+  std::vector<std::size_t> members;
+  std::vector<std::optional<std::string>> inflated;
+
+  // whole records of the uncompressed input and the reads parsed from them
+  std::string data;
+  ReadStore reads;
+};
+
+// Cuts the input into chunks. Gzipped input is cut at guessed member
+// boundaries, so that concatenated gzip files and BGZF blocks can be inflated
+// independently of each other.
+class InputReader {
+ public:
+  explicit InputReader(std::filesystem::path const& path)
+      : file_(path, std::ios::binary) {
+    if (!file_) {
+      throw std::runtime_error("[sniff::InputReader] failed to open: " +
+                               path.string());
+    }
+
+    auto magic = std::array<char, 2>();
+    file_.read(magic.data(), magic.size());
+    is_gzip_ = IsGzipMagic(std::string_view(magic.data(), file_.gcount()));
+    file_.clear();
+    file_.seekg(0);
+  }
+
+  auto IsGzip() const -> bool { return is_gzip_; }
+
+  // Returns null after the last chunk.
+  auto Next() -> std::shared_ptr<InputChunk> {
+    if (is_done_) {
+      return nullptr;
+    }
+
+    auto chunk = std::make_shared<InputChunk>();
+    chunk->bytes = std::move(pending_);
+    pending_.clear();
+
+    auto const n_pending = chunk->bytes.size();
+    chunk->bytes.resize(n_pending + kInputChunkSize);
+    file_.read(chunk->bytes.data() + n_pending, kInputChunkSize);
+    chunk->bytes.resize(n_pending + file_.gcount());
+    chunk->is_last = is_done_ = file_.eof();
+
+    if (is_gzip_) {
+      FindMembers(chunk.get());
+    }
+
+    return chunk;
+  }
+
+ private:
+  // Everything from the last guessed member on is left for the next chunk
+  // unless the input ends here.
+  auto FindMembers(InputChunk* chunk) -> void {
+    auto const bytes = std::span<char const>(chunk->bytes);
+    for (auto offset = IsGzipHeader(bytes) ? 0 : FindNextGzipMember(bytes, 0);
+         offset < bytes.size(); offset = FindNextGzipMember(bytes, offset)) {
+      chunk->members.push_back(offset);
+    }
+
+    if (chunk->is_last) {
+      chunk->members.push_back(bytes.size());
+    } else if (!chunk->members.empty() && chunk->members.back() != 0) {
+      pending_.assign(chunk->bytes, chunk->members.back());
+      chunk->bytes.resize(chunk->members.back());
+    }
+
+    chunk->inflated.resize(chunk->members.size());
+  }
+
+  std::ifstream file_;
+  std::string pending_;
+  bool is_gzip_ = false;
+  bool is_done_ = false;
+};
+
+// Inflates what could not be inflated speculatively, in input order, and cuts
+// the uncompressed input at record boundaries.
+class RecordSplitter {
+ public:
+  RecordSplitter(bool is_gzip, bool is_fastq)
+      : is_gzip_(is_gzip), is_fastq_(is_fastq) {}
+
+  auto operator()(InputChunk* chunk) -> void {
+    auto data = std::move(carry_);
+    carry_.clear();
+
+    if (is_gzip_) {
+      Inflate(*chunk, &data);
+    } else {
+      data.append(chunk->bytes);
+    }
+
+    chunk->bytes = std::string();
+    chunk->inflated.clear();
+
+    auto const end =
+        chunk->is_last ? data.size() : FindRecordsEnd(data, is_fastq_);
+    carry_.assign(data, end);
+    data.resize(end);
+    chunk->data = std::move(data);
+  }
+
+ private:
+  auto Inflate(InputChunk const& chunk, std::string* dst) -> void {
+    auto const bytes = std::span<char const>(chunk.bytes);
+    auto member = std::size_t(0);
+    for (auto offset = std::size_t(0);
+         offset < bytes.size() && !stream_.IsFinished();) {
+      if (!stream_.IsInMember()) {
+        while (member < chunk.members.size() &&
+               chunk.members[member] < offset) {
+          ++member;
+        }
+        if (member + 1 < chunk.members.size() &&
+            chunk.members[member] == offset && chunk.inflated[member]) {
+          dst->append(*chunk.inflated[member]);
+          offset = chunk.members[member + 1];
+          continue;
+        }
+      }
+
+      offset += stream_.Inflate(bytes.subspan(offset), dst);
+    }
+
+    if (chunk.is_last && stream_.IsInMember()) {
+      throw std::runtime_error("[sniff::LoadReads] truncated gzip input");
+    }
+  }
+
+  bool is_gzip_;
+  bool is_fastq_;
+  GzipStream stream_;
+  std::string carry_;
+};
+
+auto LoadReads(std::filesystem::path const& path, ReadsVisitor const& visit)
+    -> ReadStore {
+  auto timer = biosoup::Timer();
+
+  timer.Start();
+  auto const is_fastq = IsFastq(path);
+  auto reader = InputReader(path);
+  auto splitter = RecordSplitter(reader.IsGzip(), is_fastq);
+  auto dst = ReadStore();
+
+  // reading and splitting run in input order, while inflating members and
+  // parsing records run on as many chunks at once as there are threads
+  tbb::parallel_pipeline(
+      tbb::this_task_arena::max_concurrency(),
+      tbb::make_filter<void, std::shared_ptr<InputChunk>>(
+          tbb::filter_mode::serial_in_order,
+          [&reader](tbb::flow_control& fc) -> std::shared_ptr<InputChunk> {
+            auto chunk = reader.Next();
+            if (!chunk) {
+              fc.stop();
+            }
+            return chunk;
+          }) &
+          tbb::make_filter<std::shared_ptr<InputChunk>,
+                           std::shared_ptr<InputChunk>>(
+              tbb::filter_mode::parallel,
+              [](std::shared_ptr<InputChunk> chunk)
+                  -> std::shared_ptr<InputChunk> {
+                auto const bytes = std::span<char const>(chunk->bytes);
+                for (std::size_t i = 0; i + 1 < chunk->members.size(); ++i) {
+                  auto inflated = std::string();
+                  if (InflateGzipMember(
+                          bytes.subspan(chunk->members[i],
+                                        chunk->members[i + 1] -
+                                            chunk->members[i]),
+                          &inflated)) {
+                    chunk->inflated[i] = std::move(inflated);
+                  }
+                }
+                return chunk;
+              }) &
+          tbb::make_filter<std::shared_ptr<InputChunk>,
+                           std::shared_ptr<InputChunk>>(
+              tbb::filter_mode::serial_in_order,
+              [&splitter](std::shared_ptr<InputChunk> chunk)
+                  -> std::shared_ptr<InputChunk> {
+                splitter(chunk.get());
+                return chunk;
+              }) &
+          tbb::make_filter<std::shared_ptr<InputChunk>,
+                           std::shared_ptr<InputChunk>>(
+              tbb::filter_mode::parallel,
+              [is_fastq, &visit](std::shared_ptr<InputChunk> chunk)
+                  -> std::shared_ptr<InputChunk> {
+                auto lines = LineBuffer(chunk->data);
+                auto name = std::string();
+                auto data = std::string();
+                while (ReadRecord(lines, is_fastq, name, &data)) {
+                  chunk->reads.Append(name, data);
+                }
+                chunk->data = std::string();
+                if (visit) {
+                  visit(chunk->reads);
+                }
+                return chunk;
+              }) &
+          tbb::make_filter<std::shared_ptr<InputChunk>, void>(
+              tbb::filter_mode::serial_in_order,
+              [&timer, &dst](std::shared_ptr<InputChunk> chunk) -> void {
+                dst.Append(chunk->reads);
+
+                fmt::print(
+                    stderr,
+                    "\r[sniff::LoadSequences]({:12.3f}) loaded: {} sequences",
+                    timer.Lap(), dst.size());
+              }));
 
   fmt::print(stderr,
              "\r[sniff::LoadSequences]({:12.3f}) loaded: {} sequences\n",
@@ -83,4 +536,198 @@ auto LoadReads(std::filesystem::path const& path)
   return dst;
 }
 
+auto EstimateBases(std::filesystem::path const& path) -> std::uint64_t {
+  auto const is_fastq = IsFastq(path);
+
+  auto file = std::ifstream(path, std::ios::binary);
+  auto magic = std::array<char, 2>();
+  file.read(magic.data(), magic.size());
+
+  auto dst = std::filesystem::file_size(path);
+  if (IsGzipMagic(std::string_view(magic.data(), file.gcount()))) {
+    dst *= kGzipRatio;
+  }
+
+  // qualities take as many bytes as bases
+  return is_fastq ? dst / 2 : dst;
+}
+
+SeekableInput::SeekableInput(std::filesystem::path const& path)
+    : path_(path) {
+  auto file = gzopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    throw std::runtime_error("[sniff::SeekableInput] failed to open: " +
+                             path.string());
+  }
+  gzbuffer(file, kReadBufferSize);
+  if (gzdirect(file) != 0) {
+    gzclose(file);
+    return;
+  }
+
+  // the copy keeps the name without .gz, which tells fasta from fastq
+  static auto n_inputs = std::atomic<std::uint32_t>(0);
+  auto const name = path.extension() == ".gz" ? path.stem() : path.filename();
+  path_ = std::filesystem::temp_directory_path() /
+          fmt::format("sniff-{}-{}-{}", getpid(), n_inputs++, name.string());
+  is_temporary_ = true;
+
+  auto timer = biosoup::Timer();
+  timer.Start();
+  fmt::print(stderr, "[sniff::SeekableInput] inflating {} into {}\n",
+             path.string(), path_.string());
+
+  try {
+    auto dst = std::ofstream(path_, std::ios::binary);
+    auto buffer = std::vector<char>(kReadBufferSize);
+    for (auto n_bytes = gzread(file, buffer.data(), buffer.size());
+         n_bytes != 0; n_bytes = gzread(file, buffer.data(), buffer.size())) {
+      if (n_bytes < 0) {
+        throw std::runtime_error("[sniff::SeekableInput] failed to inflate: " +
+                                 path.string());
+      }
+      dst.write(buffer.data(), n_bytes);
+    }
+
+    // a truncated last member only shows up on close
+    if (gzclose_r(std::exchange(file, nullptr)) != Z_OK) {
+      throw std::runtime_error("[sniff::SeekableInput] truncated gzip input: " +
+                               path.string());
+    }
+    if (!dst.flush()) {
+      throw std::runtime_error("[sniff::SeekableInput] failed to write: " +
+                               path_.string());
+    }
+  } catch (...) {
+    if (file != nullptr) {
+      gzclose(file);
+    }
+    std::filesystem::remove(path_);
+    throw;
+  }
+
+  fmt::print(stderr, "[sniff::SeekableInput]({:12.3f}) inflated\n",
+             timer.Stop());
+}
+
+SeekableInput::~SeekableInput() {
+  if (is_temporary_) {
+    auto ec = std::error_code();
+    std::filesystem::remove(path_, ec);
+  }
+}
+
+// A run of records on its way through LocateReads; reads are only loaded
+// for a visitor.
+struct LocatedBatch {
+  std::vector<ReadLocation> locations;
+  ReadStore reads;
+};
+
+auto LocateReads(std::filesystem::path const& path, ReadsVisitor const& visit)
+    -> std::vector<ReadLocation> {
+  auto timer = biosoup::Timer();
+
+  timer.Start();
+  auto const is_fastq = IsFastq(path);
+  auto file = SequenceFile(path);
+  auto dst = std::vector<ReadLocation>();
+
+  // the scan runs in input order, while visiting runs on as many batches at
+  // once as there are threads
+  auto is_done = false;
+  tbb::parallel_pipeline(
+      tbb::this_task_arena::max_concurrency(),
+      tbb::make_filter<void, std::shared_ptr<LocatedBatch>>(
+          tbb::filter_mode::serial_in_order,
+          [&file, &is_done, &visit, is_fastq](
+              tbb::flow_control& fc) -> std::shared_ptr<LocatedBatch> {
+            if (is_done) {
+              fc.stop();
+              return nullptr;
+            }
+
+            auto batch = std::make_shared<LocatedBatch>();
+            auto name = std::string();
+            auto data = std::string();
+            for (auto n_bases = std::uint64_t(0);
+                 n_bases < kLocateBatchBases;) {
+              auto const offset = file.Offset();
+              auto const len =
+                  ReadRecord(file, is_fastq, name, visit ? &data : nullptr);
+              if (!len) {
+                is_done = true;
+                break;
+              }
+
+              batch->locations.push_back(
+                  ReadLocation{.name = name, .offset = offset, .length = *len});
+              if (visit) {
+                batch->reads.Append(name, data);
+              }
+              n_bases += *len;
+            }
+            return batch;
+          }) &
+          tbb::make_filter<std::shared_ptr<LocatedBatch>,
+                           std::shared_ptr<LocatedBatch>>(
+              tbb::filter_mode::parallel,
+              [&visit](std::shared_ptr<LocatedBatch> batch)
+                  -> std::shared_ptr<LocatedBatch> {
+                if (visit) {
+                  visit(batch->reads);
+                  batch->reads = ReadStore();
+                }
+                return batch;
+              }) &
+          tbb::make_filter<std::shared_ptr<LocatedBatch>, void>(
+              tbb::filter_mode::serial_in_order,
+              [&timer, &dst](std::shared_ptr<LocatedBatch> batch) -> void {
+                std::move(batch->locations.begin(), batch->locations.end(),
+                          std::back_inserter(dst));
+                fmt::print(
+                    stderr,
+                    "\r[sniff::LocateReads]({:12.3f}) located: {} sequences",
+                    timer.Lap(), dst.size());
+              }));
+
+  fmt::print(stderr, "\r[sniff::LocateReads]({:12.3f}) located: {} sequences\n",
+             timer.Stop(), dst.size());
+
+  return dst;
+}
+
+auto LoadReads(std::filesystem::path const& path,
+               std::span<ReadLocation const> locations, ReadStore* dst)
+    -> void {
+  auto const is_fastq = IsFastq(path);
+  auto file = SequenceFile(path);
+
+  // visit locations in file order so reads are loaded in one sweep
+  auto order = std::vector<std::uint32_t>(locations.size());
+  std::iota(order.begin(), order.end(), 0U);
+  std::sort(order.begin(), order.end(),
+            [locations](std::uint32_t lhs, std::uint32_t rhs) -> bool {
+              return locations[lhs].offset < locations[rhs].offset;
+            });
+
+  auto reads = ReadStore();
+  auto ranks = std::vector<std::uint32_t>(locations.size());
+  auto name = std::string();
+  auto data = std::string();
+  for (auto const idx : order) {
+    file.Seek(locations[idx].offset);
+    if (ReadRecord(file, is_fastq, name, &data) != locations[idx].length) {
+      throw std::runtime_error(
+          "[sniff::LoadReads] input changed since it was located: " +
+          locations[idx].name);
+    }
+
+    ranks[idx] = reads.size();
+    reads.Append(name, data);
+  }
+
+  dst->Append(reads.Permute(ranks));
+}
+
 }  // namespace sniff
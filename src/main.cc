@@ -1,6 +1,18 @@
 #include <sys/resource.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 // 3rd party dependencies
 #include "biosoup/nucleic_acid.hpp"
@@ -15,6 +27,138 @@ std::atomic<std::uint32_t> biosoup::NucleicAcid::num_objects = 0;
 // sniff
 #include "sniff/algo.h"
 #include "sniff/io.h"
+#include "sniff/metrics.h"
+#include "sniff/model.h"
+#include "sniff/output.h"
+#include "sniff/shard.h"
+
+static auto is_counting_allocations = std::atomic<bool>(false);
+static thread_local std::uint64_t allocated_bytes = 0;
+
+// Allocations of each thread are counted for --metrics. Operator delete is
+// replaced along with operator new so that the two always match; the array
+// and nothrow forms forward to these. Neither is inlined, like the ones of the
+// standard library, which keeps gcc from pairing the inlined malloc and free
+// with new and delete expressions.
+[[gnu::noinline]] auto operator new(std::size_t size) -> void* {
+  if (is_counting_allocations.load(std::memory_order_relaxed)) {
+    allocated_bytes += size;
+  }
+  if (auto* const ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] auto operator delete(void* ptr) noexcept -> void {
+  std::free(ptr);
+}
+
+[[gnu::noinline]] auto operator delete(void* ptr,
+                                       std::size_t /* size */) noexcept
+    -> void {
+  std::free(ptr);
+}
+
+// Parses sizes like 512M or 16G; plain numbers are bytes.
+static auto ParseMemorySize(std::string const& str) -> std::uint64_t {
+  auto idx = std::size_t(0);
+  auto const value = std::stod(str, &idx);
+  auto const suffix = str.substr(idx);
+
+  auto scale = 1.;
+  if (suffix == "K" || suffix == "k") {
+    scale = 1e3;
+  } else if (suffix == "M" || suffix == "m") {
+    scale = 1e6;
+  } else if (suffix == "G" || suffix == "g") {
+    scale = 1e9;
+  } else if (!suffix.empty() || value < 0) {
+    throw std::invalid_argument(
+        "[sniff::ParseMemorySize] invalid memory size: " + str);
+  }
+
+  return static_cast<std::uint64_t>(value * scale);
+}
+
+// Parses shards like 2/8; the index is zero based.
+static auto ParseShard(std::string const& str)
+    -> std::pair<std::uint32_t, std::uint32_t> {
+  auto const is_number = [](std::string_view digits) -> bool {
+    return !digits.empty() && digits.size() < 10 &&
+           std::all_of(digits.begin(), digits.end(),
+                       [](char c) -> bool { return c >= '0' && c <= '9'; });
+  };
+
+  auto const sep = str.find('/');
+  if (sep == std::string::npos || !is_number(str.substr(0, sep)) ||
+      !is_number(str.substr(sep + 1))) {
+    throw std::invalid_argument("[sniff::ParseShard] invalid shard: " + str);
+  }
+
+  auto const index = std::stoul(str.substr(0, sep));
+  auto const count = std::stoul(str.substr(sep + 1));
+  if (index >= count) {
+    throw std::invalid_argument("[sniff::ParseShard] invalid shard: " + str);
+  }
+
+  return {index, count};
+}
+
+// sniff merge: combines the shard files of a sharded run into its pairs.
+static auto RunMerge(int argc, char** argv) -> void {
+  auto options = cxxopts::Options(
+      "sniff merge", "merge the shards of a run started with --shard");
+  /* clang-format off */
+  options.add_options()
+    ("h,help", "print help")
+    ("t,threads", "number of threads to use",
+      cxxopts::value<std::uint32_t>()->default_value("1"))
+    ("m,model",
+     "LightGBM text model used to filter pairs "
+     "(see scripts/inference/export_lgbm_model.py)",
+      cxxopts::value<std::string>())
+    ("shards", "shard files", cxxopts::value<std::vector<std::string>>())
+    ("format", "output format: csv, paf or binary",
+      cxxopts::value<std::string>()->default_value("csv"))
+    ("z,compress", "gzip compress the output");
+  /* clang-format on */
+
+  options.positional_help("<shard>...");
+  options.parse_positional({"shards"});
+  options.show_positional_help();
+  auto result = options.parse(argc, argv);
+  if (result.count("help") || !result.count("shards")) {
+    fmt::print(stderr, "{}\n", options.help());
+    return;
+  }
+
+  auto const output_cfg = sniff::OutputConfig{
+      .format = sniff::ParseOutputFormat(result["format"].as<std::string>()),
+      .compress = result.count("compress") > 0};
+
+  auto task_arena = tbb::task_arena(result["threads"].as<std::uint32_t>());
+  auto timer = biosoup::Timer();
+  timer.Start();
+
+  task_arena.execute([&] {
+    auto shards = std::vector<sniff::ShardCandidates>();
+    for (auto const& path : result["shards"].as<std::vector<std::string>>()) {
+      shards.push_back(sniff::ReadShard(path));
+    }
+
+    auto pairs = sniff::MergeShards(std::move(shards));
+    if (result.count("model")) {
+      auto const model = sniff::LoadModel(result["model"].as<std::string>());
+      pairs.overlaps = sniff::FilterOverlaps(model, std::move(pairs.overlaps));
+    }
+
+    sniff::WriteOverlaps(output_cfg, pairs.overlaps, STDOUT_FILENO);
+    fmt::print(stderr, "[sniff::merge]({:12.3f}) n pairs: {}\n", timer.Stop(),
+               pairs.overlaps.size());
+  });
+}
 
 static auto GetPeakMemoryUsageKB() -> std::uint32_t {
   struct rusage rusage_info;
@@ -25,6 +169,11 @@ static auto GetPeakMemoryUsageKB() -> std::uint32_t {
 
 int main(int argc, char** argv) {
   try {
+    if (argc > 1 && std::string_view(argv[1]) == "merge") {
+      RunMerge(argc - 1, argv + 1);
+      return EXIT_SUCCESS;
+    }
+
     auto options =
         cxxopts::Options("sniff", "pair up potential reverse complement reads");
     /* clang-format off */
@@ -32,22 +181,66 @@ int main(int argc, char** argv) {
       ("h,help", "print help")
       ("v,version", "print version")
       ("t,threads", "number of threads to use",
-        cxxopts::value<std::uint32_t>()->default_value("1"));
+        cxxopts::value<std::uint32_t>()->default_value("1"))
+      ("metrics", "write per stage and per batch metrics as json to this file",
+        cxxopts::value<std::string>())
+      ("max-memory",
+       "memory budget, eg. 512M or 16G; batches are sized to fit into it",
+        cxxopts::value<std::string>())
+      ("shard",
+       "i/n: map only the i-th of n shares of the length windows and write "
+       "the shard's candidates for sniff merge",
+        cxxopts::value<std::string>());
     options.add_options("heuristic")
       ("a,alpha",
        "shorter read length as percentage of longer read lenght in pair",
         cxxopts::value<double>()->default_value("0.10"))
       ("b,beta", "minimum required coverage on each read",
-        cxxopts::value<double>()->default_value("0.90"));
+        cxxopts::value<double>()->default_value("0.90"))
+      ("max-targets",
+       "chain each query only with the targets sharing most seeds with it",
+        cxxopts::value<std::uint32_t>()->default_value("16"))
+      ("target-share",
+       "chain each query only with targets sharing at least this share of "
+       "the seeds of its best target",
+        cxxopts::value<double>()->default_value("0.2"))
+      ("m,model",
+       "LightGBM text model used to filter pairs "
+       "(see scripts/inference/export_lgbm_model.py)",
+        cxxopts::value<std::string>());
     options.add_options("mapping")
       ("k,kmer-length", "kmer length used in mapping",
         cxxopts::value<std::uint32_t>()->default_value("15"))
       ("w,window-length", "window length used in mapping",
         cxxopts::value<std::uint32_t>()->default_value("5"))
-      ("f,frequent", "filter f most frequent kmers",
+      ("canonical",
+       "sketch each read once with strand aware canonical minimizers")
+      ("seeding",
+       "seeds: minimizer, open-syncmer, closed-syncmer or randstrobe; "
+       "randstrobes link each closed syncmer of half the k and s with one "
+       "of the next w",
+        cxxopts::value<std::string>()->default_value("minimizer"))
+      ("s,syncmer-length", "s-mer length of syncmers and randstrobes",
+        cxxopts::value<std::uint32_t>()->default_value("9"))
+      ("f,frequent", "filter f most frequent kmers of the whole input",
         cxxopts::value<double>()->default_value("0.0002"));
     options.add_options("input")
-      ("input", "input fasta/fastq file", cxxopts::value<std::string>());
+      ("input", "input fasta/fastq file", cxxopts::value<std::string>())
+      ("streaming",
+       "keep only reads of the current batch in memory; reads the input three "
+       "times, gzipped input from an inflated copy in the temporary directory")
+      ("cache",
+       "sketch and index cache file; built by the first run and memory mapped "
+       "by later runs with the same input, k, w, -f, --canonical and seeding",
+        cxxopts::value<std::string>())
+      ("state",
+       "incremental runs: reads of earlier runs and their best partners are "
+       "kept in this file; the input only holds new reads",
+        cxxopts::value<std::string>());
+    options.add_options("output")
+      ("format", "output format: csv, paf or binary",
+        cxxopts::value<std::string>()->default_value("csv"))
+      ("z,compress", "gzip compress the output");
     /* clang-format on */
 
     options.positional_help("<reads>");
@@ -75,6 +268,39 @@ int main(int argc, char** argv) {
     auto const reads_path =
         std::filesystem::path(result["input"].as<std::string>());
 
+    auto const model =
+        result.count("model")
+            ? std::optional(sniff::LoadModel(result["model"].as<std::string>()))
+            : std::nullopt;
+
+    auto const output_cfg = sniff::OutputConfig{
+        .format = sniff::ParseOutputFormat(result["format"].as<std::string>()),
+        .compress = result.count("compress") > 0};
+
+    auto const metrics = result.count("metrics")
+                             ? std::make_unique<sniff::Metrics>()
+                             : nullptr;
+    if (metrics) {
+      is_counting_allocations = true;
+      sniff::SetAllocationCounter(
+          []() -> std::uint64_t { return allocated_bytes; });
+    }
+
+    auto const shard = result.count("shard")
+                           ? ParseShard(result["shard"].as<std::string>())
+                           : std::pair<std::uint32_t, std::uint32_t>(0, 1);
+    if (result.count("shard") && result.count("cache")) {
+      throw std::invalid_argument(
+          "[sniff::main] --shard can not be combined with --cache");
+    }
+    if (result.count("state") &&
+        (result.count("shard") || result.count("cache") ||
+         result.count("streaming"))) {
+      throw std::invalid_argument(
+          "[sniff::main] --state can not be combined with --shard, --cache or "
+          "--streaming");
+    }
+
     auto task_arena = tbb::task_arena(n_threads);
     auto timer = biosoup::Timer();
     timer.Start();
@@ -85,32 +311,121 @@ int main(int argc, char** argv) {
           .beta_p = result["beta"].as<double>(),
           .filter_freq = result["frequent"].as<double>(),
           .kmer_len = result["kmer-length"].as<std::uint32_t>(),
-          .window_len = result["window-length"].as<std::uint32_t>()};
+          .window_len = result["window-length"].as<std::uint32_t>(),
+          .canonical = result.count("canonical") > 0,
+          .seeding = sniff::ParseSeeding(result["seeding"].as<std::string>()),
+          .syncmer_len = result["syncmer-length"].as<std::uint32_t>(),
+          .max_targets = result["max-targets"].as<std::uint32_t>(),
+          .min_target_share = result["target-share"].as<double>(),
+          .max_memory = result.count("max-memory")
+                            ? ParseMemorySize(
+                                  result["max-memory"].as<std::string>())
+                            : 0,
+          .shard_index = shard.first,
+          .n_shards = shard.second};
 
       /* clang-format off */
         fmt::print(stderr,
           "[sniff]\n"
           "\tthreads: {}\n"
           "\talpha: {:1.2f}; beta: {:1.2f}\n"
-          "\tfilter-freq: {}; k: {}; w: {};\n",
+          "\tfilter-freq: {}; k: {}; w: {};\n"
+          "\tseeding: {}; s: {};\n",
           n_threads,
           cfg.alpha_p, cfg.beta_p,
-          cfg.filter_freq, cfg.kmer_len, cfg.window_len);
+          cfg.filter_freq, cfg.kmer_len, cfg.window_len,
+          result["seeding"].as<std::string>(), cfg.syncmer_len);
       /* clang-format on */
 
-      auto overlaps =
-          sniff::FindReverseComplementPairs(cfg, sniff::LoadReads(reads_path));
-      fmt::print(
-          "query_name,query_length,query_start,"
-          "query_end,target_name,target_length,target_start,target_end\n");
-      for (auto const& ovlp : overlaps) {
-        fmt::print("{},{},{},{},{},{},{},{}\n", ovlp.query_name,
-                   ovlp.query_length, ovlp.query_start, ovlp.query_end,
-                   ovlp.target_name, ovlp.target_length, ovlp.target_start,
-                   ovlp.target_end);
+      // shards write their candidates as they are; the model is applied to
+      // the merged pairs
+      if (result.count("shard")) {
+        auto candidates = sniff::ShardCandidates();
+        if (result.count("streaming")) {
+          candidates =
+              sniff::FindShardCandidates(cfg, reads_path, metrics.get());
+        } else {
+          auto reads = sniff::CountedReads();
+          {
+            auto const stage_timer =
+                sniff::StageTimer(metrics.get(), sniff::Stage::kLoad);
+            reads = sniff::LoadCountedReads(cfg, reads_path, metrics.get());
+          }
+          candidates = sniff::FindShardCandidates(cfg, std::move(reads),
+                                                  metrics.get());
+        }
+
+        auto const stage_timer =
+            sniff::StageTimer(metrics.get(), sniff::Stage::kOutput);
+        sniff::WriteShard(candidates, STDOUT_FILENO);
+        return;
+      }
+
+      auto pairs = sniff::NamedOverlaps();
+      if (result.count("state")) {
+        auto const state_path =
+            std::filesystem::path(result["state"].as<std::string>());
+        auto state = sniff::LoadRunState(state_path);
+        if (!state) {
+          state.emplace(cfg.kmer_len, cfg.window_len, cfg.canonical,
+                        cfg.seeding, cfg.syncmer_len, cfg.filter_freq);
+        }
+        auto const shared_state =
+            std::make_shared<sniff::RunState>(std::move(*state));
+
+        auto reads = sniff::CountedReads();
+        {
+          auto const stage_timer =
+              sniff::StageTimer(metrics.get(), sniff::Stage::kLoad);
+          reads = sniff::LoadCountedReads(cfg, reads_path, *shared_state,
+                                          metrics.get());
+        }
+        pairs = sniff::FindReverseComplementPairs(cfg, std::move(reads),
+                                                  shared_state, metrics.get());
+        sniff::SaveRunState(*shared_state, state_path);
+      } else if (result.count("cache")) {
+        pairs = sniff::FindReverseComplementPairs(
+            cfg, reads_path, result["cache"].as<std::string>(), metrics.get());
+      } else if (result.count("streaming")) {
+        pairs =
+            sniff::FindReverseComplementPairs(cfg, reads_path, metrics.get());
+      } else {
+        auto reads = sniff::CountedReads();
+        {
+          auto const stage_timer =
+              sniff::StageTimer(metrics.get(), sniff::Stage::kLoad);
+          reads = sniff::LoadCountedReads(cfg, reads_path, metrics.get());
+        }
+        pairs = sniff::FindReverseComplementPairs(cfg, std::move(reads),
+                                                  metrics.get());
+      }
+
+      if (model) {
+        auto const stage_timer =
+            sniff::StageTimer(metrics.get(), sniff::Stage::kMerge);
+        pairs.overlaps =
+            sniff::FilterOverlaps(*model, std::move(pairs.overlaps));
       }
+
+      if (metrics) {
+        metrics->Add(sniff::Counter::kPairs, pairs.overlaps.size());
+      }
+
+      auto const stage_timer =
+          sniff::StageTimer(metrics.get(), sniff::Stage::kOutput);
+      sniff::WriteOverlaps(output_cfg, pairs.overlaps, STDOUT_FILENO);
     });
 
+    if (metrics) {
+      auto const metrics_path = result["metrics"].as<std::string>();
+      auto metrics_file = std::ofstream(metrics_path);
+      metrics_file << metrics->ToJson();
+      if (!metrics_file) {
+        throw std::runtime_error("[sniff::main] failed to write metrics: " +
+                                 metrics_path);
+      }
+    }
+
     fmt::print(stderr, "[sniff::main]({:12.3f}) peak rss {:0.3f} GB\n",
                timer.Stop(), static_cast<double>(GetPeakMemoryUsageKB()) / 1e6);
   } catch (std::exception const& e) {
@@ -4,75 +4,123 @@
 #include <limits>
 #include <span>
 
-static auto CmpMatchByTargetPos(sniff::Match const& lhs,
-                                sniff::Match const& rhs) -> bool {
-  return lhs.target_pos < rhs.target_pos;
+static constexpr auto kNoPredecessor =
+    std::numeric_limits<std::uint32_t>::max();
+
+static auto CmpMatchByTargetQueryPos(sniff::Match const& lhs,
+                                     sniff::Match const& rhs) -> bool {
+  return lhs.target_pos != rhs.target_pos ? lhs.target_pos < rhs.target_pos
+                                          : lhs.query_pos < rhs.query_pos;
+}
+
+// Score of appending a match at distance (query_dist, target_dist) to a chain;
+// gains the newly covered bases, at most kmer_len, and pays ~0.16 per base of
+// diagonal drift. Non-positive for matches that can not precede each other.
+static auto ExtensionScore(std::int32_t query_dist, std::int32_t target_dist,
+                           std::int32_t kmer_len, std::int32_t max_gap)
+    -> std::int32_t {
+  auto const drift = query_dist > target_dist ? query_dist - target_dist
+                                              : target_dist - query_dist;
+  auto const gain = std::min(std::min(query_dist, target_dist), kmer_len);
+  auto const cost = (drift * 5 + 31) >> 5;
+
+  auto const is_valid =
+      query_dist > 0 && target_dist > 0 && query_dist <= max_gap;
+  return is_valid ? gain - cost : std::numeric_limits<std::int32_t>::min() / 2;
 }
 
 namespace sniff {
 
-static auto FindLongestQueryChain(std::span<Match const> matches)
-    -> std::vector<Match> {
-  auto n = static_cast<std::uint32_t>(matches.size());
+auto Map(MapConfig cfg, std::span<Match const> src_matches,
+         MapBuffers* buffers, std::vector<Overlap>* dst) -> void {
+  auto const n = src_matches.size();
+  if (n == 0) {
+    return;
+  }
+
+  auto& matches = buffers->matches;
+  matches.assign(src_matches.begin(), src_matches.end());
+  std::sort(matches.begin(), matches.end(), CmpMatchByTargetQueryPos);
+
+  // positions are copied out into flat arrays so the predecessor loop below
+  // compiles to straight vector code
+  auto& query_pos = buffers->query_pos;
+  auto& target_pos = buffers->target_pos;
+  query_pos.resize(n);
+  target_pos.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    query_pos[i] = static_cast<std::int32_t>(matches[i].query_pos);
+    target_pos[i] = static_cast<std::int32_t>(matches[i].target_pos);
+  }
 
-  auto prev = std::vector<std::uint32_t>(n + 1, n);
-  auto chain = std::vector<std::uint32_t>{n, 0};
+  auto& scores = buffers->scores;
+  auto& prev = buffers->prev;
+  auto& candidates = buffers->candidates;
+  scores.resize(n);
+  prev.resize(n);
+  candidates.resize(cfg.max_chain_lookback);
 
-  chain.reserve(n + 1);
-  for (std::uint32_t match_idx = 1; match_idx < n; ++match_idx) {
-    auto idx = std::lower_bound(
-                   chain.begin() + 1, chain.end(), matches[match_idx],
-                   [matches](std::uint32_t index, Match const& match) -> bool {
-                     return matches[index].query_pos < match.query_pos;
-                   }) -
-               chain.begin();
+  auto const kmer_len = static_cast<std::int32_t>(cfg.kmer_len);
+  auto const max_gap = static_cast<std::int32_t>(cfg.max_chain_gap_length);
 
-    if (idx == chain.size()) {
-      chain.emplace_back();
+  auto best = std::size_t(0);
+  for (std::size_t i = 0, window_first = 0; i < n; ++i) {
+    while (target_pos[i] - target_pos[window_first] > max_gap) {
+      ++window_first;
+    }
+
+    auto const first = std::max(
+        window_first, i - std::min<std::size_t>(i, cfg.max_chain_lookback));
+    auto const len = i - first;
+    auto const query_end = query_pos[i];
+    auto const target_end = target_pos[i];
+    for (std::size_t j = 0; j < len; ++j) {
+      candidates[j] = scores[first + j] +
+                      ExtensionScore(query_end - query_pos[first + j],
+                                     target_end - target_pos[first + j],
+                                     kmer_len, max_gap);
+    }
+
+    scores[i] = kmer_len;
+    prev[i] = kNoPredecessor;
+    for (std::size_t j = 0; j < len; ++j) {
+      if (candidates[j] > scores[i]) {
+        scores[i] = candidates[j];
+        prev[i] = first + j;
+      }
     }
 
-    chain[idx] = match_idx;
-    prev[match_idx] = chain[idx - 1];
+    if (scores[i] >= scores[best]) {
+      best = i;
+    }
   }
 
-  auto dst = std::vector<Match>(chain.size() - 1);
-  for (std::uint32_t dst_idx = chain.size() - 2, curr_idx = chain.back();
-       curr_idx != n; --dst_idx) {
-    dst[dst_idx] = matches[curr_idx];
-    curr_idx = prev[curr_idx];
+  auto chain_first = best;
+  auto chain_length = std::uint32_t(1);
+  for (; prev[chain_first] != kNoPredecessor; ++chain_length) {
+    chain_first = prev[chain_first];
   }
 
-  return dst;
-};
+  if (chain_length < cfg.min_chain_length) {
+    return;
+  }
 
-auto Map(MapConfig cfg, std::span<Match const> src_matches)
-    -> std::vector<Overlap> {
-  auto matches = std::vector<Match>(src_matches.begin(), src_matches.end());
-  std::sort(matches.begin(), matches.end(), CmpMatchByTargetPos);
-  matches.push_back(
-      Match{.query_pos = std::numeric_limits<std::uint32_t>::max(),
-            .target_pos = std::numeric_limits<std::uint32_t>::max()});
+  auto const& front = matches[chain_first];
+  auto const& back = matches[best];
+  dst->push_back(Overlap{.query_id = front.query_id,
+                         .query_start = front.query_pos,
+                         .query_end = back.query_pos + cfg.kmer_len,
+
+                         .target_id = front.target_id,
+                         .target_start = front.target_pos,
+                         .target_end = back.target_pos + cfg.kmer_len});
+}
 
+auto Map(MapConfig cfg, std::span<Match const> matches)
+    -> std::vector<Overlap> {
+  auto buffers = MapBuffers();
   auto dst = std::vector<Overlap>();
-  for (std::size_t i = 1, j = 0; i < matches.size(); ++i) {
-    if (matches[i].target_pos - matches[i - 1].target_pos >
-        cfg.max_chain_gap_length) {
-      if (i - j >= cfg.min_chain_length) {
-        auto chain = FindLongestQueryChain(
-            std::span(matches.cbegin() + j, matches.cbegin() + i));
-
-        dst.push_back(
-            Overlap{.query_id = chain.front().query_id,
-                    .query_start = chain.front().query_pos,
-                    .query_end = chain.back().query_pos + cfg.kmer_len,
-
-                    .target_id = chain.front().target_id,
-                    .target_start = chain.front().target_pos,
-                    .target_end = chain.back().target_pos + cfg.kmer_len});
-      }
-      j = i;
-    }
-  }
+  Map(cfg, matches, &buffers, &dst);
 
   return dst;
 }
@@ -1,5 +1,7 @@
 #include "sniff/match.h"
 
+#include <algorithm>
+
 namespace sniff {
 
 static auto CmpKMerByValPos(KMer const& lhs, KMer const& rhs) -> bool {
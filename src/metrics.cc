@@ -0,0 +1,272 @@
+#include "sniff/metrics.h"
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+// 3rd party
+#include "fmt/core.h"
+#include "tbb/enumerable_thread_specific.h"
+
+static constexpr auto kStageNames = std::array<std::string_view, 9>{
+    "load",   "sketch", "sort",  "index",  "threshold",
+    "lookup", "chain",  "merge", "output",
+};
+
+static constexpr auto kCounterNames = std::array<std::string_view, 10>{
+    "reads",
+    "bases",
+    "minimizers",
+    "hits",
+    "postings_filtered_by_frequency",
+    "hits_rejected_by_length_ratio",
+    "hits_rejected_by_votes",
+    "chains",
+    "overlaps",
+    "pairs",
+};
+
+static_assert(kStageNames.size() == sniff::kNumStages);
+static_assert(kCounterNames.size() == sniff::kNumCounters);
+
+static auto allocation_counter =
+    std::atomic<sniff::AllocationCounter>(nullptr);
+
+static auto AllocatedBytes() -> std::uint64_t {
+  auto const counter = allocation_counter.load(std::memory_order_relaxed);
+  return counter ? counter() : 0;
+}
+
+// Cpu cycles and cache misses of the calling thread in user space, read as
+// one perf event group. Virtual machines and containers often do not expose
+// them, in which case both read as zero.
+class HardwareCounters {
+ public:
+  HardwareCounters() {
+    leader_ = Open(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (leader_ != -1) {
+      member_ = Open(PERF_COUNT_HW_CACHE_MISSES, leader_);
+    }
+  }
+
+  HardwareCounters(HardwareCounters const&) = delete;
+  auto operator=(HardwareCounters const&) -> HardwareCounters& = delete;
+
+  ~HardwareCounters() {
+    if (member_ != -1) {
+      close(member_);
+    }
+    if (leader_ != -1) {
+      close(leader_);
+    }
+  }
+
+  auto IsAvailable() const -> bool { return member_ != -1; }
+
+  auto Read() const -> std::array<std::uint64_t, 2> {
+    struct {
+      std::uint64_t n;
+      std::array<std::uint64_t, 2> values;
+    } group = {};
+
+    if (!IsAvailable() || read(leader_, &group, sizeof(group)) == -1) {
+      return {0, 0};
+    }
+
+    return group.values;
+  }
+
+ private:
+  static auto Open(std::uint64_t config, int group_fd) -> int {
+    auto attr = perf_event_attr();
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+  }
+
+  int leader_ = -1;
+  int member_ = -1;
+};
+
+static auto ThreadHardwareCounters() -> HardwareCounters const& {
+  static thread_local auto const counters = HardwareCounters();
+  return counters;
+}
+
+struct StageTotals {
+  std::uint64_t calls;
+  std::uint64_t nanoseconds;
+  std::uint64_t bytes_allocated;
+  std::uint64_t cycles;
+  std::uint64_t cache_misses;
+};
+
+// Stage totals are only touched by the owning thread; counters may be summed
+// up while other threads still add to them.
+struct ThreadMetrics {
+  std::array<StageTotals, sniff::kNumStages> stages = {};
+  std::array<std::atomic<std::uint64_t>, sniff::kNumCounters> counters = {};
+};
+
+template <class Names, class Values>
+static auto AppendObject(Names const& names, Values const& values,
+                         std::string* dst) -> void {
+  dst->push_back('{');
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    fmt::format_to(std::back_inserter(*dst), "{}\"{}\": {}", i ? ", " : "",
+                   names[i], values[i]);
+  }
+  dst->push_back('}');
+}
+
+namespace sniff {
+
+struct Metrics::Impl {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  tbb::enumerable_thread_specific<ThreadMetrics> threads;
+  std::vector<BatchMetrics> batches;
+};
+
+Metrics::Metrics() : impl_(std::make_unique<Impl>()) {}
+
+Metrics::~Metrics() = default;
+
+auto Metrics::Add(Counter counter, std::uint64_t n) -> void {
+  impl_->threads.local()
+      .counters[static_cast<std::size_t>(counter)]
+      .fetch_add(n, std::memory_order_relaxed);
+}
+
+auto Metrics::Totals() const -> Counters {
+  auto dst = Counters{};
+  for (auto const& thread : impl_->threads) {
+    for (std::size_t i = 0; i < kNumCounters; ++i) {
+      dst[i] += thread.counters[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  return dst;
+}
+
+auto Metrics::AddBatch(BatchMetrics const& batch) -> void {
+  impl_->batches.push_back(batch);
+}
+
+auto Metrics::ToJson() const -> std::string {
+  auto stages = std::array<StageTotals, kNumStages>{};
+  for (auto const& thread : impl_->threads) {
+    for (std::size_t i = 0; i < kNumStages; ++i) {
+      stages[i].calls += thread.stages[i].calls;
+      stages[i].nanoseconds += thread.stages[i].nanoseconds;
+      stages[i].bytes_allocated += thread.stages[i].bytes_allocated;
+      stages[i].cycles += thread.stages[i].cycles;
+      stages[i].cache_misses += thread.stages[i].cache_misses;
+    }
+  }
+
+  struct rusage rusage_info;
+  getrusage(RUSAGE_SELF, &rusage_info);
+
+  auto const has_hardware_counters =
+      ThreadHardwareCounters().IsAvailable();
+  auto const has_allocation_counter =
+      allocation_counter.load(std::memory_order_relaxed) != nullptr;
+  auto const wall_seconds = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - impl_->start)
+                                .count();
+
+  auto dst = std::string();
+  auto out = std::back_inserter(dst);
+  fmt::format_to(out,
+                 "{{\n  \"version\": 1,\n  \"wall_seconds\": {:.6f},\n"
+                 "  \"peak_rss_bytes\": {},\n"
+                 "  \"hardware_counters\": {},\n  \"stages\": {{",
+                 wall_seconds, std::uint64_t(rusage_info.ru_maxrss) * 1'024,
+                 has_hardware_counters);
+
+  for (std::size_t i = 0; i < kNumStages; ++i) {
+    auto const& stage = stages[i];
+    fmt::format_to(out,
+                   "{}\n    \"{}\": {{\"calls\": {}, \"seconds\": {:.6f}, "
+                   "\"bytes_allocated\": {}, ",
+                   i ? "," : "", kStageNames[i], stage.calls,
+                   stage.nanoseconds / 1e9,
+                   has_allocation_counter
+                       ? std::to_string(stage.bytes_allocated)
+                       : std::string("null"));
+    if (has_hardware_counters) {
+      fmt::format_to(out, "\"cycles\": {}, \"cache_misses\": {}}}",
+                     stage.cycles, stage.cache_misses);
+    } else {
+      fmt::format_to(out, "\"cycles\": null, \"cache_misses\": null}}");
+    }
+  }
+
+  dst += "\n  },\n  \"counters\": ";
+  AppendObject(kCounterNames, Totals(), &dst);
+
+  dst += ",\n  \"batches\": [";
+  for (std::size_t i = 0; i < impl_->batches.size(); ++i) {
+    auto const& batch = impl_->batches[i];
+    fmt::format_to(
+        out,
+        "{}\n    {{\"first_query\": {}, \"first_target\": {}, \"last\": {}, "
+        "\"index_targets\": {}, \"threshold\": {}, "
+        "\"prepare_seconds\": {:.6f}, \"map_seconds\": {:.6f}, "
+        "\"counters\": ",
+        i ? "," : "", batch.first_query, batch.first_target, batch.last,
+        batch.index_targets, batch.threshold, batch.prepare_seconds,
+        batch.map_seconds);
+    AppendObject(kCounterNames, batch.counters, &dst);
+    dst.push_back('}');
+  }
+  dst += "\n  ]\n}\n";
+
+  return dst;
+}
+
+StageTimer::StageTimer(Metrics* metrics, Stage stage)
+    : metrics_(metrics), stage_(stage) {
+  if (metrics_) {
+    start_ = std::chrono::steady_clock::now();
+    start_bytes_allocated_ = AllocatedBytes();
+    start_hardware_counters_ = ThreadHardwareCounters().Read();
+  }
+}
+
+StageTimer::~StageTimer() {
+  if (!metrics_) {
+    return;
+  }
+
+  auto const hardware_counters = ThreadHardwareCounters().Read();
+  auto& totals =
+      metrics_->impl_->threads.local().stages[static_cast<std::size_t>(stage_)];
+
+  ++totals.calls;
+  totals.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start_)
+                            .count();
+  totals.bytes_allocated += AllocatedBytes() - start_bytes_allocated_;
+  totals.cycles += hardware_counters[0] - start_hardware_counters_[0];
+  totals.cache_misses += hardware_counters[1] - start_hardware_counters_[1];
+}
+
+auto SetAllocationCounter(AllocationCounter counter) -> void {
+  allocation_counter.store(counter, std::memory_order_relaxed);
+}
+
+}  // namespace sniff
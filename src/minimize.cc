@@ -1,10 +1,21 @@
 #include "sniff/minimize.h"
 
 #include <algorithm>
-#include <deque>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+// 3rd party
+#include "biosoup/nucleic_acid.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SNIFF_X86_DISPATCH
+#include <immintrin.h>
+#endif
 
 /* clang-format off */
-constexpr static std::uint8_t kNucleotideCoder[] = {
+constexpr static std::uint8_t kNucleotideCoder[256] = {
     255, 255, 255, 255, 255, 255, 255, 255,
     255, 255, 255, 255, 255, 255, 255, 255,
     255, 255, 255, 255, 255, 255, 255, 255,
@@ -20,7 +31,23 @@ constexpr static std::uint8_t kNucleotideCoder[] = {
     255,   0,   1,   1,   0, 255, 255,   2,
       3, 255, 255,   2, 255,   1,   0, 255,
     255, 255,   0,   1,   3,   3,   2,   0,
-    255,   3, 255, 255, 255, 255, 255, 255
+    255,   3, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255
 };
 
 static constexpr char kNucleotideDecoder[] = {
@@ -29,6 +56,11 @@ static constexpr char kNucleotideDecoder[] = {
 
 /* clang-format on */
 
+static constexpr auto kBlockSize = 256U;
+
+// strand value of canonical k-mers which equal their reverse complement
+static constexpr auto kNoStrand = std::uint8_t(2);
+
 auto Hash(std::uint64_t val, std::uint64_t const kMask) -> std::uint64_t {
   val = ((~val) + (val << 21)) & kMask;
   val = val ^ (val >> 24);
@@ -40,6 +72,145 @@ auto Hash(std::uint64_t val, std::uint64_t const kMask) -> std::uint64_t {
   return val;
 }
 
+static auto HashBlockScalar(std::uint64_t const* src, std::uint64_t* dst,
+                            std::size_t n, std::uint64_t mask) -> void {
+  for (std::size_t i = 0; i < n; ++i) {
+    dst[i] = Hash(src[i], mask);
+  }
+}
+
+#ifdef SNIFF_X86_DISPATCH
+
+__attribute__((target("avx2"))) static auto HashBlockAvx2(
+    std::uint64_t const* src, std::uint64_t* dst, std::size_t n,
+    std::uint64_t mask) -> void {
+  auto const mask_vec = _mm256_set1_epi64x(mask);
+  auto const ones = _mm256_set1_epi64x(-1LL);
+
+  auto i = std::size_t(0);
+  for (; i + 4 <= n; i += 4) {
+    auto val =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+    val = _mm256_and_si256(
+        _mm256_add_epi64(_mm256_xor_si256(val, ones),
+                         _mm256_slli_epi64(val, 21)),
+        mask_vec);
+    val = _mm256_xor_si256(val, _mm256_srli_epi64(val, 24));
+    val = _mm256_and_si256(
+        _mm256_add_epi64(_mm256_add_epi64(val, _mm256_slli_epi64(val, 3)),
+                         _mm256_slli_epi64(val, 8)),
+        mask_vec);
+    val = _mm256_xor_si256(val, _mm256_srli_epi64(val, 14));
+    val = _mm256_and_si256(
+        _mm256_add_epi64(_mm256_add_epi64(val, _mm256_slli_epi64(val, 2)),
+                         _mm256_slli_epi64(val, 4)),
+        mask_vec);
+    val = _mm256_xor_si256(val, _mm256_srli_epi64(val, 28));
+    val = _mm256_and_si256(_mm256_add_epi64(val, _mm256_slli_epi64(val, 31)),
+                           mask_vec);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), val);
+  }
+
+  HashBlockScalar(src + i, dst + i, n - i, mask);
+}
+
+static auto HashBlockSse2(std::uint64_t const* src, std::uint64_t* dst,
+                          std::size_t n, std::uint64_t mask) -> void {
+  auto const mask_vec = _mm_set1_epi64x(mask);
+  auto const ones = _mm_set1_epi64x(-1LL);
+
+  auto i = std::size_t(0);
+  for (; i + 2 <= n; i += 2) {
+    auto val = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+    val = _mm_and_si128(
+        _mm_add_epi64(_mm_xor_si128(val, ones), _mm_slli_epi64(val, 21)),
+        mask_vec);
+    val = _mm_xor_si128(val, _mm_srli_epi64(val, 24));
+    val = _mm_and_si128(
+        _mm_add_epi64(_mm_add_epi64(val, _mm_slli_epi64(val, 3)),
+                      _mm_slli_epi64(val, 8)),
+        mask_vec);
+    val = _mm_xor_si128(val, _mm_srli_epi64(val, 14));
+    val = _mm_and_si128(
+        _mm_add_epi64(_mm_add_epi64(val, _mm_slli_epi64(val, 2)),
+                      _mm_slli_epi64(val, 4)),
+        mask_vec);
+    val = _mm_xor_si128(val, _mm_srli_epi64(val, 28));
+    val = _mm_and_si128(_mm_add_epi64(val, _mm_slli_epi64(val, 31)), mask_vec);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), val);
+  }
+
+  HashBlockScalar(src + i, dst + i, n - i, mask);
+}
+
+#endif
+
+using HashBlockFn = void (*)(std::uint64_t const*, std::uint64_t*,
+                             std::size_t, std::uint64_t);
+
+static auto SelectHashBlock() -> HashBlockFn {
+#ifdef SNIFF_X86_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return HashBlockAvx2;
+  }
+  return HashBlockSse2;
+#else
+  return HashBlockScalar;
+#endif
+}
+
+static HashBlockFn const kHashBlock = SelectHashBlock();
+
+// Monotone queue of window candidates kept in a fixed power of two ring; it
+// never holds more than window_len + 1 k-mers.
+class MinimizerQueue {
+ public:
+  explicit MinimizerQueue(std::uint32_t window_len)
+      : window_len_(window_len),
+        mask_(std::bit_ceil(window_len + 2U) - 1U),
+        buffer_(mask_ + 1U) {}
+
+  // Emits the minimizer of the window_len k-mers preceding position.
+  auto Emit(std::uint32_t position, std::vector<sniff::KMer>& dst) -> void {
+    if (position < window_len_) {
+      return;
+    }
+
+    if (head_ != tail_ &&
+        buffer_[head_ & mask_].kmer.position < position - window_len_) {
+      ++head_;
+    }
+
+    if (head_ != tail_) {
+      auto const& front = buffer_[head_ & mask_].kmer;
+      if (dst.empty() || dst.back().position != front.position) {
+        dst.push_back(front);
+      }
+    }
+  }
+
+  auto Push(std::uint64_t hash, sniff::KMer kmer) -> void {
+    while (head_ != tail_ && buffer_[(tail_ - 1U) & mask_].hash > hash) {
+      --tail_;
+    }
+
+    buffer_[tail_++ & mask_] = Entry{.hash = hash, .kmer = kmer};
+  }
+
+ private:
+  struct Entry {
+    std::uint64_t hash;
+    sniff::KMer kmer;
+  };
+
+  std::uint32_t window_len_;
+  std::uint32_t mask_;
+  std::vector<Entry> buffer_;
+  std::uint32_t head_ = 0;
+  std::uint32_t tail_ = 0;
+};
+
 static auto CmpKMerByVal(sniff::KMer const& lhs,
                          sniff::KMer const& rhs) noexcept -> bool {
   return lhs.value < rhs.value;
@@ -50,56 +221,421 @@ static auto CmpKMerByPos(sniff::KMer const& lhs,
   return lhs.position < rhs.position;
 }
 
-namespace sniff {
+// Rolls k-mers over a stream of 2-bit base codes and selects minimizers. K-mers
+// are staged and hashed kBlockSize at a time so the hashing runs over
+// contiguous arrays, then fed through the ring buffer in order.
+class MinimizerStream {
+ public:
+  MinimizerStream(sniff::MinimizeConfig cfg, std::uint32_t sequence_len)
+      : cfg_(cfg),
+        sequence_len_(sequence_len),
+        mask_((1ULL << (static_cast<std::uint64_t>(cfg.kmer_len) * 2U)) -
+              1ULL),
+        rc_shift_((static_cast<std::uint64_t>(cfg.kmer_len) - 1U) * 2U),
+        queue_(cfg.window_len) {
+    // random sequences yield 2 / (w + 1) minimizers per k-mer; leave some
+    // slack so that typical reads never trigger a reallocation
+    if (sequence_len >= cfg.kmer_len) {
+      dst_.reserve(5U * (sequence_len - cfg.kmer_len + 1U) /
+                       (2U * (cfg.window_len + 1U)) +
+                   1U);
+    }
+  }
 
-auto Minimize(MinimizeConfig cfg, std::string_view sequence)
-    -> std::vector<KMer> {
-  auto dst = std::vector<KMer>();
+  auto Push(std::uint64_t code) -> void {
+    kmer_ = ((kmer_ << 2ULL) | code) & mask_;
+    rc_kmer_ = (rc_kmer_ >> 2ULL) | ((3ULL ^ code) & 3ULL) << rc_shift_;
+    if (++n_bases_ < cfg_.kmer_len) {
+      return;
+    }
 
-  auto const mask =
-      (1ULL << (static_cast<std::uint64_t>(cfg.kmer_len) * 2U)) - 1ULL;
-  auto const shift_kmer = [mask](std::uint64_t kmer_val,
-                                 char base) -> std::uint64_t {
-    return ((kmer_val << 2ULL) | kNucleotideCoder[base]) & mask;
-  };
+    if (!cfg_.canonical) {
+      values_[n_staged_] = kmer_;
+      strands_[n_staged_] = 0;
+    } else if (kmer_ != rc_kmer_) {
+      strands_[n_staged_] = rc_kmer_ < kmer_;
+      values_[n_staged_] = strands_[n_staged_] ? rc_kmer_ : kmer_;
+    } else {  // palindromes have no defined strand
+      values_[n_staged_] = kmer_;
+      strands_[n_staged_] = kNoStrand;
+    }
 
-  auto window = std::deque<std::pair<std::uint64_t, KMer>>();
-  auto const window_push = [&window](std::uint64_t hash, KMer kmer) -> void {
-    while (!window.empty() && window.back().first > hash) {
-      window.pop_back();
+    if (++n_staged_ == kBlockSize) {
+      Flush();
     }
+  }
 
-    window.emplace_back(hash, kmer);
-  };
+  auto Finish() -> std::vector<sniff::KMer> {
+    Flush();
+    if (cfg_.minhash) {
+      std::sort(dst_.begin(), dst_.end(), CmpKMerByVal);
+      dst_.resize(sequence_len_ / cfg_.kmer_len);
+      std::sort(dst_.begin(), dst_.end(), CmpKMerByPos);
+    }
+
+    return std::move(dst_);
+  }
+
+ private:
+  auto Flush() -> void {
+    kHashBlock(values_.data(), hashes_.data(), n_staged_, mask_);
+
+    auto const first = n_bases_ - cfg_.kmer_len + 1U - n_staged_;
+    for (std::uint32_t i = 0; i < n_staged_; ++i) {
+      queue_.Emit(first + i, dst_);
+      if (strands_[i] != kNoStrand) {
+        queue_.Push(hashes_[i], sniff::KMer{.position = first + i,
+                                            .value = values_[i],
+                                            .strand = strands_[i]});
+      }
+    }
+
+    n_staged_ = 0;
+  }
+
+  sniff::MinimizeConfig cfg_;
+  std::uint32_t sequence_len_;
+  std::uint64_t mask_;
+  std::uint64_t rc_shift_;
+
+  std::uint64_t kmer_ = 0;
+  std::uint64_t rc_kmer_ = 0;
+  std::uint32_t n_bases_ = 0;
+
+  std::uint32_t n_staged_ = 0;
+  std::array<std::uint64_t, kBlockSize> values_;
+  std::array<std::uint64_t, kBlockSize> hashes_;
+  std::array<std::uint8_t, kBlockSize> strands_;
+
+  MinimizerQueue queue_;
+  std::vector<sniff::KMer> dst_;
+};
+
+// Randstrobes link two strobes of half the k-mer length, so that a seed needs
+// about k intact bases as other seeds do; strobes are closed syncmers of
+// ceil(k / 2) bases over s-mers of floor(s / 2) bases.
+static auto StrobeConfig(sniff::MinimizeConfig cfg) -> sniff::MinimizeConfig {
+  if (cfg.seeding == sniff::Seeding::kRandstrobe) {
+    cfg.kmer_len = (cfg.kmer_len + 1U) / 2U;
+    cfg.syncmer_len /= 2U;
+  }
+
+  return cfg;
+}
 
-  auto const window_update = [&window](std::size_t window_start) {
-    if (!window.empty() && window.front().second.position < window_start) {
-      window.pop_front();
+// Rolls k-mers and their s-mers over a stream of 2-bit base codes and keeps
+// the k-mers whose smallest s-mer, leftmost on ties, sits at a syncmer offset.
+// Randstrobes link the kept closed syncmers once the sequence is complete.
+class SyncmerStream {
+ public:
+  SyncmerStream(sniff::MinimizeConfig cfg, std::uint32_t sequence_len)
+      : cfg_(StrobeConfig(cfg)),
+        n_smers_(cfg_.kmer_len - cfg_.syncmer_len + 1U),
+        mask_((1ULL << (static_cast<std::uint64_t>(cfg_.kmer_len) * 2U)) -
+              1ULL),
+        rc_shift_((static_cast<std::uint64_t>(cfg_.kmer_len) - 1U) * 2U),
+        smer_mask_(
+            (1ULL << (static_cast<std::uint64_t>(cfg_.syncmer_len) * 2U)) -
+            1ULL),
+        rc_smer_shift_(
+            (static_cast<std::uint64_t>(cfg_.syncmer_len) - 1U) * 2U),
+        ring_mask_(std::bit_ceil(n_smers_ + 1U) - 1U),
+        ring_(ring_mask_ + 1U) {
+    if (sequence_len >= cfg_.kmer_len) {
+      dst_.reserve(static_cast<std::size_t>(
+                       1.25 * sniff::SeedDensity(cfg) *
+                       (sequence_len - cfg_.kmer_len + 1U)) +
+                   1U);
     }
+  }
+
+  auto Push(std::uint64_t code) -> void {
+    kmer_ = ((kmer_ << 2ULL) | code) & mask_;
+    rc_kmer_ = (rc_kmer_ >> 2ULL) | ((3ULL ^ code) & 3ULL) << rc_shift_;
+    smer_ = ((smer_ << 2ULL) | code) & smer_mask_;
+    rc_smer_ =
+        (rc_smer_ >> 2ULL) | ((3ULL ^ code) & 3ULL) << rc_smer_shift_;
+    if (++n_bases_ < cfg_.syncmer_len) {
+      return;
+    }
+
+    auto const smer_hash =
+        Hash(cfg_.canonical ? std::min(smer_, rc_smer_) : smer_, smer_mask_);
+    while (head_ != tail_ &&
+           ring_[(tail_ - 1U) & ring_mask_].hash > smer_hash) {
+      --tail_;
+    }
+    ring_[tail_++ & ring_mask_] =
+        SMer{.hash = smer_hash, .position = n_bases_ - cfg_.syncmer_len};
+    if (n_bases_ < cfg_.kmer_len) {
+      return;
+    }
+
+    auto const position = n_bases_ - cfg_.kmer_len;
+    while (ring_[head_ & ring_mask_].position < position) {
+      ++head_;
+    }
+    if (!IsSyncmerOffset(ring_[head_ & ring_mask_].position - position)) {
+      return;
+    }
+
+    auto kmer = sniff::KMer{.position = position, .value = kmer_, .strand = 0};
+    if (cfg_.canonical) {
+      if (kmer_ == rc_kmer_) {  // palindromes have no defined strand
+        return;
+      }
+      kmer.strand = rc_kmer_ < kmer_;
+      kmer.value = kmer.strand ? rc_kmer_ : kmer_;
+    }
+
+    dst_.push_back(kmer);
+    if (cfg_.seeding == sniff::Seeding::kRandstrobe) {
+      hashes_.push_back(Hash(kmer.value, mask_));
+    }
+  }
+
+  auto Finish() -> std::vector<sniff::KMer> {
+    if (cfg_.seeding == sniff::Seeding::kRandstrobe) {
+      LinkStrobes();
+    }
+
+    return std::move(dst_);
+  }
+
+ private:
+  struct SMer {
+    std::uint64_t hash;
+    std::uint32_t position;
   };
 
-  auto kmer = std::uint64_t{};
-  for (std::uint32_t i = 0; i < sequence.size(); ++i) {
-    kmer = shift_kmer(kmer, sequence[i]);
-    if (i >= cfg.kmer_len + cfg.window_len - 1) {
-      window_update(i - (cfg.window_len + cfg.kmer_len - 1));
-      if (dst.empty() || dst.back() != window.front().second) {
-        dst.push_back(window.front().second);
+  auto IsSyncmerOffset(std::uint32_t offset) const -> bool {
+    if (cfg_.seeding == sniff::Seeding::kOpenSyncmer) {
+      return offset == (n_smers_ - 1U) / 2U;
+    }
+
+    return offset == 0 || offset == n_smers_ - 1U;
+  }
+
+  // Replaces each syncmer with a seed of it and its partner among the next w
+  // syncmers which do not overlap it, so that seeds cover two whole strobes;
+  // the syncmers at the end which have no such partner are dropped.
+  auto LinkStrobes() -> void {
+    auto const n = dst_.size();
+    auto i = std::size_t(0);
+    for (auto first = std::size_t(0);; ++i) {
+      while (first < n &&
+             dst_[first].position < dst_[i].position + cfg_.kmer_len) {
+        ++first;
+      }
+      if (first == n) {
+        break;
+      }
+
+      auto partner = first;
+      auto const last = std::min(n, first + cfg_.window_len);
+      for (auto j = first + 1; j < last; ++j) {
+        if ((hashes_[i] ^ hashes_[j]) < (hashes_[i] ^ hashes_[partner])) {
+          partner = j;
+        }
+      }
+
+      dst_[i].value = (hashes_[i] * kStrobeMultiplier + hashes_[partner]) &
+                      kStrobeValueMask;
+    }
+
+    dst_.resize(i);
+  }
+
+  static constexpr auto kStrobeMultiplier = 0x9e3779b97f4a7c15ULL;
+  static constexpr auto kStrobeValueMask = (1ULL << 63U) - 1ULL;
+
+  sniff::MinimizeConfig cfg_;
+  std::uint32_t n_smers_;
+  std::uint64_t mask_;
+  std::uint64_t rc_shift_;
+  std::uint64_t smer_mask_;
+  std::uint64_t rc_smer_shift_;
+
+  std::uint64_t kmer_ = 0;
+  std::uint64_t rc_kmer_ = 0;
+  std::uint64_t smer_ = 0;
+  std::uint64_t rc_smer_ = 0;
+  std::uint32_t n_bases_ = 0;
+
+  // monotone queue of the s-mers of the current k-mer
+  std::uint32_t ring_mask_;
+  std::vector<SMer> ring_;
+  std::uint32_t head_ = 0;
+  std::uint32_t tail_ = 0;
+
+  std::vector<sniff::KMer> dst_;
+  std::vector<std::uint64_t> hashes_;
+};
+
+static auto CheckSeeding(sniff::MinimizeConfig const& cfg) -> void {
+  if (cfg.seeding == sniff::Seeding::kMinimizer) {
+    return;
+  }
+  if (cfg.syncmer_len == 0 || cfg.syncmer_len >= cfg.kmer_len) {
+    throw std::invalid_argument(
+        "[sniff::Minimize] syncmer length must be in [1, k)");
+  }
+  if (cfg.seeding == sniff::Seeding::kRandstrobe && cfg.canonical) {
+    throw std::invalid_argument(
+        "[sniff::Minimize] randstrobes can not be canonical");
+  }
+  if (cfg.seeding == sniff::Seeding::kRandstrobe && cfg.syncmer_len < 2U) {
+    throw std::invalid_argument(
+        "[sniff::Minimize] randstrobes need a syncmer length of at least 2");
+  }
+}
+
+template <class Stream>
+static auto SketchSequence(sniff::MinimizeConfig const& cfg,
+                           std::string_view sequence)
+    -> std::vector<sniff::KMer> {
+  auto stream = Stream(cfg, sequence.size());
+  for (auto const base : sequence) {
+    stream.Push(kNucleotideCoder[static_cast<std::uint8_t>(base)]);
+  }
+
+  return stream.Finish();
+}
+
+template <class Stream>
+static auto SketchWords(sniff::MinimizeConfig const& cfg,
+                        std::span<std::uint64_t const> words,
+                        std::uint32_t sequence_len)
+    -> sniff::StrandMinimizers {
+  auto const n = sequence_len;
+
+  if (cfg.canonical) {
+    // canonical seeds are strand symmetric; the reverse complement
+    // sketch is the forward one read backwards with strands flipped
+    auto stream = Stream(cfg, n);
+    for (std::uint32_t i = 0; i < n; i += 32U) {
+      auto word = words[i >> 5U];
+      for (auto j = i; j < std::min(i + 32U, n); ++j, word >>= 2ULL) {
+        stream.Push(word & 3ULL);
       }
     }
-    if (i >= cfg.kmer_len - 1) {
-      window_push(Hash(kmer, mask),
-                  KMer{.position = i - (cfg.kmer_len - 1), .value = kmer});
+
+    auto dst = sniff::StrandMinimizers{.forward = stream.Finish(),
+                                      .reverse_complement = {}};
+    dst.reverse_complement.reserve(dst.forward.size());
+    for (auto it = dst.forward.crbegin(); it != dst.forward.crend(); ++it) {
+      dst.reverse_complement.push_back(
+          sniff::KMer{.position = n - cfg.kmer_len - it->position,
+                      .value = it->value,
+                      .strand = !it->strand});
+    }
+
+    return dst;
+  }
+
+  // walk the words from both ends at once; the reverse complement stream sees
+  // complemented codes from the last base down
+  auto fwd_stream = Stream(cfg, n);
+  auto rc_stream = Stream(cfg, n);
+
+  auto fwd_word = std::uint64_t(0);
+  auto rc_word = n > 0 ? words[(n - 1U) >> 5U] : 0ULL;
+  for (std::uint32_t i = 0, j = n - 1U; i < n; ++i, --j) {
+    if ((i & 31U) == 0) {
+      fwd_word = words[i >> 5U];
+    }
+    if ((j & 31U) == 31U) {
+      rc_word = words[j >> 5U];
+    }
+
+    fwd_stream.Push(fwd_word & 3ULL);
+    rc_stream.Push(3ULL ^ ((rc_word >> ((j & 31U) << 1U)) & 3ULL));
+    fwd_word >>= 2ULL;
+  }
+
+  return {.forward = fwd_stream.Finish(),
+          .reverse_complement = rc_stream.Finish()};
+}
+
+template <class Stream>
+static auto SketchForwardWords(sniff::MinimizeConfig const& cfg,
+                               std::span<std::uint64_t const> words,
+                               std::uint32_t sequence_len)
+    -> std::vector<sniff::KMer> {
+  auto stream = Stream(cfg, sequence_len);
+  for (std::uint32_t i = 0; i < sequence_len; i += 32U) {
+    auto word = words[i >> 5U];
+    for (auto j = i; j < std::min(i + 32U, sequence_len);
+         ++j, word >>= 2ULL) {
+      stream.Push(word & 3ULL);
     }
   }
 
-  if (cfg.minhash) {
-    std::sort(dst.begin(), dst.end(), CmpKMerByVal);
-    dst.resize(sequence.size() / cfg.kmer_len);
-    std::sort(dst.begin(), dst.end(), CmpKMerByPos);
+  return stream.Finish();
+}
+
+namespace sniff {
+
+auto ParseSeeding(std::string_view name) -> Seeding {
+  if (name == "minimizer") {
+    return Seeding::kMinimizer;
+  }
+  if (name == "open-syncmer") {
+    return Seeding::kOpenSyncmer;
+  }
+  if (name == "closed-syncmer") {
+    return Seeding::kClosedSyncmer;
+  }
+  if (name == "randstrobe") {
+    return Seeding::kRandstrobe;
+  }
+
+  throw std::invalid_argument("[sniff::ParseSeeding] unknown seeding: " +
+                              std::string(name));
+}
+
+auto SeedDensity(MinimizeConfig cfg) -> double {
+  switch (cfg.seeding) {
+    case Seeding::kMinimizer:
+      return 2. / (cfg.window_len + 1);
+    case Seeding::kOpenSyncmer:
+      return 1. / (cfg.kmer_len - cfg.syncmer_len + 1);
+    case Seeding::kClosedSyncmer:
+      return 2. / (cfg.kmer_len - cfg.syncmer_len + 1);
+    case Seeding::kRandstrobe:
+      return 2. / ((cfg.kmer_len + 1) / 2 - cfg.syncmer_len / 2 + 1);
   }
 
-  return dst;
+  return 1.;
+}
+
+auto Minimize(MinimizeConfig cfg, std::string_view sequence)
+    -> std::vector<KMer> {
+  CheckSeeding(cfg);
+  return cfg.seeding == Seeding::kMinimizer
+             ? SketchSequence<MinimizerStream>(cfg, sequence)
+             : SketchSequence<SyncmerStream>(cfg, sequence);
+}
+
+auto Minimize(MinimizeConfig cfg, std::span<std::uint64_t const> words,
+              std::uint32_t sequence_len) -> StrandMinimizers {
+  CheckSeeding(cfg);
+  return cfg.seeding == Seeding::kMinimizer
+             ? SketchWords<MinimizerStream>(cfg, words, sequence_len)
+             : SketchWords<SyncmerStream>(cfg, words, sequence_len);
+}
+
+auto Minimize(MinimizeConfig cfg, biosoup::NucleicAcid const& read)
+    -> StrandMinimizers {
+  return Minimize(cfg, read.deflated_data, read.inflated_len);
+}
+
+auto MinimizeForward(MinimizeConfig cfg, std::span<std::uint64_t const> words,
+                     std::uint32_t sequence_len) -> std::vector<KMer> {
+  CheckSeeding(cfg);
+  return cfg.seeding == Seeding::kMinimizer
+             ? SketchForwardWords<MinimizerStream>(cfg, words, sequence_len)
+             : SketchForwardWords<SyncmerStream>(cfg, words, sequence_len);
 }
 
 }  // namespace sniff
@@ -0,0 +1,316 @@
+#include "sniff/model.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// 3rd party
+#include "tbb/parallel_for.h"
+
+// rows scored together; every tree is walked for the whole block before
+// moving on to the next one so its nodes stay in cache
+static constexpr auto kPredictBlockSize = std::size_t(256);
+
+// values LightGBM treats as zero for zero-as-missing splits
+static constexpr auto kZeroThreshold = 1e-35;
+
+static constexpr auto kCategoricalMask = std::uint8_t(1);
+static constexpr auto kDefaultLeftMask = std::uint8_t(2);
+
+enum class MissingType : std::uint8_t { kNone = 0, kZero = 1, kNaN = 2 };
+
+static auto Trim(std::string_view str) -> std::string_view {
+  auto const first = str.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+
+  return str.substr(first, str.find_last_not_of(" \t\r") - first + 1);
+}
+
+// Splits "key=value"; returns nullopt for lines without a value.
+static auto SplitKeyValue(std::string_view line)
+    -> std::optional<std::pair<std::string_view, std::string_view>> {
+  auto const eq = line.find('=');
+  if (eq == std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  return std::pair(Trim(line.substr(0, eq)), Trim(line.substr(eq + 1)));
+}
+
+template <class T>
+static auto ParseValue(std::string_view str) -> T {
+  auto dst = T();
+  if constexpr (std::is_floating_point_v<T>) {
+    // from_chars for floating point is not available everywhere yet
+    auto const owned = std::string(str);
+    auto pos = std::size_t(0);
+    dst = std::stod(owned, &pos);
+    if (pos != owned.size()) {
+      throw std::invalid_argument("[sniff::ParseModel] invalid number: " +
+                                  owned);
+    }
+  } else {
+    auto const [ptr, ec] =
+        std::from_chars(str.data(), str.data() + str.size(), dst);
+    if (ec != std::errc() || ptr != str.data() + str.size()) {
+      throw std::invalid_argument("[sniff::ParseModel] invalid number: " +
+                                  std::string(str));
+    }
+  }
+
+  return dst;
+}
+
+template <class T>
+static auto ParseArray(std::string_view str) -> std::vector<T> {
+  auto dst = std::vector<T>();
+  while (!(str = Trim(str)).empty()) {
+    auto const len = std::min(str.find(' '), str.size());
+    dst.push_back(ParseValue<T>(str.substr(0, len)));
+    str.remove_prefix(len);
+  }
+
+  return dst;
+}
+
+static auto ParseSigmoid(std::string_view objective) -> double {
+  if (!objective.starts_with("binary")) {
+    throw std::invalid_argument(
+        "[sniff::ParseModel] unsupported objective: " + std::string(objective));
+  }
+
+  auto const pos = objective.find("sigmoid:");
+  return pos == std::string_view::npos
+             ? 1.
+             : ParseValue<double>(Trim(objective.substr(pos + 8)));
+}
+
+static auto ValidateTree(sniff::Tree const& tree, std::uint32_t n_features)
+    -> void {
+  auto const n_nodes = tree.split_feature.size();
+  if (tree.threshold.size() != n_nodes ||
+      tree.decision_type.size() != n_nodes ||
+      tree.left_child.size() != n_nodes ||
+      tree.right_child.size() != n_nodes ||
+      tree.leaf_value.size() != n_nodes + 1) {
+    throw std::invalid_argument("[sniff::ParseModel] inconsistent tree");
+  }
+
+  auto const is_valid_child = [&tree, n_nodes](std::int32_t child) -> bool {
+    return child < 0 ? static_cast<std::size_t>(~child) < tree.leaf_value.size()
+                     : static_cast<std::size_t>(child) < n_nodes;
+  };
+
+  for (std::size_t idx = 0; idx < n_nodes; ++idx) {
+    if (tree.decision_type[idx] & kCategoricalMask) {
+      throw std::invalid_argument(
+          "[sniff::ParseModel] categorical splits are not supported");
+    }
+    if (tree.split_feature[idx] >= n_features ||
+        !is_valid_child(tree.left_child[idx]) ||
+        !is_valid_child(tree.right_child[idx])) {
+      throw std::invalid_argument("[sniff::ParseModel] invalid tree node");
+    }
+  }
+}
+
+static auto NextNode(sniff::Tree const& tree, std::int32_t node, double value)
+    -> std::int32_t {
+  auto const decision_type = tree.decision_type[node];
+  auto const missing_type = static_cast<MissingType>((decision_type >> 2) & 3);
+  if (std::isnan(value) && missing_type != MissingType::kNaN) {
+    value = 0.;
+  }
+
+  auto const is_missing =
+      (missing_type == MissingType::kZero &&
+       std::fabs(value) <= kZeroThreshold) ||
+      (missing_type == MissingType::kNaN && std::isnan(value));
+  if (is_missing) {
+    return decision_type & kDefaultLeftMask ? tree.left_child[node]
+                                            : tree.right_child[node];
+  }
+
+  return value <= tree.threshold[node] ? tree.left_child[node]
+                                       : tree.right_child[node];
+}
+
+static auto PredictTree(sniff::Tree const& tree, double const* row) -> double {
+  if (tree.split_feature.empty()) {
+    return tree.leaf_value.front();
+  }
+
+  auto node = std::int32_t(0);
+  while (node >= 0) {
+    node = NextNode(tree, node, row[tree.split_feature[node]]);
+  }
+
+  return tree.leaf_value[~node];
+}
+
+namespace sniff {
+
+auto ParseModel(std::string_view text) -> Model {
+  auto dst = Model{.n_features = 0, .sigmoid = 1.};
+  auto has_objective = false;
+  auto tree = std::optional<Tree>();
+
+  auto const flush_tree = [&dst, &tree]() -> void {
+    if (tree) {
+      ValidateTree(*tree, dst.n_features);
+      dst.trees.push_back(std::move(*tree));
+      tree.reset();
+    }
+  };
+
+  while (!text.empty()) {
+    auto const eol = std::min(text.find('\n'), text.size());
+    auto const line = Trim(text.substr(0, eol));
+    text.remove_prefix(std::min(eol + 1, text.size()));
+
+    if (line == "end of trees") {
+      break;
+    }
+    if (line == "average_output") {
+      throw std::invalid_argument(
+          "[sniff::ParseModel] averaged (random forest) models are not "
+          "supported");
+    }
+
+    auto const key_value = SplitKeyValue(line);
+    if (!key_value) {
+      continue;
+    }
+
+    auto const [key, value] = *key_value;
+    if (key == "Tree") {
+      flush_tree();
+      tree.emplace();
+    } else if (!tree) {
+      if (key == "max_feature_idx") {
+        dst.n_features = ParseValue<std::uint32_t>(value) + 1;
+      } else if (key == "num_class" && value != "1") {
+        throw std::invalid_argument(
+            "[sniff::ParseModel] only binary classifiers are supported");
+      } else if (key == "objective") {
+        dst.sigmoid = ParseSigmoid(value);
+        has_objective = true;
+      }
+    } else if (key == "num_cat" && value != "0") {
+      throw std::invalid_argument(
+          "[sniff::ParseModel] categorical splits are not supported");
+    } else if (key == "split_feature") {
+      tree->split_feature = ParseArray<std::uint32_t>(value);
+    } else if (key == "threshold") {
+      tree->threshold = ParseArray<double>(value);
+    } else if (key == "decision_type") {
+      auto const decision_types = ParseArray<std::uint32_t>(value);
+      tree->decision_type.assign(decision_types.begin(), decision_types.end());
+    } else if (key == "left_child") {
+      tree->left_child = ParseArray<std::int32_t>(value);
+    } else if (key == "right_child") {
+      tree->right_child = ParseArray<std::int32_t>(value);
+    } else if (key == "leaf_value") {
+      tree->leaf_value = ParseArray<double>(value);
+    }
+  }
+  flush_tree();
+
+  if (!has_objective || dst.n_features == 0 || dst.trees.empty()) {
+    throw std::invalid_argument("[sniff::ParseModel] incomplete model");
+  }
+
+  return dst;
+}
+
+auto LoadModel(std::filesystem::path const& path) -> Model {
+  auto file = std::ifstream(path);
+  if (!file) {
+    throw std::runtime_error("[sniff::LoadModel] failed to open: " +
+                             path.string());
+  }
+
+  auto buffer = std::stringstream();
+  buffer << file.rdbuf();
+  return ParseModel(buffer.str());
+}
+
+auto Predict(Model const& model, std::span<double const> features)
+    -> std::vector<double> {
+  auto const n_rows = features.size() / model.n_features;
+  auto dst = std::vector<double>(n_rows, 0.);
+
+  tbb::parallel_for(
+      std::size_t(0), (n_rows + kPredictBlockSize - 1) / kPredictBlockSize,
+      [&model, features, n_rows, &dst](std::size_t block) -> void {
+        auto const first = block * kPredictBlockSize;
+        auto const last = std::min(first + kPredictBlockSize, n_rows);
+        for (auto const& tree : model.trees) {
+          for (auto row = first; row < last; ++row) {
+            dst[row] +=
+                PredictTree(tree, features.data() + row * model.n_features);
+          }
+        }
+
+        for (auto row = first; row < last; ++row) {
+          dst[row] = 1. / (1. + std::exp(-model.sigmoid * dst[row]));
+        }
+      });
+
+  return dst;
+}
+
+auto OverlapFeatures(OverlapNamed const& ovlp)
+    -> std::array<double, kNumOverlapFeatures> {
+  auto const query_len = static_cast<double>(ovlp.query_length);
+  auto const target_len = static_cast<double>(ovlp.target_length);
+
+  return {
+      (ovlp.query_end - ovlp.query_start) / query_len,
+      ovlp.query_start / query_len,
+      (ovlp.query_length - ovlp.query_end) / query_len,
+
+      (ovlp.target_end - ovlp.target_start) / target_len,
+      ovlp.target_start / target_len,
+      (ovlp.target_length - ovlp.target_end) / target_len,
+  };
+}
+
+auto FilterOverlaps(Model const& model, std::vector<OverlapNamed> overlaps)
+    -> std::vector<OverlapNamed> {
+  if (model.n_features != kNumOverlapFeatures) {
+    throw std::invalid_argument(
+        "[sniff::FilterOverlaps] model expects " +
+        std::to_string(model.n_features) + " features instead of " +
+        std::to_string(kNumOverlapFeatures));
+  }
+
+  auto features = std::vector<double>(overlaps.size() * kNumOverlapFeatures);
+  tbb::parallel_for(std::size_t(0), overlaps.size(),
+                    [&overlaps, &features](std::size_t idx) -> void {
+                      auto const row = OverlapFeatures(overlaps[idx]);
+                      std::copy(row.begin(), row.end(),
+                                features.begin() + idx * kNumOverlapFeatures);
+                    });
+
+  auto const probs = Predict(model, features);
+  auto dst = std::vector<OverlapNamed>();
+  for (std::size_t idx = 0; idx < overlaps.size(); ++idx) {
+    if (probs[idx] > 0.5) {
+      dst.push_back(std::move(overlaps[idx]));
+    }
+  }
+
+  return dst;
+}
+
+}  // namespace sniff
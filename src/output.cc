@@ -0,0 +1,261 @@
+#include "sniff/output.h"
+
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// 3rd party
+#include "fmt/core.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_sort.h"
+
+// overlaps formatted by a single task
+static constexpr auto kChunkSize = std::size_t(1U << 14U);
+
+// chunks formatted before they are written out; bounds the buffered output
+static constexpr auto kChunksPerWrite = std::size_t(64);
+
+static constexpr auto kBinaryMagic = std::string_view("SNIFFOVL");
+static constexpr auto kBinaryVersion = std::uint32_t(1);
+static constexpr auto kBinaryRecordSize = std::uint32_t(8 * 4);
+
+static auto AppendU32(std::uint32_t val, std::string* dst) -> void {
+  for (auto i = 0U; i < 4U; ++i, val >>= 8U) {
+    dst->push_back(static_cast<char>(val & 0xffU));
+  }
+}
+
+static auto AppendU64(std::uint64_t val, std::string* dst) -> void {
+  AppendU32(static_cast<std::uint32_t>(val), dst);
+  AppendU32(static_cast<std::uint32_t>(val >> 32U), dst);
+}
+
+static auto FormatCsv(std::span<sniff::OverlapNamed const> overlaps,
+                      std::string* dst) -> void {
+  for (auto const& ovlp : overlaps) {
+    fmt::format_to(std::back_inserter(*dst), "{},{},{},{},{},{},{},{}\n",
+                   ovlp.query_name, ovlp.query_length, ovlp.query_start,
+                   ovlp.query_end, ovlp.target_name, ovlp.target_length,
+                   ovlp.target_start, ovlp.target_end);
+  }
+}
+
+// residue matches are not known without an alignment and are written as 0;
+// the mapping quality is 255 (missing)
+static auto FormatPaf(std::span<sniff::OverlapNamed const> overlaps,
+                      std::string* dst) -> void {
+  for (auto const& ovlp : overlaps) {
+    auto const block_len = std::max(ovlp.query_end - ovlp.query_start,
+                                    ovlp.target_end - ovlp.target_start);
+    fmt::format_to(std::back_inserter(*dst),
+                   "{}\t{}\t{}\t{}\t-\t{}\t{}\t{}\t{}\t0\t{}\t255\n",
+                   ovlp.query_name, ovlp.query_length, ovlp.query_start,
+                   ovlp.query_end, ovlp.target_name, ovlp.target_length,
+                   ovlp.target_length - ovlp.target_end,
+                   ovlp.target_length - ovlp.target_start, block_len);
+  }
+}
+
+static auto NameIndex(std::span<std::string_view const> names,
+                      std::string_view name) -> std::uint32_t {
+  return std::lower_bound(names.begin(), names.end(), name) - names.begin();
+}
+
+static auto FormatBinary(std::span<sniff::OverlapNamed const> overlaps,
+                         std::span<std::string_view const> names,
+                         std::string* dst) -> void {
+  dst->reserve(dst->size() + overlaps.size() * kBinaryRecordSize);
+  for (auto const& ovlp : overlaps) {
+    AppendU32(NameIndex(names, ovlp.query_name), dst);
+    AppendU32(ovlp.query_length, dst);
+    AppendU32(ovlp.query_start, dst);
+    AppendU32(ovlp.query_end, dst);
+    AppendU32(NameIndex(names, ovlp.target_name), dst);
+    AppendU32(ovlp.target_length, dst);
+    AppendU32(ovlp.target_start, dst);
+    AppendU32(ovlp.target_end, dst);
+  }
+}
+
+static auto CreateNameTable(std::span<sniff::OverlapNamed const> overlaps)
+    -> std::vector<std::string_view> {
+  auto dst = std::vector<std::string_view>();
+  dst.reserve(overlaps.size() * 2);
+  for (auto const& ovlp : overlaps) {
+    dst.push_back(ovlp.query_name);
+    dst.push_back(ovlp.target_name);
+  }
+
+  tbb::parallel_sort(dst.begin(), dst.end());
+  dst.erase(std::unique(dst.begin(), dst.end()), dst.end());
+  return dst;
+}
+
+static auto FormatBinaryHeader(std::span<std::string_view const> names,
+                               std::size_t n_records) -> std::string {
+  auto dst = std::string(kBinaryMagic);
+  AppendU32(kBinaryVersion, &dst);
+  AppendU32(kBinaryRecordSize, &dst);
+  AppendU64(names.size(), &dst);
+  AppendU64(n_records, &dst);
+  for (auto const name : names) {
+    AppendU32(name.size(), &dst);
+    dst.append(name);
+  }
+
+  return dst;
+}
+
+// Compresses src into a complete gzip member; concatenated members form a
+// valid gzip stream.
+static auto CompressChunk(std::string const& src) -> std::string {
+  auto stream = z_stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("[sniff::CompressChunk] failed to init deflate");
+  }
+
+  auto dst = std::string(deflateBound(&stream, src.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src.data()));
+  stream.avail_in = src.size();
+  stream.next_out = reinterpret_cast<Bytef*>(dst.data());
+  stream.avail_out = dst.size();
+
+  auto const status = deflate(&stream, Z_FINISH);
+  dst.resize(stream.total_out);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    throw std::runtime_error("[sniff::CompressChunk] failed to deflate");
+  }
+
+  return dst;
+}
+
+// Writes all buffers in order, resuming after partial writes.
+static auto WriteBuffers(int fd, std::span<std::string const> buffers)
+    -> void {
+  auto iovs = std::vector<iovec>();
+  for (auto const& buffer : buffers) {
+    if (!buffer.empty()) {
+      iovs.push_back(iovec{.iov_base = const_cast<char*>(buffer.data()),
+                           .iov_len = buffer.size()});
+    }
+  }
+
+  for (std::size_t first = 0; first < iovs.size();) {
+    auto const n_iovs = std::min<std::size_t>(iovs.size() - first, IOV_MAX);
+    auto written = writev(fd, iovs.data() + first, n_iovs);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(),
+                              "[sniff::WriteBuffers] writev failed");
+    }
+
+    for (; first < iovs.size() &&
+           static_cast<std::size_t>(written) >= iovs[first].iov_len;
+         ++first) {
+      written -= iovs[first].iov_len;
+    }
+    if (first < iovs.size()) {
+      iovs[first].iov_base = static_cast<char*>(iovs[first].iov_base) + written;
+      iovs[first].iov_len -= written;
+    }
+  }
+}
+
+namespace sniff {
+
+auto ParseOutputFormat(std::string_view name) -> OutputFormat {
+  if (name == "csv") {
+    return OutputFormat::kCsv;
+  }
+  if (name == "paf") {
+    return OutputFormat::kPaf;
+  }
+  if (name == "binary") {
+    return OutputFormat::kBinary;
+  }
+
+  throw std::invalid_argument("[sniff::ParseOutputFormat] unknown format: " +
+                              std::string(name));
+}
+
+auto WriteOverlaps(OutputConfig cfg, std::span<OverlapNamed const> overlaps,
+                   int fd) -> void {
+  auto const names = cfg.format == OutputFormat::kBinary
+                         ? CreateNameTable(overlaps)
+                         : std::vector<std::string_view>();
+
+  auto const format_chunk = [&cfg, &names](
+                                std::span<OverlapNamed const> chunk,
+                                std::string* dst) -> void {
+    switch (cfg.format) {
+      case OutputFormat::kCsv:
+        FormatCsv(chunk, dst);
+        break;
+      case OutputFormat::kPaf:
+        FormatPaf(chunk, dst);
+        break;
+      case OutputFormat::kBinary:
+        FormatBinary(chunk, names, dst);
+        break;
+    }
+  };
+
+  auto header = std::string();
+  if (cfg.format == OutputFormat::kCsv) {
+    header =
+        "query_name,query_length,query_start,"
+        "query_end,target_name,target_length,target_start,target_end\n";
+  } else if (cfg.format == OutputFormat::kBinary) {
+    header = FormatBinaryHeader(names, overlaps.size());
+  }
+
+  // the header is emitted as a chunk of its own in front of the first group
+  auto const n_chunks = (overlaps.size() + kChunkSize - 1) / kChunkSize;
+  auto buffers = std::vector<std::string>();
+  for (std::size_t first = 0; first == 0 || first < n_chunks;
+       first += kChunksPerWrite) {
+    auto const last = std::min(first + kChunksPerWrite, n_chunks);
+    auto const n_header = first == 0 ? 1U : 0U;
+
+    buffers.assign(last - first + n_header, std::string());
+    if (n_header) {
+      buffers.front() = std::move(header);
+    }
+
+    tbb::parallel_for(
+        first, last,
+        [&cfg, overlaps, &buffers, &format_chunk, first,
+         n_header](std::size_t chunk) -> void {
+          auto& buffer = buffers[chunk - first + n_header];
+          format_chunk(overlaps.subspan(chunk * kChunkSize,
+                                        std::min(kChunkSize,
+                                                 overlaps.size() -
+                                                     chunk * kChunkSize)),
+                       &buffer);
+          if (cfg.compress) {
+            buffer = CompressChunk(buffer);
+          }
+        });
+
+    if (n_header && cfg.compress) {
+      buffers.front() = CompressChunk(buffers.front());
+    }
+
+    WriteBuffers(fd, buffers);
+  }
+}
+
+}  // namespace sniff
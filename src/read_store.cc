@@ -0,0 +1,108 @@
+#include "sniff/read_store.h"
+
+#include <stdexcept>
+
+// 3rd party
+#include "biosoup/nucleic_acid.hpp"
+
+namespace sniff {
+
+auto ReadStore::Append(biosoup::NucleicAcid const& read) -> void {
+  lengths_.push_back(read.inflated_len);
+
+  names_.append(read.name);
+  name_offsets_.push_back(names_.size());
+
+  sequences_.insert(sequences_.end(), read.deflated_data.cbegin(),
+                    read.deflated_data.cend());
+  sequence_offsets_.push_back(sequences_.size());
+}
+
+auto ReadStore::Append(std::string_view name, std::string_view data)
+    -> void {
+  lengths_.push_back(data.size());
+
+  names_.append(name);
+  name_offsets_.push_back(names_.size());
+
+  auto word = std::uint64_t(0);
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    auto const code = static_cast<std::uint64_t>(
+        biosoup::kNucleotideCoder[static_cast<std::uint8_t>(data[i])]);
+    if (code == 255) {
+      throw std::invalid_argument(
+          "[sniff::ReadStore::Append] invalid nucleotide in read: " +
+          std::string(name));
+    }
+
+    word |= code << ((i & 31U) << 1U);
+    if ((i & 31U) == 31U) {
+      sequences_.push_back(word);
+      word = 0;
+    }
+  }
+  if (data.size() & 31U) {
+    sequences_.push_back(word);
+  }
+  sequence_offsets_.push_back(sequences_.size());
+}
+
+auto ReadStore::Append(ReadStore const& reads) -> void {
+  lengths_.insert(lengths_.end(), reads.lengths_.cbegin(),
+                  reads.lengths_.cend());
+
+  auto const names_first = names_.size();
+  names_.append(reads.names_);
+  for (std::size_t idx = 1; idx < reads.name_offsets_.size(); ++idx) {
+    name_offsets_.push_back(names_first + reads.name_offsets_[idx]);
+  }
+
+  auto const sequences_first = sequences_.size();
+  sequences_.insert(sequences_.end(), reads.sequences_.cbegin(),
+                    reads.sequences_.cend());
+  for (std::size_t idx = 1; idx < reads.sequence_offsets_.size(); ++idx) {
+    sequence_offsets_.push_back(sequences_first + reads.sequence_offsets_[idx]);
+  }
+}
+
+auto ReadStore::Permute(std::span<std::uint32_t const> order) const
+    -> ReadStore {
+  auto dst = ReadStore(first_id_);
+  dst.lengths_.reserve(order.size());
+  dst.name_offsets_.reserve(order.size() + 1);
+  dst.sequence_offsets_.reserve(order.size() + 1);
+  dst.names_.reserve(names_.size());
+  dst.sequences_.reserve(sequences_.size());
+
+  for (auto const read_id : order) {
+    dst.lengths_.push_back(Length(read_id));
+
+    dst.names_.append(Name(read_id));
+    dst.name_offsets_.push_back(dst.names_.size());
+
+    auto const sequence = Sequence(read_id);
+    dst.sequences_.insert(dst.sequences_.end(), sequence.begin(),
+                          sequence.end());
+    dst.sequence_offsets_.push_back(dst.sequences_.size());
+  }
+
+  return dst;
+}
+
+auto ReadStore::ReleaseSequences() -> void {
+  sequences_ = std::vector<std::uint64_t>();
+  sequence_offsets_ = std::vector<std::uint64_t>(lengths_.size() + 1, 0);
+}
+
+auto ReadStore::InflateData(std::uint32_t read_id) const -> std::string {
+  auto const words = Sequence(read_id);
+  auto dst = std::string(Length(read_id), '\0');
+  for (std::size_t i = 0; i < dst.size(); ++i) {
+    dst[i] = biosoup::kNucleotideDecoder[(words[i >> 5U] >> ((i & 31U) << 1U)) &
+                                         3U];
+  }
+
+  return dst;
+}
+
+}  // namespace sniff
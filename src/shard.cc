@@ -0,0 +1,245 @@
+#include "sniff/shard.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+// sniff
+#include "sniff/best_pairs.h"
+
+static constexpr auto kShardMagic = std::string_view("SNIFFSHD");
+static constexpr auto kShardVersion = std::uint32_t(1);
+
+using NameTable = std::vector<std::pair<std::uint32_t, std::string>>;
+
+static auto AppendU32(std::uint32_t val, std::string* dst) -> void {
+  for (auto i = 0U; i < 4U; ++i, val >>= 8U) {
+    dst->push_back(static_cast<char>(val & 0xffU));
+  }
+}
+
+static auto AppendU64(std::uint64_t val, std::string* dst) -> void {
+  AppendU32(static_cast<std::uint32_t>(val), dst);
+  AppendU32(static_cast<std::uint32_t>(val >> 32U), dst);
+}
+
+// Sequential little endian reads from a shard file; throws if it ends early.
+class ShardReader {
+ public:
+  ShardReader(std::string data, std::string path)
+      : data_(std::move(data)), path_(std::move(path)) {}
+
+  auto IsDone() const -> bool { return offset_ == data_.size(); }
+
+  auto Bytes(std::size_t len) -> std::string_view {
+    if (data_.size() - offset_ < len) {
+      throw std::runtime_error("[sniff::ReadShard] truncated shard: " + path_);
+    }
+
+    offset_ += len;
+    return std::string_view(data_).substr(offset_ - len, len);
+  }
+
+  auto U32() -> std::uint32_t {
+    auto const bytes = Bytes(4);
+    auto dst = std::uint32_t(0);
+    for (auto i = 4U; i-- > 0;) {
+      dst = dst << 8U | static_cast<std::uint8_t>(bytes[i]);
+    }
+
+    return dst;
+  }
+
+  auto U64() -> std::uint64_t {
+    auto const lo = U32();
+    return static_cast<std::uint64_t>(U32()) << 32U | lo;
+  }
+
+ private:
+  std::string data_;
+  std::string path_;
+  std::size_t offset_ = 0;
+};
+
+namespace sniff {
+
+auto WriteShard(ShardCandidates const& shard, int fd) -> void {
+  auto dst = std::string(kShardMagic);
+  AppendU32(kShardVersion, &dst);
+  AppendU32(shard.shard_index, &dst);
+  AppendU32(shard.n_shards, &dst);
+  AppendU64(shard.n_reads, &dst);
+  AppendU64(shard.names.size(), &dst);
+  AppendU64(shard.overlaps.size(), &dst);
+  for (auto const& [read_id, name] : shard.names) {
+    AppendU32(read_id, &dst);
+    AppendU32(name.size(), &dst);
+    dst.append(name);
+  }
+
+  for (auto const& ovlp : shard.overlaps) {
+    for (auto const val :
+         {ovlp.query_id, ovlp.query_length, ovlp.query_start, ovlp.query_end,
+          ovlp.target_id, ovlp.target_length, ovlp.target_start,
+          ovlp.target_end}) {
+      AppendU32(val, &dst);
+    }
+    AppendU64(std::bit_cast<std::uint64_t>(ovlp.score), &dst);
+  }
+
+  for (std::size_t offset = 0; offset < dst.size();) {
+    auto const written = write(fd, dst.data() + offset, dst.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(),
+                              "[sniff::WriteShard] write failed");
+    }
+    offset += written;
+  }
+}
+
+auto ReadShard(std::filesystem::path const& path) -> ShardCandidates {
+  auto file = std::ifstream(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("[sniff::ReadShard] failed to open: " +
+                             path.string());
+  }
+
+  auto reader = ShardReader(std::string(std::istreambuf_iterator<char>(file),
+                                        std::istreambuf_iterator<char>()),
+                            path.string());
+  if (reader.Bytes(kShardMagic.size()) != kShardMagic ||
+      reader.U32() != kShardVersion) {
+    throw std::runtime_error("[sniff::ReadShard] not a shard file: " +
+                             path.string());
+  }
+
+  auto dst = ShardCandidates();
+  dst.shard_index = reader.U32();
+  dst.n_shards = reader.U32();
+  dst.n_reads = reader.U64();
+
+  auto const n_names = reader.U64();
+  auto const n_overlaps = reader.U64();
+  for (std::uint64_t i = 0; i < n_names; ++i) {
+    auto const read_id = reader.U32();
+    dst.names.emplace_back(read_id, std::string(reader.Bytes(reader.U32())));
+  }
+
+  for (std::uint64_t i = 0; i < n_overlaps; ++i) {
+    auto& ovlp = dst.overlaps.emplace_back();
+    for (auto* val :
+         {&ovlp.query_id, &ovlp.query_length, &ovlp.query_start,
+          &ovlp.query_end, &ovlp.target_id, &ovlp.target_length,
+          &ovlp.target_start, &ovlp.target_end}) {
+      *val = reader.U32();
+    }
+    ovlp.score = std::bit_cast<double>(reader.U64());
+  }
+
+  if (!reader.IsDone()) {
+    throw std::runtime_error("[sniff::ReadShard] trailing data in shard: " +
+                             path.string());
+  }
+
+  return dst;
+}
+
+auto MergeShards(std::vector<ShardCandidates> shards) -> NamedOverlaps {
+  if (shards.empty()) {
+    throw std::invalid_argument("[sniff::MergeShards] no shards to merge");
+  }
+
+  auto const n_shards = shards.front().n_shards;
+  auto const n_reads = shards.front().n_reads;
+  auto is_seen = std::vector<bool>(n_shards, false);
+  for (auto const& shard : shards) {
+    if (shard.n_shards != n_shards || shard.n_reads != n_reads) {
+      throw std::invalid_argument(
+          "[sniff::MergeShards] shards belong to different runs");
+    }
+    if (shard.shard_index >= n_shards || is_seen[shard.shard_index]) {
+      throw std::invalid_argument("[sniff::MergeShards] duplicate shard " +
+                                  std::to_string(shard.shard_index));
+    }
+    is_seen[shard.shard_index] = true;
+  }
+  if (shards.size() != n_shards) {
+    throw std::invalid_argument("[sniff::MergeShards] expected " +
+                                std::to_string(n_shards) + " shards, got " +
+                                std::to_string(shards.size()));
+  }
+
+  auto ovlps = std::vector<Overlap>();
+  auto names = NameTable();
+  for (auto& shard : shards) {
+    std::move(shard.overlaps.begin(), shard.overlaps.end(),
+              std::back_inserter(ovlps));
+    std::move(shard.names.begin(), shard.names.end(),
+              std::back_inserter(names));
+  }
+
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+
+  // the overlap holding each read's best partner within a shard is one of its
+  // candidates, so best partners end up like those of a single process run
+  auto best_pairs = BestPairs(n_reads);
+  for (auto const& ovlp : ovlps) {
+    if (ovlp.query_id >= n_reads || ovlp.target_id >= n_reads) {
+      throw std::invalid_argument(
+          "[sniff::MergeShards] read id out of range");
+    }
+    best_pairs.Update(ovlp);
+  }
+
+  std::erase_if(ovlps, [&best_pairs](Overlap const& ovlp) -> bool {
+    return !best_pairs.IsBest(ovlp);
+  });
+  std::sort(ovlps.begin(), ovlps.end());
+  ovlps.erase(std::unique(ovlps.begin(), ovlps.end()), ovlps.end());
+
+  auto const storage = std::make_shared<NameTable const>(std::move(names));
+  auto const get_name = [&names = *storage](std::uint32_t read_id)
+      -> std::string_view {
+    auto const it = std::lower_bound(
+        names.begin(), names.end(), read_id,
+        [](auto const& entry, std::uint32_t id) { return entry.first < id; });
+    if (it == names.end() || it->first != read_id) {
+      throw std::invalid_argument("[sniff::MergeShards] missing name of read " +
+                                  std::to_string(read_id));
+    }
+
+    return it->second;
+  };
+
+  auto dst = NamedOverlaps{.storage = storage};
+  dst.overlaps.reserve(ovlps.size());
+  for (auto const& ovlp : ovlps) {
+    dst.overlaps.push_back(OverlapNamed{
+        .query_name = get_name(ovlp.query_id),
+        .query_length = ovlp.query_length,
+        .query_start = ovlp.query_start,
+        .query_end = ovlp.query_end,
+
+        .target_name = get_name(ovlp.target_id),
+        .target_length = ovlp.target_length,
+        .target_start = ovlp.target_start,
+        .target_end = ovlp.target_end,
+    });
+  }
+
+  return dst;
+}
+
+}  // namespace sniff
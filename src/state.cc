@@ -0,0 +1,267 @@
+#include "sniff/state.h"
+
+#include <bit>
+#include <fstream>
+#include <stdexcept>
+
+static constexpr auto kStateMagic = std::string_view("SNIFFRUN");
+static constexpr auto kStateVersion = std::uint32_t(5);
+
+// buffered bytes before they are handed to the file
+static constexpr auto kWriteBufferSize = std::size_t(1U << 20U);
+
+static auto AppendU16(std::uint16_t val, std::string* dst) -> void {
+  dst->push_back(static_cast<char>(val & 0xffU));
+  dst->push_back(static_cast<char>(val >> 8U));
+}
+
+static auto AppendU32(std::uint32_t val, std::string* dst) -> void {
+  for (auto i = 0U; i < 4U; ++i, val >>= 8U) {
+    dst->push_back(static_cast<char>(val & 0xffU));
+  }
+}
+
+static auto AppendU64(std::uint64_t val, std::string* dst) -> void {
+  AppendU32(static_cast<std::uint32_t>(val), dst);
+  AppendU32(static_cast<std::uint32_t>(val >> 32U), dst);
+}
+
+// Little endian reads from a state file; throws if it ends early.
+class StateReader {
+ public:
+  explicit StateReader(std::filesystem::path const& path)
+      : file_(path, std::ios::binary), path_(path.string()) {}
+
+  auto IsOpen() const -> bool { return file_.is_open(); }
+
+  auto IsDone() -> bool {
+    return file_.peek() == std::ifstream::traits_type::eof();
+  }
+
+  auto Bytes(std::size_t len) -> std::string {
+    auto dst = std::string(len, '\0');
+    if (!file_.read(dst.data(), len)) {
+      throw std::runtime_error("[sniff::LoadRunState] truncated state: " +
+                               path_);
+    }
+
+    return dst;
+  }
+
+  auto U16s(std::size_t n) -> std::vector<std::uint16_t> {
+    auto const bytes = Bytes(n * 2);
+    auto dst = std::vector<std::uint16_t>(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      dst[i] = static_cast<std::uint8_t>(bytes[2 * i]) |
+               static_cast<std::uint8_t>(bytes[2 * i + 1]) << 8U;
+    }
+
+    return dst;
+  }
+
+  auto U32() -> std::uint32_t {
+    auto const bytes = Bytes(4);
+    auto dst = std::uint32_t(0);
+    for (auto i = 4U; i-- > 0;) {
+      dst = dst << 8U | static_cast<std::uint8_t>(bytes[i]);
+    }
+
+    return dst;
+  }
+
+  auto U64() -> std::uint64_t {
+    auto const lo = U32();
+    return static_cast<std::uint64_t>(U32()) << 32U | lo;
+  }
+
+ private:
+  std::ifstream file_;
+  std::string path_;
+};
+
+namespace sniff {
+
+auto RunState::Append(std::string_view name, std::uint32_t length,
+                      std::span<KMer const> minimizers) -> void {
+  lengths_.push_back(length);
+  names_.append(name);
+  name_offsets_.push_back(names_.size());
+  minimizers_.insert(minimizers_.end(), minimizers.begin(), minimizers.end());
+  minimizer_offsets_.push_back(minimizers_.size());
+}
+
+auto LoadRunState(std::filesystem::path const& path)
+    -> std::optional<RunState> {
+  if (!std::filesystem::exists(path)) {
+    return std::nullopt;
+  }
+
+  auto reader = StateReader(path);
+  if (!reader.IsOpen()) {
+    throw std::runtime_error("[sniff::LoadRunState] failed to open: " +
+                             path.string());
+  }
+  if (reader.Bytes(kStateMagic.size()) != kStateMagic ||
+      reader.U32() != kStateVersion) {
+    throw std::runtime_error("[sniff::LoadRunState] not a state file: " +
+                             path.string());
+  }
+
+  auto const kmer_len = reader.U32();
+  auto const window_len = reader.U32();
+  auto const canonical = reader.U32() != 0;
+  auto const seeding = reader.U32();
+  if (seeding > static_cast<std::uint32_t>(Seeding::kRandstrobe)) {
+    throw std::runtime_error("[sniff::LoadRunState] unknown seeding: " +
+                             path.string());
+  }
+  auto const syncmer_len = reader.U32();
+  auto dst = RunState(kmer_len, window_len, canonical,
+                      static_cast<Seeding>(seeding), syncmer_len,
+                      std::bit_cast<double>(reader.U64()));
+
+  auto const n_reads = reader.U64();
+  auto const n_candidates = reader.U64();
+  auto minimizers = std::vector<KMer>();
+  for (std::uint64_t i = 0; i < n_reads; ++i) {
+    auto const length = reader.U32();
+    auto const name = reader.Bytes(reader.U32());
+
+    minimizers.resize(reader.U32());
+    for (auto& kmer : minimizers) {
+      kmer.position = reader.U32();
+      auto const value = reader.U64();
+      kmer.value = value & ((std::uint64_t(1) << 63U) - 1);
+      kmer.strand = value >> 63U;
+    }
+    dst.Append(name, length, minimizers);
+  }
+
+  auto candidates = std::vector<Overlap>(n_candidates);
+  for (auto& ovlp : candidates) {
+    for (auto* val :
+         {&ovlp.query_id, &ovlp.query_length, &ovlp.query_start,
+          &ovlp.query_end, &ovlp.target_id, &ovlp.target_length,
+          &ovlp.target_start, &ovlp.target_end}) {
+      *val = reader.U32();
+    }
+    ovlp.score = std::bit_cast<double>(reader.U64());
+    if (ovlp.query_id >= n_reads || ovlp.target_id >= n_reads) {
+      throw std::runtime_error("[sniff::LoadRunState] read id out of range: " +
+                               path.string());
+    }
+  }
+  dst.SetCandidates(std::move(candidates));
+
+  if (auto const block_bits = reader.U32(); block_bits != 0) {
+    auto const threshold = reader.U32();
+    auto const n_kmers = reader.U64();
+    auto const sample_level = reader.U32();
+    auto const cells = reader.U16s(reader.U64());
+    auto sample = std::vector<std::uint64_t>(reader.U64());
+    for (auto& value : sample) {
+      value = reader.U64();
+    }
+
+    auto const counts = FrequentKMerCounts{.block_bits = block_bits,
+                                           .threshold = threshold,
+                                           .n_kmers = n_kmers,
+                                           .cells = cells,
+                                           .sample_level = sample_level,
+                                           .sample = sample};
+    if (!FrequentKMers::IsValid(counts)) {
+      throw std::runtime_error("[sniff::LoadRunState] invalid k-mer counts: " +
+                               path.string());
+    }
+    dst.SetFrequent(std::make_unique<FrequentKMers>(counts));
+  }
+
+  if (!reader.IsDone()) {
+    throw std::runtime_error("[sniff::LoadRunState] trailing data in state: " +
+                             path.string());
+  }
+
+  return dst;
+}
+
+auto SaveRunState(RunState const& state, std::filesystem::path const& path)
+    -> void {
+  auto const tmp_path = std::filesystem::path(path.string() + ".tmp");
+  auto file = std::ofstream(tmp_path, std::ios::binary | std::ios::trunc);
+
+  auto buffer = std::string();
+  auto const flush = [&file, &buffer](bool is_forced) -> void {
+    if (is_forced || buffer.size() >= kWriteBufferSize) {
+      file.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  };
+
+  buffer.append(kStateMagic);
+  AppendU32(kStateVersion, &buffer);
+  AppendU32(state.KMerLength(), &buffer);
+  AppendU32(state.WindowLength(), &buffer);
+  AppendU32(state.IsCanonical() ? 1 : 0, &buffer);
+  AppendU32(static_cast<std::uint32_t>(state.SeedingScheme()), &buffer);
+  AppendU32(state.SyncmerLength(), &buffer);
+  AppendU64(std::bit_cast<std::uint64_t>(state.FilterFrequency()), &buffer);
+  AppendU64(state.size(), &buffer);
+  AppendU64(state.Candidates().size(), &buffer);
+
+  for (std::uint32_t read_id = 0; read_id < state.size(); ++read_id) {
+    auto const name = state.Name(read_id);
+    auto const minimizers = state.Minimizers(read_id);
+    AppendU32(state.Lengths()[read_id], &buffer);
+    AppendU32(name.size(), &buffer);
+    buffer.append(name);
+    AppendU32(minimizers.size(), &buffer);
+    for (auto const& kmer : minimizers) {
+      AppendU32(kmer.position, &buffer);
+      AppendU64(kmer.value | static_cast<std::uint64_t>(kmer.strand) << 63U,
+                &buffer);
+    }
+    flush(false);
+  }
+
+  for (auto const& ovlp : state.Candidates()) {
+    for (auto const val :
+         {ovlp.query_id, ovlp.query_length, ovlp.query_start, ovlp.query_end,
+          ovlp.target_id, ovlp.target_length, ovlp.target_start,
+          ovlp.target_end}) {
+      AppendU32(val, &buffer);
+    }
+    AppendU64(std::bit_cast<std::uint64_t>(ovlp.score), &buffer);
+    flush(false);
+  }
+
+  if (auto const* frequent = state.Frequent()) {
+    AppendU32(frequent->BlockBits(), &buffer);
+    AppendU32(frequent->Threshold(), &buffer);
+    AppendU64(frequent->NumKMers(), &buffer);
+    AppendU32(frequent->SampleLevel(), &buffer);
+    auto const cells = frequent->Cells();
+    AppendU64(cells.size(), &buffer);
+    for (auto const cell : cells) {
+      AppendU16(cell, &buffer);
+      flush(false);
+    }
+    AppendU64(frequent->Sample().size(), &buffer);
+    for (auto const value : frequent->Sample()) {
+      AppendU64(value, &buffer);
+      flush(false);
+    }
+  } else {
+    AppendU32(0, &buffer);
+  }
+  flush(true);
+
+  file.close();
+  if (!file) {
+    std::filesystem::remove(tmp_path);
+    throw std::runtime_error("[sniff::SaveRunState] failed to write: " +
+                             tmp_path.string());
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+
+}  // namespace sniff
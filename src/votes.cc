@@ -0,0 +1,117 @@
+#include "sniff/votes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static constexpr auto kEmpty = std::numeric_limits<std::uint32_t>::max();
+static constexpr auto kSelected = std::uint32_t(1) << 31U;
+
+// a query rarely shares seeds with more than a few dozen targets
+static constexpr auto kMinSlotBits = std::uint32_t(6);
+
+static auto SlotOf(std::uint32_t target_id, std::uint32_t slot_bits)
+    -> std::size_t {
+  return static_cast<std::uint32_t>(target_id * 0x9e3779b1U) >>
+         (32U - slot_bits);
+}
+
+namespace sniff {
+
+TargetVotes::TargetVotes()
+    : slot_bits_(kMinSlotBits),
+      slots_(std::size_t(1) << kMinSlotBits,
+             Slot{.target_id = kEmpty, .votes = 0}) {}
+
+auto TargetVotes::Clear() -> void {
+  for (auto const idx : used_) {
+    slots_[idx] = Slot{.target_id = kEmpty, .votes = 0};
+  }
+  used_.clear();
+}
+
+auto TargetVotes::Find(std::uint32_t target_id) const -> std::size_t {
+  auto const mask = slots_.size() - 1;
+  auto idx = SlotOf(target_id, slot_bits_);
+  while (slots_[idx].target_id != target_id &&
+         slots_[idx].target_id != kEmpty) {
+    idx = (idx + 1) & mask;
+  }
+
+  return idx;
+}
+
+auto TargetVotes::Add(std::uint32_t target_id) -> void {
+  auto idx = Find(target_id);
+  if (slots_[idx].target_id == kEmpty) {
+    // at most half of the slots are in use, which keeps probes short
+    if (2 * (used_.size() + 1) > slots_.size()) {
+      Grow();
+      idx = Find(target_id);
+    }
+    slots_[idx].target_id = target_id;
+    used_.push_back(idx);
+  }
+  ++slots_[idx].votes;
+}
+
+auto TargetVotes::Grow() -> void {
+  ranked_.clear();
+  for (auto const idx : used_) {
+    ranked_.push_back(slots_[idx]);
+  }
+
+  ++slot_bits_;
+  slots_.assign(std::size_t(1) << slot_bits_,
+                Slot{.target_id = kEmpty, .votes = 0});
+  used_.clear();
+  for (auto const& slot : ranked_) {
+    auto const idx = Find(slot.target_id);
+    slots_[idx] = slot;
+    used_.push_back(idx);
+  }
+}
+
+auto TargetVotes::Votes(std::uint32_t target_id) const -> std::uint32_t {
+  return slots_[Find(target_id)].votes & ~kSelected;
+}
+
+auto TargetVotes::Select(std::uint32_t min_votes, double min_share,
+                         std::uint32_t max_targets) -> std::size_t {
+  auto best = std::uint32_t(0);
+  for (auto const idx : used_) {
+    best = std::max(best, slots_[idx].votes);
+  }
+
+  auto const threshold = std::max(
+      min_votes, static_cast<std::uint32_t>(std::ceil(min_share * best)));
+  ranked_.clear();
+  for (auto const idx : used_) {
+    if (slots_[idx].votes >= threshold) {
+      ranked_.push_back(slots_[idx]);
+    }
+  }
+
+  if (ranked_.size() > max_targets) {
+    std::nth_element(ranked_.begin(), ranked_.begin() + max_targets,
+                     ranked_.end(),
+                     [](Slot const& lhs, Slot const& rhs) -> bool {
+                       return lhs.votes > rhs.votes ||
+                              (lhs.votes == rhs.votes &&
+                               lhs.target_id < rhs.target_id);
+                     });
+    ranked_.resize(max_targets);
+  }
+
+  for (auto const& slot : ranked_) {
+    slots_[Find(slot.target_id)].votes |= kSelected;
+  }
+
+  return ranked_.size();
+}
+
+auto TargetVotes::IsSelected(std::uint32_t target_id) const -> bool {
+  return (slots_[Find(target_id)].votes & kSelected) != 0;
+}
+
+}  // namespace sniff
@@ -2,12 +2,27 @@ find_package(Catch2 3.3 REQUIRED)
 
 add_executable(
   sniff_test
+  ${CMAKE_CURRENT_LIST_DIR}/src/algo.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/best_pairs.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/cache.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/frequency.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/gzip.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/index.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/io.cc
   ${CMAKE_CURRENT_LIST_DIR}/src/kmer.cc
   ${CMAKE_CURRENT_LIST_DIR}/src/map.cc
   ${CMAKE_CURRENT_LIST_DIR}/src/match.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/metrics.cc
   ${CMAKE_CURRENT_LIST_DIR}/src/minimize.cc
-  ${CMAKE_CURRENT_LIST_DIR}/src/overlap.cc)
-target_link_libraries(sniff_test PRIVATE sniff_lib Catch2::Catch2WithMain)
+  ${CMAKE_CURRENT_LIST_DIR}/src/model.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/output.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/overlap.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/read_store.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/shard.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/state.cc
+  ${CMAKE_CURRENT_LIST_DIR}/src/votes.cc)
+target_link_libraries(sniff_test PRIVATE sniff_lib Catch2::Catch2WithMain
+                                         ZLIB::ZLIB)
 
 include(CTest)
 include(Catch)
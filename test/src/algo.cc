@@ -0,0 +1,103 @@
+#include "sniff/algo.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+static auto ReverseComplement(std::string const& data) -> std::string {
+  auto dst = std::string(data.rbegin(), data.rend());
+  for (auto& base : dst) {
+    base = base == 'A' ? 'T' : base == 'C' ? 'G' : base == 'G' ? 'C' : 'A';
+  }
+
+  return dst;
+}
+
+// Read names of the pairs, the smaller name first, in sorted order.
+static auto PairNames(sniff::NamedOverlaps const& pairs)
+    -> std::vector<std::pair<std::string, std::string>> {
+  auto dst = std::vector<std::pair<std::string, std::string>>();
+  for (auto const& ovlp : pairs.overlaps) {
+    dst.emplace_back(std::minmax(std::string(ovlp.query_name),
+                                 std::string(ovlp.target_name)));
+  }
+  std::sort(dst.begin(), dst.end());
+
+  return dst;
+}
+
+TEST_CASE("algo-incremental", "[algo]") {
+  // reads and reverse complements with 2% substitutions; the two halves of
+  // the input split some of the pairs between the runs
+  auto rng = std::mt19937(42);
+  auto reads = std::vector<std::pair<std::string, std::string>>();
+  for (auto i = 0; i < 12; ++i) {
+    auto data = std::string(
+        std::uniform_int_distribution<std::size_t>(2'000, 3'000)(rng), 'A');
+    for (auto& base : data) {
+      base = "ACGT"[rng() & 3U];
+    }
+    reads.emplace_back("fwd" + std::to_string(i), data);
+
+    for (auto& base : data) {
+      if (rng() % 50 == 0) {
+        base = "ACGT"[rng() & 3U];
+      }
+    }
+    reads.emplace_back("rc" + std::to_string(i), ReverseComplement(data));
+  }
+  std::shuffle(reads.begin(), reads.end(), rng);
+
+  auto const cfg = sniff::Config{.alpha_p = 0.10,
+                                 .beta_p = 0.90,
+                                 .filter_freq = 0.0002,
+                                 .kmer_len = 15,
+                                 .window_len = 5,
+                                 .canonical = false};
+
+  auto const make_store = [&reads](std::size_t first,
+                                   std::size_t last) -> sniff::ReadStore {
+    auto dst = sniff::ReadStore();
+    for (auto i = first; i < last; ++i) {
+      dst.Append(reads[i].first, reads[i].second);
+    }
+    return dst;
+  };
+
+  auto const one_shot =
+      PairNames(sniff::FindReverseComplementPairs(cfg, make_store(0, 24)));
+  CHECK(one_shot.size() == 12);
+
+  auto const path = std::filesystem::temp_directory_path() / "sniff-algo.bin";
+  std::filesystem::remove(path);
+  {
+    auto state = std::make_shared<sniff::RunState>(15, 5, false);
+    sniff::FindReverseComplementPairs(cfg, make_store(0, 13), state);
+    sniff::SaveRunState(*state, path);
+  }
+
+  auto state = sniff::LoadRunState(path);
+  REQUIRE(state.has_value());
+  auto const shared_state =
+      std::make_shared<sniff::RunState>(std::move(*state));
+  auto other_cfg = cfg;
+  other_cfg.filter_freq = 0.001;
+  CHECK_THROWS(sniff::FindReverseComplementPairs(other_cfg, make_store(13, 24),
+                                                 shared_state));
+  CHECK(PairNames(sniff::FindReverseComplementPairs(
+            cfg, make_store(13, 24), shared_state)) == one_shot);
+  std::filesystem::remove(path);
+
+  // a budget that leaves no room windows the new reads one by one
+  auto budgeted_cfg = cfg;
+  budgeted_cfg.max_memory = 1;
+  CHECK(PairNames(sniff::FindReverseComplementPairs(
+            budgeted_cfg, make_store(0, 24),
+            std::make_shared<sniff::RunState>(15, 5, false))) == one_shot);
+}
@@ -0,0 +1,85 @@
+#include "sniff/best_pairs.h"
+
+#include <thread>
+
+#include "catch2/catch_test_macros.hpp"
+
+static auto MakeOverlap(std::uint32_t query_id, std::uint32_t target_id,
+                        double score) -> sniff::Overlap {
+  return sniff::Overlap{
+      .query_id = query_id, .target_id = target_id, .score = score};
+}
+
+TEST_CASE("best-pairs-update", "[best-pairs]") {
+  auto best_pairs = sniff::BestPairs(4);
+
+  auto const ovlp_01 = MakeOverlap(0, 1, 0.7);
+  auto const ovlp_12 = MakeOverlap(1, 2, 0.9);
+  auto const ovlp_23 = MakeOverlap(2, 3, 0.8);
+
+  CHECK(best_pairs.Update(ovlp_01));
+  CHECK(best_pairs.IsBest(ovlp_01));
+
+  CHECK(best_pairs.Update(ovlp_12));
+  CHECK(best_pairs.IsBest(ovlp_12));
+  CHECK_FALSE(best_pairs.IsBest(ovlp_01));
+
+  // read 2 already has a better partner
+  CHECK_FALSE(best_pairs.Update(ovlp_23));
+  CHECK_FALSE(best_pairs.IsBest(ovlp_23));
+  CHECK(best_pairs.IsBest(ovlp_12));
+
+  // both still hold the best partner of one of their reads
+  CHECK(best_pairs.IsBestOfEither(ovlp_23));
+  CHECK(best_pairs.IsBestOfEither(ovlp_01));
+  CHECK_FALSE(best_pairs.IsBestOfEither(MakeOverlap(0, 3, 0.5)));
+
+  // a lower score never replaces a higher one
+  CHECK_FALSE(best_pairs.Update(MakeOverlap(0, 1, 0.6)));
+}
+
+TEST_CASE("best-pairs-tie", "[best-pairs]") {
+  auto best_pairs = sniff::BestPairs(3);
+
+  auto const ovlp_01 = MakeOverlap(0, 1, 0.8);
+  auto const ovlp_02 = MakeOverlap(0, 2, 0.8);
+
+  CHECK(best_pairs.Update(ovlp_02));
+  CHECK_FALSE(best_pairs.Update(ovlp_01));
+
+  // ties go to the larger partner id regardless of the update order
+  CHECK(best_pairs.IsBest(ovlp_02));
+  CHECK_FALSE(best_pairs.IsBest(ovlp_01));
+}
+
+TEST_CASE("best-pairs-concurrent", "[best-pairs]") {
+  auto constexpr kNumReads = 1'000U;
+  auto constexpr kNumThreads = 4U;
+
+  // pairs (i, i + d) score lower the further apart the reads are, except that
+  // pairs (2k, 2k + 1) score the highest
+  auto const score = [](std::uint32_t i, std::uint32_t d) -> double {
+    return d == 1 && i % 2 == 0 ? 0.99 : 0.9 - d / 16.;
+  };
+
+  auto best_pairs = sniff::BestPairs(kNumReads);
+  auto threads = std::vector<std::thread>();
+  for (std::uint32_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&best_pairs, &score, t] {
+      for (std::uint32_t d = 1; d <= 8; ++d) {
+        for (std::uint32_t i = t; i + d < kNumReads; i += kNumThreads) {
+          best_pairs.Update(MakeOverlap(i, i + d, score(i, d)));
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (std::uint32_t i = 0; i + 1 < kNumReads; ++i) {
+    CHECK(best_pairs.IsBest(MakeOverlap(i, i + 1, score(i, 1))) ==
+          (i % 2 == 0));
+  }
+}
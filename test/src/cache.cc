@@ -0,0 +1,194 @@
+#include "sniff/cache.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+
+static constexpr auto kKey = sniff::CacheKey{.kmer_len = 15,
+                                             .window_len = 5,
+                                             .canonical = false,
+                                             .input_size = 1'000,
+                                             .input_mtime = 42};
+
+static auto MakeMinimizers(std::uint32_t seed) -> sniff::StrandMinimizers {
+  auto dst = sniff::StrandMinimizers();
+  for (std::uint32_t i = 0; i < 3 + seed; ++i) {
+    dst.forward.push_back(sniff::KMer{.position = i, .value = seed * 100 + i});
+    dst.reverse_complement.push_back(
+        sniff::KMer{.position = i, .value = seed * 100 + 50 + i});
+  }
+
+  return dst;
+}
+
+// Counts in which value 7 was seen 20 times among 100 distinct ones.
+static auto MakeFrequentKMers() -> std::unique_ptr<sniff::FrequentKMers> {
+  auto kmers = std::vector<sniff::KMer>(20, sniff::KMer{.value = 7});
+  for (std::uint64_t value = 100; value < 200; ++value) {
+    kmers.push_back(sniff::KMer{.value = value});
+  }
+
+  auto dst = std::make_unique<sniff::FrequentKMers>(kmers.size());
+  dst->Add(kmers);
+  dst->Finish(0.01);
+  return dst;
+}
+
+// Writes a cache of three reads with one index over reads [1, 3).
+static auto WriteCache(std::filesystem::path const& path) -> void {
+  auto const lengths = std::vector<std::uint32_t>{100, 200, 300};
+  auto const names = std::vector<std::string_view>{"r0", "read1", "r2"};
+  auto const minimizers = std::vector<sniff::StrandMinimizers>{
+      MakeMinimizers(0), MakeMinimizers(1), MakeMinimizers(2)};
+
+  auto targets = std::vector<sniff::Target>();
+  for (std::uint32_t read_id = 1; read_id < 3; ++read_id) {
+    for (auto const kmer : minimizers[read_id].reverse_complement) {
+      targets.push_back(sniff::Target{.read_id = read_id, .kmer = kmer});
+    }
+  }
+
+  auto writer = sniff::SketchCacheWriter(path, kKey);
+  writer.WriteReads(lengths, names);
+  writer.WriteFrequentKMers(*MakeFrequentKMers());
+  writer.WriteMinimizers(0, std::span(minimizers).first(1));
+  writer.WriteMinimizers(1, std::span(minimizers).subspan(1));
+  writer.WriteIndex(1, 3, sniff::CreateIndex(targets));
+  writer.Finish();
+}
+
+TEST_CASE("cache-round-trip", "[cache]") {
+  auto const path = std::filesystem::temp_directory_path() /
+                    "sniff-cache-round-trip.bin";
+  WriteCache(path);
+
+  auto const cache = sniff::SketchCache::Open(path, kKey);
+  REQUIRE(cache);
+  REQUIRE(cache->size() == 3);
+  CHECK(cache->NumSketched() == 3);
+  CHECK(std::vector(cache->Lengths().begin(), cache->Lengths().end()) ==
+        std::vector<std::uint32_t>{100, 200, 300});
+  CHECK(cache->Name(0) == "r0");
+  CHECK(cache->Name(1) == "read1");
+  CHECK(cache->Name(2) == "r2");
+
+  for (std::uint32_t read_id = 0; read_id < 3; ++read_id) {
+    auto const expected = MakeMinimizers(read_id);
+    auto const forward = cache->Forward(read_id);
+    auto const reverse_complement = cache->ReverseComplement(read_id);
+    CHECK(std::vector(forward.begin(), forward.end()) == expected.forward);
+    CHECK(std::vector(reverse_complement.begin(), reverse_complement.end()) ==
+          expected.reverse_complement);
+  }
+
+  CHECK_FALSE(cache->FindIndex(0, 3));
+  auto const index = cache->FindIndex(1, 3);
+  REQUIRE(index);
+  auto const found = sniff::FindTargets(*index, 251);
+  REQUIRE(found.size() == 1);
+  CHECK(found[0].read_id == 2);
+  CHECK(found[0].kmer.position == 1);
+  CHECK(sniff::FindTargets(*index, 50).empty());
+
+  auto const frequent = MakeFrequentKMers();
+  CHECK(cache->Frequent().Threshold() == frequent->Threshold());
+  CHECK(cache->Frequent().IsFrequent(7));
+  CHECK(cache->Frequent().Cells() == frequent->Cells());
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("cache-rejected", "[cache]") {
+  auto const path =
+      std::filesystem::temp_directory_path() / "sniff-cache-rejected.bin";
+  std::filesystem::remove(path);
+
+  SECTION("missing") { CHECK_FALSE(sniff::SketchCache::Open(path, kKey)); }
+
+  SECTION("other-key") {
+    WriteCache(path);
+    auto key = kKey;
+    key.window_len = 7;
+    CHECK_FALSE(sniff::SketchCache::Open(path, key));
+    key = kKey;
+    key.input_mtime = 43;
+    CHECK_FALSE(sniff::SketchCache::Open(path, key));
+  }
+
+  SECTION("truncated") {
+    WriteCache(path);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    CHECK_FALSE(sniff::SketchCache::Open(path, kKey));
+  }
+
+  SECTION("corrupted-index") {
+    auto const lengths = std::vector<std::uint32_t>{100, 200};
+    auto const names = std::vector<std::string_view>{"r0", "r1"};
+    auto const targets = std::vector<sniff::Target>{
+        sniff::Target{.read_id = 0, .kmer = sniff::KMer{.value = 7}},
+        sniff::Target{.read_id = 1, .kmer = sniff::KMer{.value = 9}}};
+    auto buckets = std::vector<std::uint32_t>{0, 1, 2};
+    auto entries = std::vector<sniff::IndexEntry>{
+        {.offset = 0}, {.offset = 1}, {.offset = 2}};
+
+    auto const write = [&]() -> void {
+      auto writer = sniff::SketchCacheWriter(path, kKey);
+      writer.WriteReads(lengths, names);
+      writer.WriteFrequentKMers(*MakeFrequentKMers());
+      writer.WriteIndex(0, 2,
+                        sniff::Index{.bucket_bits = 1,
+                                     .buckets = buckets,
+                                     .entries = entries,
+                                     .targets = targets});
+      writer.Finish();
+    };
+
+    write();
+    REQUIRE(sniff::SketchCache::Open(path, kKey));
+
+    // bucket count does not match the bucket bits
+    buckets.push_back(2);
+    write();
+    CHECK_FALSE(sniff::SketchCache::Open(path, kKey));
+    buckets.pop_back();
+
+    // buckets point past the last entry
+    buckets.back() = 3;
+    write();
+    CHECK_FALSE(sniff::SketchCache::Open(path, kKey));
+    buckets.back() = 2;
+
+    // entries point past the targets
+    entries[1].offset = 5;
+    write();
+    CHECK_FALSE(sniff::SketchCache::Open(path, kKey));
+    entries[1].offset = 1;
+
+    // the last entry does not end the targets
+    entries.back().offset = 1;
+    write();
+    CHECK_FALSE(sniff::SketchCache::Open(path, kKey));
+  }
+
+  SECTION("uncounted") {
+    auto writer = sniff::SketchCacheWriter(path, kKey);
+    writer.WriteReads(std::vector<std::uint32_t>{100},
+                      std::vector<std::string_view>{"r0"});
+    CHECK_THROWS(writer.Finish());
+  }
+
+  SECTION("unfinished") {
+    // an abandoned writer leaves nothing behind
+    {
+      auto writer = sniff::SketchCacheWriter(path, kKey);
+      writer.WriteReads(std::vector<std::uint32_t>{100},
+                        std::vector<std::string_view>{"r0"});
+    }
+    CHECK_FALSE(std::filesystem::exists(path));
+    CHECK_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+  }
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,136 @@
+#include "sniff/frequency.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+// 1000 k-mers seen once, ten seen 50 times and one seen 500 times.
+static auto MakeKMers() -> std::vector<sniff::KMer> {
+  auto dst = std::vector<sniff::KMer>();
+  for (std::uint64_t value = 0; value < 1'000; ++value) {
+    dst.push_back(sniff::KMer{.value = value});
+  }
+  for (std::uint64_t value = 1'000; value < 1'010; ++value) {
+    dst.insert(dst.end(), 50, sniff::KMer{.value = value});
+  }
+  dst.insert(dst.end(), 500, sniff::KMer{.value = 7'777});
+
+  return dst;
+}
+
+TEST_CASE("frequency-count", "[frequency]") {
+  auto const kmers = MakeKMers();
+  auto frequent = sniff::FrequentKMers(kmers.size());
+  frequent.Add(kmers);
+
+  CHECK(frequent.Count(7'777) >= 500);
+  CHECK(frequent.Count(1'005) >= 50);
+  CHECK(frequent.Count(3) >= 1);
+  CHECK_FALSE(frequent.IsFrequent(7'777));
+
+  frequent.Finish(0.01);
+  CHECK(frequent.Threshold() >= 2);
+  CHECK(frequent.Threshold() <= 50);
+  CHECK(frequent.IsFrequent(7'777));
+  CHECK(frequent.IsFrequent(1'005));
+}
+
+TEST_CASE("frequency-order", "[frequency]") {
+  auto kmers = MakeKMers();
+  auto first = sniff::FrequentKMers(kmers.size());
+  first.Add(kmers);
+  first.Finish(0.005);
+
+  std::shuffle(kmers.begin(), kmers.end(), std::mt19937(42));
+  auto second = sniff::FrequentKMers(kmers.size());
+  for (std::size_t i = 0; i < kmers.size(); i += 97) {
+    second.Add(std::span(kmers).subspan(i, std::min<std::size_t>(
+                                               97, kmers.size() - i)));
+  }
+  second.Finish(0.005);
+
+  CHECK(first.Threshold() == second.Threshold());
+  for (auto const& kmer : kmers) {
+    CHECK(first.Count(kmer.value) == second.Count(kmer.value));
+  }
+}
+
+TEST_CASE("frequency-minimum", "[frequency]") {
+  auto kmers = std::vector<sniff::KMer>();
+  for (std::uint64_t value = 0; value < 100; ++value) {
+    kmers.push_back(sniff::KMer{.value = value});
+  }
+
+  auto frequent = sniff::FrequentKMers(kmers.size());
+  frequent.Add(kmers);
+  frequent.Finish(0.5);
+
+  CHECK(frequent.Threshold() >= 2);
+  CHECK_FALSE(frequent.IsFrequent(42));
+}
+
+TEST_CASE("frequency-fold", "[frequency]") {
+  auto const kmers = MakeKMers();
+  auto small = sniff::FrequentKMers(kmers.size());
+  auto large = sniff::FrequentKMers(std::uint64_t(1) << 24U);
+  REQUIRE(large.BlockBits() > small.BlockBits());
+  small.Add(kmers);
+  large.Add(kmers);
+  small.Finish(0.005);
+  large.Finish(0.005);
+
+  CHECK(large.BlockBits() == small.BlockBits());
+  CHECK(large.Cells() == small.Cells());
+  CHECK(large.Threshold() == small.Threshold());
+}
+
+TEST_CASE("frequency-merge", "[frequency]") {
+  auto const kmers = MakeKMers();
+  auto whole = sniff::FrequentKMers(kmers.size());
+  whole.Add(kmers);
+  whole.Finish(0.005);
+
+  // the first half is finished and restored as run states keep it
+  auto first = sniff::FrequentKMers(kmers.size());
+  first.Add(std::span(kmers).first(kmers.size() / 2));
+  first.Finish(0.005);
+  auto const cells = first.Cells();
+  auto const restored = sniff::FrequentKMers(sniff::FrequentKMerCounts{
+      .block_bits = first.BlockBits(),
+      .threshold = first.Threshold(),
+      .n_kmers = first.NumKMers(),
+      .cells = cells,
+      .sample_level = first.SampleLevel(),
+      .sample = first.Sample()});
+  CHECK(restored.Cells() == cells);
+  CHECK(restored.Threshold() == first.Threshold());
+
+  auto second = sniff::FrequentKMers(std::uint64_t(1) << 24U);
+  second.Add(std::span(kmers).subspan(kmers.size() / 2));
+  second.Add(restored);
+  second.Finish(0.005);
+
+  CHECK(second.NumKMers() == kmers.size());
+  CHECK(second.Cells() == whole.Cells());
+  CHECK(second.Threshold() == whole.Threshold());
+}
+
+TEST_CASE("frequency-invalid", "[frequency]") {
+  auto const cells = std::vector<std::uint16_t>(100);
+  auto const counts = sniff::FrequentKMerCounts{
+      .block_bits = 10, .threshold = 2, .n_kmers = 0, .cells = cells};
+  CHECK_FALSE(sniff::FrequentKMers::IsValid(counts));
+  CHECK_THROWS(sniff::FrequentKMers(counts));
+
+  auto const sized_cells = std::vector<std::uint16_t>((1U << 10U) * 32U);
+  auto const unsorted = std::vector<std::uint64_t>{7, 3};
+  auto const unsorted_counts =
+      sniff::FrequentKMerCounts{.block_bits = 10,
+                                .threshold = 2,
+                                .n_kmers = 0,
+                                .cells = sized_cells,
+                                .sample = unsorted};
+  CHECK_FALSE(sniff::FrequentKMers::IsValid(unsorted_counts));
+}
@@ -0,0 +1,147 @@
+#include "sniff/gzip.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+static auto MakeText(std::size_t n_lines) -> std::string {
+  auto dst = std::string();
+  for (std::size_t i = 0; i < n_lines; ++i) {
+    dst += ">read" + std::to_string(i) + "\nACGTTGCA" + std::to_string(i * i) +
+           "\n";
+  }
+
+  return dst;
+}
+
+// Deflates src into a gzip member; with bgzf set, the header carries the
+// member size like BGZF blocks do.
+static auto Compress(std::string const& src, bool bgzf = false)
+    -> std::string {
+  auto stream = z_stream{};
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+               Z_DEFAULT_STRATEGY);
+
+  auto deflated = std::string(deflateBound(&stream, src.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src.data()));
+  stream.avail_in = src.size();
+  stream.next_out = reinterpret_cast<Bytef*>(deflated.data());
+  stream.avail_out = deflated.size();
+  deflate(&stream, Z_FINISH);
+  deflated.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  auto append_u16 = [](std::uint32_t value, std::string* dst) -> void {
+    dst->push_back(static_cast<char>(value & 0xffU));
+    dst->push_back(static_cast<char>(value >> 8U));
+  };
+
+  auto dst = std::string("\x1f\x8b\x08", 3);
+  dst.push_back(bgzf ? '\x04' : '\x00');
+  dst.append(4, '\0');
+  dst += std::string("\x00\xff", 2);
+  if (bgzf) {
+    append_u16(6, &dst);
+    dst += "BC";
+    append_u16(2, &dst);
+    append_u16(18 + deflated.size() + 8 - 1, &dst);
+  }
+  dst += deflated;
+
+  auto const crc = crc32(0, reinterpret_cast<Bytef const*>(src.data()),
+                         src.size());
+  append_u16(crc & 0xffffU, &dst);
+  append_u16(crc >> 16U, &dst);
+  append_u16(src.size() & 0xffffU, &dst);
+  append_u16(src.size() >> 16U, &dst);
+
+  return dst;
+}
+
+static auto Concatenate(std::vector<std::string> const& texts, bool bgzf,
+                        std::vector<std::size_t>* starts) -> std::string {
+  auto dst = std::string();
+  for (auto const& text : texts) {
+    starts->push_back(dst.size());
+    dst += Compress(text, bgzf);
+  }
+  starts->push_back(dst.size());
+
+  return dst;
+}
+
+TEST_CASE("gzip-members", "[gzip]") {
+  auto const texts =
+      std::vector<std::string>{MakeText(1'000), MakeText(10), MakeText(3'000)};
+
+  for (auto const bgzf : {false, true}) {
+    auto starts = std::vector<std::size_t>();
+    auto const data = Concatenate(texts, bgzf, &starts);
+    auto const bytes = std::span<char const>(data);
+
+    CHECK(sniff::IsGzipHeader(bytes));
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+      CHECK(sniff::FindNextGzipMember(bytes, starts[i]) == starts[i + 1]);
+
+      auto inflated = std::string("prefix");
+      REQUIRE(sniff::InflateGzipMember(
+          bytes.subspan(starts[i], starts[i + 1] - starts[i]), &inflated));
+      CHECK(inflated == "prefix" + texts[i]);
+    }
+  }
+}
+
+TEST_CASE("gzip-members-incomplete", "[gzip]") {
+  auto starts = std::vector<std::size_t>();
+  auto const data =
+      Concatenate({MakeText(1'000), MakeText(10)}, false, &starts);
+  auto const bytes = std::span<char const>(data);
+
+  // two members, a truncated one and one without its header
+  auto inflated = std::string("prefix");
+  CHECK_FALSE(sniff::InflateGzipMember(bytes, &inflated));
+  CHECK_FALSE(sniff::InflateGzipMember(bytes.subspan(0, starts[1] - 1),
+                                       &inflated));
+  CHECK_FALSE(sniff::InflateGzipMember(bytes.subspan(1, starts[1] - 1),
+                                       &inflated));
+  CHECK(inflated == "prefix");
+}
+
+TEST_CASE("gzip-stream", "[gzip]") {
+  auto const texts = std::vector<std::string>{MakeText(2'000), MakeText(1)};
+  auto starts = std::vector<std::size_t>();
+  auto const data = Concatenate(texts, false, &starts) + std::string(20, '\0');
+
+  for (auto const piece_size : {std::size_t(7), std::size_t(1U << 16U)}) {
+    auto stream = sniff::GzipStream();
+    auto inflated = std::string();
+    auto n_members = std::size_t(0);
+    for (std::size_t offset = 0; offset < data.size();) {
+      auto const piece = std::span<char const>(data).subspan(
+          offset, std::min(piece_size, data.size() - offset));
+      offset += stream.Inflate(piece, &inflated);
+      if (!stream.IsInMember() && !stream.IsFinished()) {
+        ++n_members;
+      }
+    }
+
+    CHECK(inflated == texts[0] + texts[1]);
+    CHECK(n_members == texts.size());
+    CHECK(stream.IsFinished());
+  }
+}
+
+TEST_CASE("gzip-stream-invalid", "[gzip]") {
+  auto data = Compress(MakeText(100));
+  data[data.size() / 2] ^= 0x55;
+
+  auto stream = sniff::GzipStream();
+  auto inflated = std::string();
+  CHECK_THROWS(stream.Inflate(data, &inflated));
+}
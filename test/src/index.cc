@@ -0,0 +1,87 @@
+#include "sniff/index.h"
+
+#include <algorithm>
+#include <random>
+
+#include "catch2/catch_test_macros.hpp"
+
+static auto CmpTargetByReadPos(sniff::Target const& lhs,
+                               sniff::Target const& rhs) -> bool {
+  return lhs.read_id != rhs.read_id ? lhs.read_id < rhs.read_id
+                                    : lhs.kmer.position < rhs.kmer.position;
+}
+
+TEST_CASE("index-find-targets", "[index]") {
+  auto const targets = std::vector<sniff::Target>{
+      sniff::Target{.read_id = 0, .kmer = {.position = 0, .value = 42}},
+      sniff::Target{.read_id = 0, .kmer = {.position = 5, .value = 7}},
+      sniff::Target{.read_id = 1, .kmer = {.position = 3, .value = 42}},
+      sniff::Target{.read_id = 2, .kmer = {.position = 9, .value = 1}},
+      sniff::Target{.read_id = 2, .kmer = {.position = 11, .value = 42}},
+  };
+
+  auto const index = sniff::CreateIndex(targets);
+  REQUIRE(index.targets.size() == targets.size());
+  REQUIRE(index.entries.size() == 4);  // three minimizers and a sentinel
+
+  SECTION("repeated-minimizer") {
+    auto found = std::vector<sniff::Target>(
+        sniff::FindTargets(index, 42).begin(),
+        sniff::FindTargets(index, 42).end());
+    std::sort(found.begin(), found.end(), CmpTargetByReadPos);
+
+    REQUIRE(found.size() == 3);
+    CHECK(found[0].read_id == 0);
+    CHECK(found[0].kmer.position == 0);
+    CHECK(found[1].read_id == 1);
+    CHECK(found[2].read_id == 2);
+    CHECK(found[2].kmer.position == 11);
+  }
+
+  SECTION("unique-minimizer") {
+    auto const found = sniff::FindTargets(index, 7);
+    REQUIRE(found.size() == 1);
+    CHECK(found[0].read_id == 0);
+    CHECK(found[0].kmer.position == 5);
+  }
+
+  SECTION("missing-minimizer") {
+    CHECK(sniff::FindTargets(index, 0).empty());
+    CHECK(sniff::FindTargets(index, 43).empty());
+  }
+}
+
+TEST_CASE("index-empty", "[index]") {
+  auto const index = sniff::CreateIndex({});
+  CHECK(index.entries.size() == 1);
+  CHECK(sniff::FindTargets(index, 42).empty());
+}
+
+TEST_CASE("index-counts-match-input", "[index]") {
+  // spans multiple partitioning chunks
+  auto constexpr kNumTargets = std::uint32_t(200'000);
+  auto constexpr kNumValues = std::uint64_t(50'000);
+
+  auto rng_engine = std::mt19937{42};
+  auto targets = std::vector<sniff::Target>();
+  auto expected = std::vector<std::uint32_t>(kNumValues + 100, 0);
+  for (std::uint32_t i = 0; i < kNumTargets; ++i) {
+    auto const value = rng_engine() % kNumValues;
+    targets.push_back(
+        sniff::Target{.read_id = i, .kmer = {.position = i, .value = value}});
+    ++expected[value];
+  }
+
+  auto const index = sniff::CreateIndex(targets);
+  for (std::uint64_t value = 0; value < expected.size(); ++value) {
+    auto const found = sniff::FindTargets(index, value);
+
+    REQUIRE(found.size() == expected[value]);
+    REQUIRE(std::all_of(found.begin(), found.end(),
+                        [value](sniff::Target const& target) {
+                          return target.kmer.value == value;
+                        }));
+    // postings keep the input order
+    REQUIRE(std::is_sorted(found.begin(), found.end(), CmpTargetByReadPos));
+  }
+}
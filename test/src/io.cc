@@ -0,0 +1,191 @@
+#include "sniff/io.h"
+
+#include <zlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+struct Record {
+  std::string name;
+  std::string data;
+};
+
+// Enough reads to span several chunks of the loader.
+static auto MakeRecords() -> std::vector<Record> {
+  auto rng = std::mt19937(42);
+  auto len = std::uniform_int_distribution<std::uint32_t>(1, 40'000);
+  auto base = std::uniform_int_distribution<std::uint32_t>(0, 3);
+
+  auto dst = std::vector<Record>(600);
+  for (std::size_t i = 0; i < dst.size(); ++i) {
+    dst[i].name = "read" + std::to_string(i);
+    dst[i].data.resize(len(rng));
+    for (auto& c : dst[i].data) {
+      c = "ACGT"[base(rng)];
+    }
+  }
+
+  return dst;
+}
+
+// Fasta with wrapped sequence lines and comments after names, or fastq whose
+// quality lines start with '@'.
+static auto Format(std::vector<Record> const& records, bool is_fastq)
+    -> std::string {
+  auto dst = std::string();
+  for (auto const& record : records) {
+    if (is_fastq) {
+      dst += "@" + record.name + " comment\n" + record.data + "\n+\n" +
+             std::string(record.data.size(), '@') + "\n";
+      continue;
+    }
+
+    dst += ">" + record.name + " comment\n";
+    for (std::size_t i = 0; i < record.data.size(); i += 80) {
+      dst += record.data.substr(i, 80) + "\n";
+    }
+  }
+
+  return dst;
+}
+
+// Gzip members of at most member_size input bytes each; with bgzf set they
+// are written as BGZF blocks.
+static auto Compress(std::string const& src, std::size_t member_size,
+                     bool bgzf) -> std::string {
+  auto dst = std::string();
+  for (std::size_t offset = 0; offset < src.size(); offset += member_size) {
+    auto const member = src.substr(offset, member_size);
+
+    auto stream = z_stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                 Z_DEFAULT_STRATEGY);
+    auto header = gz_header{};
+    auto extra = std::string("BC\x02\x00\x00\x00", 6);
+    if (bgzf) {
+      header.extra = reinterpret_cast<Bytef*>(extra.data());
+      header.extra_len = extra.size();
+      deflateSetHeader(&stream, &header);
+    }
+
+    auto deflated = std::string(deflateBound(&stream, member.size()) + 64, 0);
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(member.data()));
+    stream.avail_in = member.size();
+    stream.next_out = reinterpret_cast<Bytef*>(deflated.data());
+    stream.avail_out = deflated.size();
+    deflate(&stream, Z_FINISH);
+    deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (bgzf) {
+      auto const block_size = deflated.size() - 1;
+      deflated[16] = static_cast<char>(block_size & 0xffU);
+      deflated[17] = static_cast<char>(block_size >> 8U);
+    }
+    dst += deflated;
+  }
+
+  return dst;
+}
+
+static auto CheckReads(std::vector<Record> const& records,
+                       sniff::ReadStore const& reads) -> void {
+  REQUIRE(reads.size() == records.size());
+  CHECK(reads.FirstId() == 0);
+  for (std::uint32_t i = 0; i < reads.size(); ++i) {
+    CHECK(reads.Name(i) == records[i].name);
+    CHECK(reads.Length(i) == records[i].data.size());
+    CHECK(reads.InflateData(i) == records[i].data);
+  }
+}
+
+TEST_CASE("io-load-reads", "[io]") {
+  auto const records = MakeRecords();
+  auto const dir = std::filesystem::temp_directory_path();
+
+  auto check = [&records](std::filesystem::path const& path,
+                          std::string const& content) -> void {
+    std::ofstream(path, std::ios::binary) << content;
+    CheckReads(records, sniff::LoadReads(path));
+    std::filesystem::remove(path);
+  };
+
+  auto const fasta = Format(records, false);
+  auto const fastq = Format(records, true);
+
+  SECTION("plain") {
+    check(dir / "sniff-io.fasta", fasta);
+    check(dir / "sniff-io.fastq", fastq);
+  }
+
+  SECTION("gzip") {
+    check(dir / "sniff-io.fa.gz", Compress(fasta, fasta.size(), false));
+    check(dir / "sniff-io.fastq.gz", Compress(fastq, 1U << 20U, false));
+  }
+
+  SECTION("gzip-trailing-garbage") {
+    check(dir / "sniff-io.fa.gz",
+          Compress(fasta, 1U << 18U, false) + std::string(64, '\0'));
+  }
+
+  SECTION("bgzf") {
+    check(dir / "sniff-io.fa.gz", Compress(fasta, 65'280, true));
+    check(dir / "sniff-io.fq.gz", Compress(fastq, 65'280, true));
+  }
+}
+
+TEST_CASE("io-locate-reads", "[io]") {
+  auto const records = MakeRecords();
+  auto const path = std::filesystem::temp_directory_path() / "sniff-io.fq.gz";
+  std::ofstream(path, std::ios::binary)
+      << Compress(Format(records, true), 1U << 20U, false);
+
+  // gzipped input is only located through an inflated copy
+  CHECK_THROWS(sniff::LocateReads(path));
+  auto input = std::make_unique<sniff::SeekableInput>(path);
+  auto const input_path = input->Path();
+  REQUIRE(input_path != path);
+  CHECK(input_path.filename().string().ends_with(".fq"));
+
+  auto const locations = sniff::LocateReads(input_path);
+  REQUIRE(locations.size() == records.size());
+
+  // loaded in the order of the locations and appended after existing reads
+  auto const subset = std::vector<sniff::ReadLocation>{
+      locations[500], locations[3], locations[599]};
+  auto reads = sniff::ReadStore();
+  reads.Append("r", "A");
+  sniff::LoadReads(input_path, subset, &reads);
+
+  REQUIRE(reads.size() == 4);
+  CHECK(reads.Name(1) == records[500].name);
+  CHECK(reads.InflateData(1) == records[500].data);
+  CHECK(reads.Name(2) == records[3].name);
+  CHECK(reads.InflateData(2) == records[3].data);
+  CHECK(reads.Name(3) == records[599].name);
+  CHECK(reads.InflateData(3) == records[599].data);
+
+  input.reset();
+  CHECK_FALSE(std::filesystem::exists(input_path));
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("io-load-reads-truncated", "[io]") {
+  auto const records = MakeRecords();
+  auto const path = std::filesystem::temp_directory_path() / "sniff-io.fa.gz";
+
+  auto const compressed = Compress(Format(records, false), 1U << 20U, false);
+  std::ofstream(path, std::ios::binary)
+      << compressed.substr(0, compressed.size() - 100);
+
+  CHECK_THROWS(sniff::LoadReads(path));
+  CHECK_THROWS(sniff::SeekableInput(path));
+  std::filesystem::remove(path);
+}
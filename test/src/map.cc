@@ -39,16 +39,9 @@ TEST_CASE("map-one-overlap", "[map][overlap]") {
   }
 }
 
-TEST_CASE("map-two-overlaps", "[map][overlap]") {
-  constexpr auto kExpectedOverlaps =
-      std::array<sniff::Overlap, 2>{sniff::Overlap{.query_start = 0,
-                                                   .query_end = 14,
-                                                   .target_start = 1,
-                                                   .target_end = 12},
-                                    sniff::Overlap{.query_start = 113,
-                                                   .query_end = 127,
-                                                   .target_start = 108,
-                                                   .target_end = 127}};
+TEST_CASE("map-best-of-two-chains", "[map][overlap]") {
+  constexpr auto kExpectedOverlap = sniff::Overlap{
+      .query_start = 0, .query_end = 14, .target_start = 1, .target_end = 12};
 
   auto rng_engine = std::mt19937{42};
   auto matches = std::vector<sniff::Match>{
@@ -56,6 +49,7 @@ TEST_CASE("map-two-overlaps", "[map][overlap]") {
       sniff::Match{.query_pos = 4, .target_pos = 5},
       sniff::Match{.query_pos = 9, .target_pos = 7},
 
+      // more than max_chain_gap_length away from the first chain
       sniff::Match{.query_pos = 113, .target_pos = 108},
       sniff::Match{.query_pos = 115, .target_pos = 118},
       sniff::Match{.query_pos = 122, .target_pos = 122},
@@ -64,5 +58,42 @@ TEST_CASE("map-two-overlaps", "[map][overlap]") {
   std::shuffle(matches.begin(), matches.end(), rng_engine);
   auto const overlaps = sniff::Map(kMapCfg, matches);
 
-  REQUIRE(overlaps.size() == kExpectedOverlaps.size());
+  REQUIRE(overlaps.size() == 1);
+  CHECK(overlaps[0] == kExpectedOverlap);
+}
+
+TEST_CASE("map-short-chain", "[map][overlap]") {
+  // query positions decrease along the target; no two matches chain
+  auto const matches = std::vector<sniff::Match>{
+      sniff::Match{.query_pos = 30, .target_pos = 0},
+      sniff::Match{.query_pos = 20, .target_pos = 10},
+      sniff::Match{.query_pos = 10, .target_pos = 20},
+  };
+
+  CHECK(sniff::Map(kMapCfg, matches).empty());
+  CHECK(sniff::Map({.min_chain_length = 1, .kmer_len = 5}, matches).size() ==
+        1);
+}
+
+TEST_CASE("map-reused-buffers", "[map][overlap]") {
+  auto rng_engine = std::mt19937{42};
+  auto matches = std::vector<sniff::Match>();
+  for (std::uint32_t i = 0; i < 200; ++i) {
+    matches.push_back(sniff::Match{
+        .query_pos = static_cast<std::uint32_t>(10 * i + rng_engine() % 5),
+        .target_pos = static_cast<std::uint32_t>(7 * i + rng_engine() % 3)});
+  }
+
+  auto buffers = sniff::MapBuffers();
+  auto overlaps = std::vector<sniff::Overlap>();
+  sniff::Map(kMapCfg, matches, &buffers, &overlaps);
+
+  auto const head = std::span(matches).first(5);
+  sniff::Map(kMapCfg, head, &buffers, &overlaps);
+
+  auto expected = sniff::Map(kMapCfg, matches);
+  auto const expected_head = sniff::Map(kMapCfg, head);
+  expected.insert(expected.end(), expected_head.begin(), expected_head.end());
+
+  CHECK(overlaps == expected);
 }
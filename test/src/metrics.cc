@@ -0,0 +1,82 @@
+#include "sniff/metrics.h"
+
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+TEST_CASE("metrics-counters", "[metrics]") {
+  auto metrics = sniff::Metrics();
+
+  auto threads = std::vector<std::thread>();
+  for (auto i = 0; i < 4; ++i) {
+    threads.emplace_back([&metrics]() -> void {
+      for (auto j = 0; j < 1'000; ++j) {
+        metrics.Add(sniff::Counter::kHits, 2);
+      }
+      metrics.Add(sniff::Counter::kChains, 1);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto const totals = metrics.Totals();
+  CHECK(totals[static_cast<std::size_t>(sniff::Counter::kHits)] == 8'000);
+  CHECK(totals[static_cast<std::size_t>(sniff::Counter::kChains)] == 4);
+  CHECK(totals[static_cast<std::size_t>(sniff::Counter::kReads)] == 0);
+}
+
+TEST_CASE("metrics-stage-timer", "[metrics]") {
+  auto metrics = sniff::Metrics();
+  {
+    auto const stage_timer =
+        sniff::StageTimer(&metrics, sniff::Stage::kIndex);
+    auto const bytes = std::vector<char>(1U << 20U);
+    CHECK(bytes.size() == (1U << 20U));
+  }
+  metrics.AddBatch(sniff::BatchMetrics{.first_query = 0,
+                                       .first_target = 3,
+                                       .last = 7,
+                                       .index_targets = 11,
+                                       .threshold = 5});
+
+  auto const json = metrics.ToJson();
+  CHECK(json.find("\"index\": {\"calls\": 1,") != std::string::npos);
+  CHECK(json.find("\"lookup\": {\"calls\": 0,") != std::string::npos);
+  CHECK(json.find("\"first_target\": 3, \"last\": 7, \"index_targets\": 11") !=
+        std::string::npos);
+
+  // null metrics are not touched
+  auto const stage_timer = sniff::StageTimer(nullptr, sniff::Stage::kLoad);
+}
+
+static thread_local std::uint64_t allocated_bytes = 0;
+
+TEST_CASE("metrics-allocated-bytes", "[metrics]") {
+  // nothing is counted without a counter
+  {
+    auto metrics = sniff::Metrics();
+    {
+      auto const stage_timer =
+          sniff::StageTimer(&metrics, sniff::Stage::kSort);
+    }
+    CHECK(metrics.ToJson().find("\"sort\": {\"calls\": 1,") !=
+          std::string::npos);
+    CHECK(metrics.ToJson().find("\"bytes_allocated\": null") !=
+          std::string::npos);
+  }
+
+  sniff::SetAllocationCounter(
+      []() -> std::uint64_t { return allocated_bytes; });
+  auto metrics = sniff::Metrics();
+  {
+    auto const stage_timer = sniff::StageTimer(&metrics, sniff::Stage::kSort);
+    allocated_bytes += 4'096;
+  }
+  auto const json = metrics.ToJson();
+  sniff::SetAllocationCounter(nullptr);
+
+  CHECK(json.find("\"sort\": {\"calls\": 1,") != std::string::npos);
+  CHECK(json.find("\"bytes_allocated\": 4096") != std::string::npos);
+}
@@ -1,9 +1,16 @@
 #include "sniff/minimize.h"
 
+#include <algorithm>
 #include <array>
+#include <random>
+#include <string>
+#include <vector>
 
+#include "biosoup/nucleic_acid.hpp"
 #include "catch2/catch_test_macros.hpp"
 
+std::atomic<std::uint32_t> biosoup::NucleicAcid::num_objects = 0;
+
 static constexpr auto kTestSequence =
     std::string_view{"GCGTGCCATAACCACCATATTCGACGATTCAAC"};
 
@@ -53,3 +60,316 @@ TEST_CASE("minimizeK5W7", "[minimize]") {
     CHECK(kTestExpectedMinimizersK5W7[i] == minimizers[i]);
   }
 }
+
+static auto EncodeKMer(std::string_view kmer) -> std::uint64_t {
+  auto dst = std::uint64_t(0);
+  for (auto const base : kmer) {
+    dst = (dst << 2ULL) | std::string_view("ACGT").find(base);
+  }
+
+  return dst;
+}
+
+static auto ReverseComplement(std::string_view sequence) -> std::string {
+  auto dst = std::string(sequence.rbegin(), sequence.rend());
+  for (auto& base : dst) {
+    base = "TGCA"[std::string_view("ACGT").find(base)];
+  }
+
+  return dst;
+}
+
+TEST_CASE("minimizeCanonicalK5W7", "[minimize][canonical]") {
+  auto const minimizers = sniff::Minimize(
+      {.kmer_len = 5, .window_len = 7, .canonical = true}, kTestSequence);
+  REQUIRE_FALSE(minimizers.empty());
+  for (auto const& kmer : minimizers) {
+    auto const fwd = kTestSequence.substr(kmer.position, 5);
+    auto const fwd_val = EncodeKMer(fwd);
+    auto const rc_val = EncodeKMer(ReverseComplement(fwd));
+
+    CHECK(kmer.value == std::min(fwd_val, rc_val));
+    CHECK(kmer.strand == (rc_val < fwd_val));
+  }
+}
+
+TEST_CASE("minimizeCanonicalStrandSymmetry", "[minimize][canonical]") {
+  auto const cfg = sniff::MinimizeConfig{
+      .kmer_len = 7, .window_len = 3, .canonical = true};
+  auto const fwd = sniff::Minimize(cfg, kTestSequence);
+  auto const rc = sniff::Minimize(cfg, ReverseComplement(kTestSequence));
+
+  auto n_mirrored = std::size_t(0);
+  for (auto const& kmer : rc) {
+    auto const mirrored_pos = kTestSequence.size() - 7 - kmer.position;
+    n_mirrored += std::count_if(
+        fwd.begin(), fwd.end(), [&kmer, mirrored_pos](sniff::KMer const& it) {
+          return it.position == mirrored_pos && it.value == kmer.value &&
+                 it.strand != kmer.strand;
+        });
+  }
+
+  // both strands select the same k-mers up to the sequence ends
+  CHECK(n_mirrored + 2 >= std::max(fwd.size(), rc.size()));
+}
+
+static auto ReferenceHash(std::uint64_t val, std::uint64_t mask)
+    -> std::uint64_t {
+  val = ((~val) + (val << 21)) & mask;
+  val = val ^ (val >> 24);
+  val = ((val + (val << 3)) + (val << 8)) & mask;
+  val = val ^ (val >> 14);
+  val = ((val + (val << 2)) + (val << 4)) & mask;
+  val = val ^ (val >> 28);
+  val = (val + (val << 31)) & mask;
+  return val;
+}
+
+// Leftmost minimum by hash over each run of window_len consecutive k-mers,
+// leaving out the last k-mer of the sequence, with repeats collapsed.
+static auto ReferenceMinimize(std::uint32_t kmer_len, std::uint32_t window_len,
+                              std::string_view sequence)
+    -> std::vector<sniff::KMer> {
+  auto dst = std::vector<sniff::KMer>();
+  if (sequence.size() < kmer_len + window_len) {
+    return dst;
+  }
+
+  auto const mask = (1ULL << (2ULL * kmer_len)) - 1ULL;
+  auto kmers = std::vector<sniff::KMer>();
+  for (std::uint32_t pos = 0; pos + kmer_len <= sequence.size(); ++pos) {
+    kmers.push_back(sniff::KMer{
+        .position = pos, .value = EncodeKMer(sequence.substr(pos, kmer_len))});
+  }
+
+  for (std::size_t first = 0; first + window_len < kmers.size(); ++first) {
+    auto const last = kmers.begin() + first + window_len;
+    auto const min = std::min_element(
+        kmers.begin() + first, last,
+        [mask](sniff::KMer const& lhs, sniff::KMer const& rhs) {
+          return ReferenceHash(lhs.value, mask) <
+                 ReferenceHash(rhs.value, mask);
+        });
+    if (dst.empty() || dst.back() != *min) {
+      dst.push_back(*min);
+    }
+  }
+
+  return dst;
+}
+
+TEST_CASE("minimizeMatchesReference", "[minimize]") {
+  auto rng_engine = std::mt19937{42};
+  auto sequence = std::string(2000, 'A');
+  for (auto& base : sequence) {
+    base = "ACGT"[rng_engine() % 4];
+  }
+  // low complexity stretch to exercise equal hashes inside a window
+  std::fill_n(sequence.begin() + 700, 300, 'A');
+
+  for (auto const& [kmer_len, window_len] :
+       {std::pair{15U, 5U}, std::pair{7U, 7U}, std::pair{5U, 7U},
+        std::pair{21U, 11U}, std::pair{31U, 1U}}) {
+    auto const minimizers = sniff::Minimize(
+        {.kmer_len = kmer_len, .window_len = window_len}, sequence);
+    auto const expected = ReferenceMinimize(kmer_len, window_len, sequence);
+
+    REQUIRE(minimizers.size() == expected.size());
+    CHECK(std::equal(minimizers.begin(), minimizers.end(), expected.begin()));
+  }
+}
+
+TEST_CASE("minimizeNonAsciiBytes", "[minimize]") {
+  // bytes past 0x7f code like any other byte which is not a nucleotide
+  auto with_other = std::string(kTestSequence);
+  auto with_high = std::string(kTestSequence);
+  with_other[10] = with_other[20] = '#';
+  with_high[10] = static_cast<char>(0xc3);
+  with_high[20] = static_cast<char>(0xff);
+
+  auto const cfg = sniff::MinimizeConfig{.kmer_len = 5, .window_len = 3};
+  CHECK(sniff::Minimize(cfg, with_high) == sniff::Minimize(cfg, with_other));
+}
+
+TEST_CASE("minimizePackedRead", "[minimize]") {
+  auto const read = biosoup::NucleicAcid("read", std::string(kTestSequence));
+
+  SECTION("matches-minimized-strings") {
+    for (auto const& [kmer_len, window_len] :
+         {std::pair{15U, 5U}, std::pair{7U, 7U}, std::pair{5U, 7U}}) {
+      auto const cfg =
+          sniff::MinimizeConfig{.kmer_len = kmer_len, .window_len = window_len};
+      auto const minimizers = sniff::Minimize(cfg, read);
+
+      CHECK(minimizers.forward == sniff::Minimize(cfg, kTestSequence));
+      CHECK(minimizers.reverse_complement ==
+            sniff::Minimize(cfg, ReverseComplement(kTestSequence)));
+    }
+  }
+
+  SECTION("canonical-reverse-complement-is-mirrored") {
+    auto const cfg = sniff::MinimizeConfig{
+        .kmer_len = 5, .window_len = 7, .canonical = true};
+    auto const minimizers = sniff::Minimize(cfg, read);
+
+    CHECK(minimizers.forward == sniff::Minimize(cfg, kTestSequence));
+    REQUIRE(minimizers.reverse_complement.size() ==
+            minimizers.forward.size());
+    for (std::size_t i = 0; i < minimizers.forward.size(); ++i) {
+      auto const& fwd = minimizers.forward[i];
+      auto const& rc = minimizers.reverse_complement[
+          minimizers.forward.size() - 1 - i];
+      CHECK(rc.position == kTestSequence.size() - 5 - fwd.position);
+      CHECK(rc.value == fwd.value);
+      CHECK(rc.strand != fwd.strand);
+    }
+  }
+}
+
+static auto RandomSequence(std::uint32_t len) -> std::string {
+  auto rng_engine = std::mt19937{7};
+  auto dst = std::string(len, 'A');
+  for (auto& base : dst) {
+    base = "ACGT"[rng_engine() % 4];
+  }
+
+  return dst;
+}
+
+// K-mers whose leftmost smallest s-mer by hash sits at one of offsets.
+static auto ReferenceSyncmers(std::uint32_t kmer_len, std::uint32_t smer_len,
+                              std::vector<std::uint32_t> const& offsets,
+                              std::string_view sequence)
+    -> std::vector<sniff::KMer> {
+  auto const smer_mask = (1ULL << (2ULL * smer_len)) - 1ULL;
+  auto dst = std::vector<sniff::KMer>();
+  for (std::uint32_t pos = 0; pos + kmer_len <= sequence.size(); ++pos) {
+    auto min_offset = std::uint32_t(0);
+    auto min_hash = ~0ULL;
+    for (std::uint32_t i = 0; i + smer_len <= kmer_len; ++i) {
+      auto const hash = ReferenceHash(
+          EncodeKMer(sequence.substr(pos + i, smer_len)), smer_mask);
+      if (hash < min_hash) {
+        min_hash = hash;
+        min_offset = i;
+      }
+    }
+
+    if (std::find(offsets.begin(), offsets.end(), min_offset) !=
+        offsets.end()) {
+      dst.push_back(
+          sniff::KMer{.position = pos,
+                      .value = EncodeKMer(sequence.substr(pos, kmer_len))});
+    }
+  }
+
+  return dst;
+}
+
+TEST_CASE("syncmerMatchesReference", "[minimize][syncmer]") {
+  auto const sequence = RandomSequence(3000);
+  for (auto const& [kmer_len, smer_len] :
+       {std::pair{15U, 9U}, std::pair{15U, 10U}, std::pair{21U, 11U}}) {
+    auto const n_smers = kmer_len - smer_len + 1;
+    auto const open = sniff::Minimize({.kmer_len = kmer_len,
+                                       .seeding = sniff::Seeding::kOpenSyncmer,
+                                       .syncmer_len = smer_len},
+                                      sequence);
+    CHECK(open == ReferenceSyncmers(kmer_len, smer_len, {(n_smers - 1) / 2},
+                                    sequence));
+
+    auto const closed =
+        sniff::Minimize({.kmer_len = kmer_len,
+                         .seeding = sniff::Seeding::kClosedSyncmer,
+                         .syncmer_len = smer_len},
+                        sequence);
+    CHECK(closed == ReferenceSyncmers(kmer_len, smer_len, {0, n_smers - 1},
+                                      sequence));
+
+    // one in n_smers k-mers for open syncmers, two for closed ones
+    auto const n_kmers = static_cast<double>(sequence.size() - kmer_len + 1);
+    CHECK(open.size() / n_kmers < 1.5 / n_smers);
+    CHECK(closed.size() / n_kmers < 3. / n_smers);
+  }
+}
+
+TEST_CASE("syncmerPackedRead", "[minimize][syncmer]") {
+  auto const sequence = RandomSequence(500);
+  auto const read = biosoup::NucleicAcid("read", sequence);
+
+  SECTION("matches-minimized-strings") {
+    for (auto const seeding :
+         {sniff::Seeding::kOpenSyncmer, sniff::Seeding::kClosedSyncmer,
+          sniff::Seeding::kRandstrobe}) {
+      auto const cfg = sniff::MinimizeConfig{.seeding = seeding};
+      auto const seeds = sniff::Minimize(cfg, read);
+
+      CHECK(seeds.forward == sniff::Minimize(cfg, sequence));
+      CHECK(seeds.reverse_complement ==
+            sniff::Minimize(cfg, ReverseComplement(sequence)));
+    }
+  }
+
+  SECTION("canonical-reverse-complement-is-mirrored") {
+    auto const cfg =
+        sniff::MinimizeConfig{.canonical = true,
+                              .seeding = sniff::Seeding::kOpenSyncmer};
+    auto const seeds = sniff::Minimize(cfg, read);
+    auto const rc = sniff::Minimize(cfg, ReverseComplement(sequence));
+
+    // canonical s-mers and a middle offset select the same k-mers on both
+    // strands, up to ties between equal s-mer hashes
+    auto n_mirrored = std::size_t(0);
+    for (auto const& kmer : rc) {
+      n_mirrored += std::count(seeds.reverse_complement.begin(),
+                               seeds.reverse_complement.end(), kmer);
+    }
+    CHECK(n_mirrored + 2 >= rc.size());
+  }
+}
+
+TEST_CASE("randstrobe", "[minimize][randstrobe]") {
+  auto const sequence = RandomSequence(3000);
+  auto const cfg = sniff::MinimizeConfig{
+      .kmer_len = 15, .window_len = 5, .seeding = sniff::Seeding::kRandstrobe};
+  auto const strobes = sniff::Minimize(cfg, sequence);
+  auto closed_cfg = cfg;
+  closed_cfg.kmer_len = 8;
+  closed_cfg.seeding = sniff::Seeding::kClosedSyncmer;
+  closed_cfg.syncmer_len = 4;
+  auto const syncmers = sniff::Minimize(closed_cfg, sequence);
+
+  // strobes are closed syncmers of half the length; each one starts a seed
+  // but the ones which overlap the last syncmer, as their partners may not
+  REQUIRE(strobes.size() < syncmers.size());
+  for (std::size_t i = 0; i < strobes.size(); ++i) {
+    CHECK(strobes[i].position == syncmers[i].position);
+  }
+  CHECK(syncmers[strobes.size() - 1].position + 8 <=
+        syncmers.back().position);
+  CHECK(syncmers[strobes.size()].position + 8 > syncmers.back().position);
+
+  auto canonical_cfg = cfg;
+  canonical_cfg.canonical = true;
+  CHECK_THROWS(sniff::Minimize(canonical_cfg, sequence));
+  auto short_smer_cfg = cfg;
+  short_smer_cfg.syncmer_len = 1;
+  CHECK_THROWS(sniff::Minimize(short_smer_cfg, sequence));
+}
+
+TEST_CASE("seedingConfig", "[minimize]") {
+  CHECK(sniff::ParseSeeding("open-syncmer") == sniff::Seeding::kOpenSyncmer);
+  CHECK(sniff::ParseSeeding("randstrobe") == sniff::Seeding::kRandstrobe);
+  CHECK_THROWS(sniff::ParseSeeding("strobemer"));
+
+  CHECK_THROWS(sniff::Minimize({.kmer_len = 15,
+                                .seeding = sniff::Seeding::kClosedSyncmer,
+                                .syncmer_len = 15},
+                               kTestSequence));
+  CHECK(sniff::SeedDensity({.kmer_len = 15,
+                            .seeding = sniff::Seeding::kOpenSyncmer,
+                            .syncmer_len = 9}) == 1. / 7);
+  CHECK(sniff::SeedDensity({.kmer_len = 15,
+                            .seeding = sniff::Seeding::kRandstrobe,
+                            .syncmer_len = 9}) == 2. / 5);
+}
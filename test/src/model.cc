@@ -0,0 +1,180 @@
+#include "sniff/model.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+
+// two features; x <= 0.5 ? -1 : (y <= 0.25 ? 0.5 : 2), plus a constant tree
+static constexpr auto kTestModel = std::string_view{R"(tree
+version=v4
+num_class=1
+num_tree_per_iteration=1
+label_index=0
+max_feature_idx=1
+objective=binary sigmoid:1
+feature_names=x y
+feature_infos=[0:1] [0:1]
+tree_sizes=400 200
+
+Tree=0
+num_leaves=3
+num_cat=0
+split_feature=0 1
+split_gain=10 5
+threshold=0.5 0.25
+decision_type=2 10
+left_child=-1 -2
+right_child=1 -3
+leaf_value=-1 0.5 2
+leaf_weight=10 10 10
+leaf_count=10 10 10
+internal_value=0 1
+internal_weight=30 20
+internal_count=30 20
+is_linear=0
+shrinkage=1
+
+
+Tree=1
+num_leaves=1
+num_cat=0
+split_feature=
+split_gain=
+threshold=
+decision_type=
+left_child=
+right_child=
+leaf_value=0.25
+leaf_weight=
+leaf_count=
+internal_value=
+internal_weight=
+internal_count=
+is_linear=0
+shrinkage=1
+
+
+end of trees
+
+feature_importances:
+x=1
+y=1
+
+parameters:
+[boosting: gbdt]
+[objective: binary]
+end of parameters
+
+pandas_categorical:null
+)"};
+
+static auto Sigmoid(double val) -> double { return 1. / (1. + std::exp(-val)); }
+
+static auto ReplaceLine(std::string_view text, std::string_view line,
+                        std::string_view replacement) -> std::string {
+  auto dst = std::string(text);
+  dst.replace(dst.find(line), line.size(), replacement);
+  return dst;
+}
+
+TEST_CASE("model-parse", "[model]") {
+  auto const model = sniff::ParseModel(kTestModel);
+
+  CHECK(model.n_features == 2);
+  CHECK(model.sigmoid == 1.);
+  REQUIRE(model.trees.size() == 2);
+  CHECK(model.trees[0].split_feature.size() == 2);
+  CHECK(model.trees[0].leaf_value.size() == 3);
+  CHECK(model.trees[1].split_feature.empty());
+  CHECK(model.trees[1].leaf_value.size() == 1);
+}
+
+TEST_CASE("model-predict", "[model]") {
+  auto const model = sniff::ParseModel(kTestModel);
+  auto const nan = std::numeric_limits<double>::quiet_NaN();
+
+  // clang-format off
+  auto const features = std::vector<double>{
+      0.2, 0.9,
+      0.7, 0.1,
+      0.7, 0.9,
+      0.5, 0.3,
+      0.7, nan,  // missing y goes left
+  };
+  auto const expected = std::vector<double>{
+      Sigmoid(-0.75), Sigmoid(0.75), Sigmoid(2.25), Sigmoid(-0.75),
+      Sigmoid(0.75)};
+  // clang-format on
+
+  auto const probs = sniff::Predict(model, features);
+  REQUIRE(probs.size() == expected.size());
+  for (std::size_t idx = 0; idx < expected.size(); ++idx) {
+    CHECK(std::fabs(probs[idx] - expected[idx]) < 1e-12);
+  }
+
+  // rows span multiple evaluation blocks
+  auto many_features = std::vector<double>();
+  for (std::size_t idx = 0; idx < 1'000; ++idx) {
+    many_features.insert(many_features.end(), features.begin() + 2 * (idx % 5),
+                         features.begin() + 2 * (idx % 5 + 1));
+  }
+
+  auto const many_probs = sniff::Predict(model, many_features);
+  REQUIRE(many_probs.size() == 1'000);
+  for (std::size_t idx = 0; idx < many_probs.size(); ++idx) {
+    CHECK(std::fabs(many_probs[idx] - expected[idx % 5]) < 1e-12);
+  }
+}
+
+TEST_CASE("model-parse-errors", "[model]") {
+  CHECK_THROWS_AS(sniff::ParseModel(""), std::invalid_argument);
+  CHECK_THROWS_AS(
+      sniff::ParseModel(ReplaceLine(kTestModel, "objective=binary sigmoid:1",
+                                    "objective=regression")),
+      std::invalid_argument);
+  CHECK_THROWS_AS(sniff::ParseModel(ReplaceLine(kTestModel, "num_class=1",
+                                                "num_class=3")),
+                  std::invalid_argument);
+  CHECK_THROWS_AS(sniff::ParseModel(ReplaceLine(kTestModel, "decision_type=2",
+                                                "decision_type=1")),
+                  std::invalid_argument);
+  CHECK_THROWS_AS(sniff::ParseModel(ReplaceLine(kTestModel, "left_child=-1 -2",
+                                                "left_child=-1 -7")),
+                  std::invalid_argument);
+}
+
+TEST_CASE("model-filter-overlaps", "[model]") {
+  // query coverage above 0.9 is a true pair
+  auto const model = sniff::ParseModel(ReplaceLine(
+      ReplaceLine(
+          ReplaceLine(ReplaceLine(kTestModel, "max_feature_idx=1",
+                                  "max_feature_idx=5"),
+                      "threshold=0.5 0.25", "threshold=0.9 0.25"),
+          "leaf_value=0.25", "leaf_value=0"),
+      "leaf_value=-1 0.5 2", "leaf_value=-1 2 2"));
+
+  auto const make_overlap = [](std::string_view name, std::uint32_t query_end)
+      -> sniff::OverlapNamed {
+    return sniff::OverlapNamed{.query_name = name,
+                               .query_length = 1'000,
+                               .query_start = 0,
+                               .query_end = query_end,
+                               .target_length = 1'000,
+                               .target_start = 0,
+                               .target_end = 1'000};
+  };
+
+  auto const overlaps = sniff::FilterOverlaps(
+      model, {make_overlap("a", 950), make_overlap("b", 500),
+              make_overlap("c", 1'000)});
+
+  REQUIRE(overlaps.size() == 2);
+  CHECK(overlaps[0].query_name == "a");
+  CHECK(overlaps[1].query_name == "c");
+
+  CHECK_THROWS_AS(sniff::FilterOverlaps(sniff::ParseModel(kTestModel), {}),
+                  std::invalid_argument);
+}
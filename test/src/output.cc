@@ -0,0 +1,205 @@
+#include "sniff/output.h"
+
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+// Temporary file removed when it goes out of scope.
+class TempFile {
+ public:
+  TempFile() {
+    auto path = (std::filesystem::temp_directory_path() / "sniff-XXXXXX")
+                    .string();
+    fd_ = mkstemp(path.data());
+    if (fd_ == -1) {
+      throw std::runtime_error("failed to create a temporary file");
+    }
+    path_ = path;
+  }
+
+  TempFile(TempFile const&) = delete;
+  auto operator=(TempFile const&) -> TempFile& = delete;
+
+  ~TempFile() {
+    close(fd_);
+    std::filesystem::remove(path_);
+  }
+
+  auto fd() const -> int { return fd_; }
+  auto path() const -> std::filesystem::path const& { return path_; }
+
+ private:
+  int fd_;
+  std::filesystem::path path_;
+};
+
+static auto ReadFile(std::filesystem::path const& path) -> std::string {
+  auto file = std::ifstream(path, std::ios::binary);
+  auto buffer = std::stringstream();
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+static auto ReadGzFile(std::filesystem::path const& path) -> std::string {
+  auto file = gzopen(path.c_str(), "rb");
+  auto dst = std::string();
+  auto buffer = std::array<char, 1U << 16U>();
+  for (int len = 0; (len = gzread(file, buffer.data(), buffer.size())) > 0;) {
+    dst.append(buffer.data(), len);
+  }
+  gzclose(file);
+
+  return dst;
+}
+
+static auto ReadU32(std::string_view src, std::size_t offset) -> std::uint32_t {
+  auto dst = std::uint32_t(0);
+  for (auto i = 0U; i < 4U; ++i) {
+    dst |= static_cast<std::uint32_t>(
+               static_cast<std::uint8_t>(src[offset + i]))
+           << (8U * i);
+  }
+
+  return dst;
+}
+
+// Overlaps of n read pairs, named rI and rI_rc; the names point into names.
+static auto MakeOverlaps(std::size_t n, std::vector<std::string>* names)
+    -> std::vector<sniff::OverlapNamed> {
+  names->clear();
+  for (std::uint32_t i = 0; i < n; ++i) {
+    names->push_back("r" + std::to_string(i));
+    names->push_back("r" + std::to_string(i) + "_rc");
+  }
+
+  auto dst = std::vector<sniff::OverlapNamed>();
+  for (std::uint32_t i = 0; i < n; ++i) {
+    dst.push_back(sniff::OverlapNamed{.query_name = (*names)[2 * i],
+                                      .query_length = 1'000 + i,
+                                      .query_start = 10,
+                                      .query_end = 990,
+                                      .target_name = (*names)[2 * i + 1],
+                                      .target_length = 1'100,
+                                      .target_start = 20,
+                                      .target_end = 1'000});
+  }
+
+  return dst;
+}
+
+static auto FormatCsvReference(
+    std::span<sniff::OverlapNamed const> overlaps) -> std::string {
+  auto dst = std::string(
+      "query_name,query_length,query_start,"
+      "query_end,target_name,target_length,target_start,target_end\n");
+  for (auto const& ovlp : overlaps) {
+    dst += std::string(ovlp.query_name) + "," +
+           std::to_string(ovlp.query_length) + "," +
+           std::to_string(ovlp.query_start) + "," +
+           std::to_string(ovlp.query_end) + "," +
+           std::string(ovlp.target_name) + "," +
+           std::to_string(ovlp.target_length) + "," +
+           std::to_string(ovlp.target_start) + "," +
+           std::to_string(ovlp.target_end) + "\n";
+  }
+
+  return dst;
+}
+
+TEST_CASE("output-csv", "[output]") {
+  // spans several formatting chunks
+  auto name_storage = std::vector<std::string>();
+  auto const overlaps = MakeOverlaps(40'000, &name_storage);
+  auto const expected = FormatCsvReference(overlaps);
+
+  SECTION("plain") {
+    auto file = TempFile();
+    sniff::WriteOverlaps({.format = sniff::OutputFormat::kCsv}, overlaps,
+                         file.fd());
+    CHECK(ReadFile(file.path()) == expected);
+  }
+
+  SECTION("compressed") {
+    auto file = TempFile();
+    sniff::WriteOverlaps(
+        {.format = sniff::OutputFormat::kCsv, .compress = true}, overlaps,
+        file.fd());
+    CHECK(ReadGzFile(file.path()) == expected);
+  }
+
+  SECTION("empty") {
+    auto file = TempFile();
+    sniff::WriteOverlaps({.format = sniff::OutputFormat::kCsv}, {},
+                         file.fd());
+    CHECK(ReadFile(file.path()) == FormatCsvReference({}));
+  }
+}
+
+TEST_CASE("output-paf", "[output]") {
+  auto name_storage = std::vector<std::string>();
+  auto const overlaps = MakeOverlaps(1, &name_storage);
+
+  auto file = TempFile();
+  sniff::WriteOverlaps({.format = sniff::OutputFormat::kPaf}, overlaps,
+                       file.fd());
+
+  // target coordinates are flipped onto the forward target strand
+  CHECK(ReadFile(file.path()) ==
+        "r0\t1000\t10\t990\t-\tr0_rc\t1100\t100\t1080\t0\t980\t255\n");
+}
+
+TEST_CASE("output-binary", "[output]") {
+  auto name_storage = std::vector<std::string>();
+  auto const overlaps = MakeOverlaps(3, &name_storage);
+
+  auto file = TempFile();
+  sniff::WriteOverlaps({.format = sniff::OutputFormat::kBinary}, overlaps,
+                       file.fd());
+  auto const data = ReadFile(file.path());
+
+  REQUIRE(data.substr(0, 8) == "SNIFFOVL");
+  CHECK(ReadU32(data, 8) == 1);
+  CHECK(ReadU32(data, 12) == 32);
+  REQUIRE(ReadU32(data, 16) == 6);
+  CHECK(ReadU32(data, 20) == 0);
+  REQUIRE(ReadU32(data, 24) == 3);
+  CHECK(ReadU32(data, 28) == 0);
+
+  auto names = std::vector<std::string>();
+  auto offset = std::size_t(32);
+  for (std::size_t i = 0; i < 6; ++i) {
+    auto const len = ReadU32(data, offset);
+    names.push_back(data.substr(offset + 4, len));
+    offset += 4 + len;
+  }
+  CHECK(names == std::vector<std::string>{"r0", "r0_rc", "r1", "r1_rc", "r2",
+                                          "r2_rc"});
+
+  REQUIRE(data.size() == offset + 3 * 32);
+  for (std::size_t i = 0; i < overlaps.size(); ++i, offset += 32) {
+    CHECK(names[ReadU32(data, offset)] == overlaps[i].query_name);
+    CHECK(ReadU32(data, offset + 4) == overlaps[i].query_length);
+    CHECK(ReadU32(data, offset + 8) == overlaps[i].query_start);
+    CHECK(ReadU32(data, offset + 12) == overlaps[i].query_end);
+    CHECK(names[ReadU32(data, offset + 16)] == overlaps[i].target_name);
+    CHECK(ReadU32(data, offset + 20) == overlaps[i].target_length);
+    CHECK(ReadU32(data, offset + 24) == overlaps[i].target_start);
+    CHECK(ReadU32(data, offset + 28) == overlaps[i].target_end);
+  }
+}
+
+TEST_CASE("output-parse-format", "[output]") {
+  CHECK(sniff::ParseOutputFormat("csv") == sniff::OutputFormat::kCsv);
+  CHECK(sniff::ParseOutputFormat("paf") == sniff::OutputFormat::kPaf);
+  CHECK(sniff::ParseOutputFormat("binary") == sniff::OutputFormat::kBinary);
+  CHECK_THROWS_AS(sniff::ParseOutputFormat("sam"), std::invalid_argument);
+}
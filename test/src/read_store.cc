@@ -0,0 +1,88 @@
+#include "sniff/read_store.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "biosoup/nucleic_acid.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+static auto InflateSequence(sniff::ReadStore const& store,
+                            std::uint32_t read_id) -> std::string {
+  auto const words = store.Sequence(read_id);
+  auto dst = std::string();
+  for (std::uint32_t i = 0; i < store.Length(read_id); ++i) {
+    dst += "ACGT"[(words[i >> 5U] >> ((i & 31U) << 1U)) & 3U];
+  }
+
+  return dst;
+}
+
+TEST_CASE("read-store-append", "[read-store]") {
+  auto const reads = std::vector<biosoup::NucleicAcid>{
+      biosoup::NucleicAcid("r0", "ACGT"),
+      biosoup::NucleicAcid("read1", std::string(70, 'G') + "TTAC"),
+      biosoup::NucleicAcid("r2", "CATTAG"),
+  };
+
+  auto store = sniff::ReadStore(10);
+  for (auto const& read : reads) {
+    store.Append(read);
+  }
+
+  REQUIRE(store.size() == 3);
+  CHECK(store.FirstId() == 10);
+  CHECK(store.LastId() == 13);
+
+  for (std::uint32_t idx = 0; idx < reads.size(); ++idx) {
+    CHECK(store.Length(10 + idx) == reads[idx].inflated_len);
+    CHECK(store.Lengths()[idx] == reads[idx].inflated_len);
+    CHECK(store.Name(10 + idx) == reads[idx].name);
+    CHECK(store.Sequence(10 + idx).size() == reads[idx].deflated_data.size());
+    CHECK(InflateSequence(store, 10 + idx) == reads[idx].InflateData());
+  }
+}
+
+TEST_CASE("read-store-append-text", "[read-store]") {
+  auto store = sniff::ReadStore();
+  store.Append("r0", "acgtN");
+  store.Append("r1", std::string(65, 'T'));
+
+  auto const read = biosoup::NucleicAcid("r0", "acgtN");
+  CHECK(store.Length(0) == 5);
+  CHECK(store.Sequence(0).size() == read.deflated_data.size());
+  CHECK(store.InflateData(0) == read.InflateData());
+  CHECK(store.InflateData(1) == std::string(65, 'T'));
+  CHECK(InflateSequence(store, 1) == std::string(65, 'T'));
+
+  CHECK_THROWS_AS(store.Append("r2", "AC!GT"), std::invalid_argument);
+}
+
+TEST_CASE("read-store-permute", "[read-store]") {
+  auto store = sniff::ReadStore(5);
+  store.Append("r0", "ACGT");
+  store.Append("r1", std::string(40, 'G'));
+
+  auto other = sniff::ReadStore();
+  other.Append("r2", "CATTAG");
+  store.Append(other);
+
+  REQUIRE(store.size() == 3);
+  CHECK(store.Name(7) == "r2");
+  CHECK(store.InflateData(7) == "CATTAG");
+
+  auto const order = std::vector<std::uint32_t>{7, 5, 6};
+  auto permuted = store.Permute(order);
+  REQUIRE(permuted.size() == 3);
+  CHECK(permuted.FirstId() == 5);
+  for (std::uint32_t idx = 0; idx < order.size(); ++idx) {
+    CHECK(permuted.Name(5 + idx) == store.Name(order[idx]));
+    CHECK(permuted.Length(5 + idx) == store.Length(order[idx]));
+    CHECK(permuted.InflateData(5 + idx) == store.InflateData(order[idx]));
+  }
+
+  permuted.ReleaseSequences();
+  CHECK(permuted.Name(6) == "r0");
+  CHECK(permuted.Length(6) == 4);
+  CHECK(permuted.Sequence(6).empty());
+}
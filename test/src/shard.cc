@@ -0,0 +1,91 @@
+#include "sniff/shard.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+static auto MakeOverlap(std::uint32_t query_id, std::uint32_t target_id,
+                        double score) -> sniff::Overlap {
+  return sniff::Overlap{.query_id = query_id,
+                        .query_length = 100 + query_id,
+                        .query_start = 1,
+                        .query_end = 99,
+                        .target_id = target_id,
+                        .target_length = 100 + target_id,
+                        .target_start = 2,
+                        .target_end = 98,
+                        .score = score};
+}
+
+static auto MakeShard(std::uint32_t shard_index,
+                      std::vector<sniff::Overlap> overlaps)
+    -> sniff::ShardCandidates {
+  auto dst = sniff::ShardCandidates{.shard_index = shard_index,
+                                    .n_shards = 2,
+                                    .n_reads = 6,
+                                    .overlaps = std::move(overlaps)};
+  for (std::uint32_t read_id = 0; read_id < 6; ++read_id) {
+    dst.names.emplace_back(read_id, "read" + std::to_string(read_id));
+  }
+
+  return dst;
+}
+
+TEST_CASE("shard-write-read", "[shard]") {
+  auto const shard =
+      MakeShard(1, {MakeOverlap(0, 1, 0.75), MakeOverlap(2, 5, 1. / 3)});
+  auto const path = std::filesystem::temp_directory_path() / "sniff-shard.bin";
+
+  auto const fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  REQUIRE(fd >= 0);
+  sniff::WriteShard(shard, fd);
+  close(fd);
+
+  auto const loaded = sniff::ReadShard(path);
+  CHECK(loaded.shard_index == 1);
+  CHECK(loaded.n_shards == 2);
+  CHECK(loaded.n_reads == 6);
+  CHECK(loaded.overlaps == shard.overlaps);
+  CHECK(loaded.names == shard.names);
+
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  CHECK_THROWS(sniff::ReadShard(path));
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("shard-merge", "[shard]") {
+  // (0, 1) is the best pair of both reads within the first shard, but read 1
+  // pairs up better with read 2 in the second one; (3, 4) holds the best
+  // partner of read 4 only and loses read 3 to (3, 5)
+  auto shards = std::vector<sniff::ShardCandidates>{
+      MakeShard(0, {MakeOverlap(0, 1, 0.8), MakeOverlap(3, 4, 0.9)}),
+      MakeShard(1, {MakeOverlap(1, 2, 0.85), MakeOverlap(3, 5, 0.95)})};
+
+  auto const merged = sniff::MergeShards(shards);
+  REQUIRE(merged.overlaps.size() == 2);
+  CHECK(merged.overlaps[0].query_name == "read1");
+  CHECK(merged.overlaps[0].target_name == "read2");
+  CHECK(merged.overlaps[0].query_length == 101);
+  CHECK(merged.overlaps[1].query_name == "read3");
+  CHECK(merged.overlaps[1].target_name == "read5");
+
+  SECTION("missing-shard") {
+    shards.pop_back();
+    CHECK_THROWS(sniff::MergeShards(shards));
+  }
+
+  SECTION("duplicate-shard") {
+    shards.back().shard_index = 0;
+    CHECK_THROWS(sniff::MergeShards(shards));
+  }
+
+  SECTION("different-runs") {
+    shards.back().n_reads = 7;
+    CHECK_THROWS(sniff::MergeShards(shards));
+  }
+}
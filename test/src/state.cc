@@ -0,0 +1,69 @@
+#include "sniff/state.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+TEST_CASE("state-append", "[state]") {
+  auto state = sniff::RunState(15, 5, true);
+  auto const kmers = std::vector<sniff::KMer>{
+      {.position = 3, .value = 42, .strand = 1},
+      {.position = 9, .value = (std::uint64_t(1) << 62U) + 7, .strand = 0}};
+
+  state.Append("first", 100, kmers);
+  state.Append("second", 7, {});
+
+  REQUIRE(state.size() == 2);
+  CHECK(state.Name(0) == "first");
+  CHECK(state.Name(1) == "second");
+  CHECK(state.Lengths()[0] == 100);
+  CHECK(state.Lengths()[1] == 7);
+  CHECK(std::vector(state.Minimizers(0).begin(), state.Minimizers(0).end()) ==
+        kmers);
+  CHECK(state.Minimizers(1).empty());
+}
+
+TEST_CASE("state-save-load", "[state]") {
+  auto const path = std::filesystem::temp_directory_path() / "sniff-state.bin";
+  std::filesystem::remove(path);
+  CHECK_FALSE(sniff::LoadRunState(path).has_value());
+
+  auto state =
+      sniff::RunState(17, 9, false, sniff::Seeding::kMinimizer, 9, 0.001);
+  auto const kmers = std::vector<sniff::KMer>{
+      {.position = 1, .value = 5, .strand = 1},
+      {.position = 80, .value = (std::uint64_t(1) << 62U) + 3, .strand = 0}};
+  state.Append("read0", 120, kmers);
+  state.Append("read1", 130, {});
+  state.SetCandidates({sniff::Overlap{.query_id = 0,
+                                      .query_length = 120,
+                                      .query_start = 3,
+                                      .query_end = 117,
+                                      .target_id = 1,
+                                      .target_length = 130,
+                                      .target_start = 5,
+                                      .target_end = 125,
+                                      .score = 0.875}});
+  sniff::SaveRunState(state, path);
+
+  auto const loaded = sniff::LoadRunState(path);
+  REQUIRE(loaded.has_value());
+  CHECK(loaded->KMerLength() == 17);
+  CHECK(loaded->WindowLength() == 9);
+  CHECK_FALSE(loaded->IsCanonical());
+  CHECK(loaded->FilterFrequency() == 0.001);
+  REQUIRE(loaded->size() == 2);
+  CHECK(loaded->Name(1) == "read1");
+  CHECK(loaded->Lengths()[1] == 130);
+  CHECK(std::vector(loaded->Minimizers(0).begin(),
+                    loaded->Minimizers(0).end()) == kmers);
+  CHECK(std::vector(loaded->Candidates().begin(),
+                    loaded->Candidates().end()) ==
+        std::vector(state.Candidates().begin(), state.Candidates().end()));
+
+  std::ofstream(path, std::ios::binary | std::ios::app) << "x";
+  CHECK_THROWS(sniff::LoadRunState(path));
+  std::filesystem::remove(path);
+}
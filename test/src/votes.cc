@@ -0,0 +1,67 @@
+#include "sniff/votes.h"
+
+#include "catch2/catch_test_macros.hpp"
+
+TEST_CASE("votes-count", "[votes]") {
+  auto votes = sniff::TargetVotes();
+
+  // enough targets to grow the table past its first size
+  for (std::uint32_t target_id = 0; target_id < 1'000; ++target_id) {
+    for (std::uint32_t i = 0; i <= target_id % 7; ++i) {
+      votes.Add(target_id * 31);
+    }
+  }
+
+  CHECK(votes.Votes(0) == 1);
+  CHECK(votes.Votes(6 * 31) == 7);
+  CHECK(votes.Votes(999 * 31) == 999 % 7 + 1);
+  CHECK(votes.Votes(5) == 0);
+
+  votes.Clear();
+  CHECK(votes.Votes(6 * 31) == 0);
+  votes.Add(6 * 31);
+  CHECK(votes.Votes(6 * 31) == 1);
+}
+
+TEST_CASE("votes-select", "[votes]") {
+  auto votes = sniff::TargetVotes();
+  auto const add = [&votes](std::uint32_t target_id, std::uint32_t n) {
+    for (std::uint32_t i = 0; i < n; ++i) {
+      votes.Add(target_id);
+    }
+  };
+  add(10, 100);
+  add(11, 30);
+  add(12, 30);
+  add(13, 10);
+  add(14, 3);
+
+  SECTION("min votes") {
+    CHECK(votes.Select(4, 0.0, 16) == 4);
+    CHECK(votes.IsSelected(13));
+    CHECK_FALSE(votes.IsSelected(14));
+    CHECK_FALSE(votes.IsSelected(99));
+    CHECK(votes.Votes(10) == 100);
+  }
+
+  SECTION("share of the best") {
+    CHECK(votes.Select(1, 0.25, 16) == 3);
+    CHECK(votes.IsSelected(12));
+    CHECK_FALSE(votes.IsSelected(13));
+  }
+
+  SECTION("top targets") {
+    // ties go to the smaller id
+    CHECK(votes.Select(1, 0.0, 2) == 2);
+    CHECK(votes.IsSelected(10));
+    CHECK(votes.IsSelected(11));
+    CHECK_FALSE(votes.IsSelected(12));
+  }
+
+  SECTION("cleared") {
+    votes.Select(1, 0.0, 16);
+    votes.Clear();
+    CHECK_FALSE(votes.IsSelected(10));
+    CHECK(votes.Select(1, 0.0, 16) == 0);
+  }
+}
@@ -4,6 +4,7 @@
 #include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 #include "ankerl/unordered_dense.h"
 #include "bindings/cpp/WFAligner.hpp"
@@ -16,9 +17,11 @@
 
 std::atomic<std::uint32_t> biosoup::NucleicAcid::num_objects = 0;
 
-using ReadMap =
-    ankerl::unordered_dense::map<std::string,
-                                 std::unique_ptr<biosoup::NucleicAcid>>;
+// Reads and their ids by name; names point into the store.
+struct ReadMap {
+  sniff::ReadStore store;
+  ankerl::unordered_dense::map<std::string_view, std::uint32_t> ids;
+};
 
 struct ReadPair {
   std::string lhs;
@@ -40,16 +43,15 @@ static auto CommaSplit(std::string const& src) -> std::vector<std::string> {
   return dst;
 }
 
-static auto LoadReads(std::filesystem::path const& reads_path) -> ReadMap {
-  auto dst = ReadMap();
-  auto reads = sniff::LoadReads(reads_path);
+static auto LoadReads(std::filesystem::path const& reads_path,
+                      ReadMap* dst) -> void {
+  dst->store = sniff::LoadReads(reads_path);
 
-  dst.reserve(reads.size());
-  for (auto& it : reads) {
-    dst[it->name] = std::move(it);
+  dst->ids.reserve(dst->store.size());
+  for (auto read_id = dst->store.FirstId(); read_id < dst->store.LastId();
+       ++read_id) {
+    dst->ids[dst->store.Name(read_id)] = read_id;
   }
-
-  return dst;
 }
 
 static auto LoadPairs(std::filesystem::path const& pairs_path)
@@ -65,11 +67,15 @@ static auto LoadPairs(std::filesystem::path const& pairs_path)
   return dst;
 }
 
-static auto CreateRcString(std::unique_ptr<biosoup::NucleicAcid> const& read)
-    -> std::string {
-  auto dst = std::string(read->InflateData());
+static auto CreateRcString(sniff::ReadStore const& reads,
+                           std::uint32_t read_id) -> std::string {
+  auto const words = reads.Sequence(read_id);
+  auto dst = std::string(reads.Length(read_id), '\0');
   for (auto i = 0U; i < dst.size(); ++i) {
-    dst[i] = biosoup::kNucleotideDecoder[3 ^ read->Code(dst.size() - 1 - i)];
+    auto const j = dst.size() - 1 - i;
+    dst[i] = biosoup::kNucleotideDecoder[3 ^ ((words[j >> 5U] >>
+                                               ((j & 31U) << 1U)) &
+                                              3U)];
   }
 
   return dst;
@@ -91,8 +97,8 @@ static auto CreatePairsWithEditRatio(ReadMap const& reads,
     }
 
     auto const [lhs_name, rhs_name] = pairs[idx];
-    auto lhs_str = reads.at(lhs_name)->InflateData();
-    auto rhs_str = CreateRcString(reads.at(rhs_name));
+    auto lhs_str = reads.store.InflateData(reads.ids.at(lhs_name));
+    auto rhs_str = CreateRcString(reads.store, reads.ids.at(rhs_name));
 
     aligner.alignEnd2End(lhs_str, rhs_str);
 
@@ -144,10 +150,11 @@ int main(int argc, char** argv) {
 
     auto ta = tbb::task_arena(result["threads"].as<std::uint32_t>());
     ta.execute([&]() -> void {
-      auto const reads = LoadReads(reads_path);
+      auto reads = ReadMap();
+      LoadReads(reads_path, &reads);
       auto const pairs = LoadPairs(pairs_path);
 
-      fmt::print(stderr, "loaded {} reads and {} pairs\n", reads.size(),
+      fmt::print(stderr, "loaded {} reads and {} pairs\n", reads.store.size(),
                  pairs.size());
 
       auto const pairs_with_ratio = CreatePairsWithEditRatio(reads, pairs);